@@ -1,5 +1,6 @@
 #include "../src/board_config.h"
 #include "HDMI.h"
+#include "hdmi_line.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -10,7 +11,9 @@
 #include "pico/multicore.h"
 #include "hardware/clocks.h"
 #include "hardware/irq.h"
+#include "hardware/sync.h"
 #include "hardware/structs/bus_ctrl.h"
+#include "hardware/structs/systick.h"
 
 // Globals expected by the driver
 int graphics_buffer_width = 320;
@@ -21,6 +24,61 @@ enum graphics_mode_t hdmi_graphics_mode = GRAPHICSMODE_DEFAULT;
 
 static uint8_t *graphics_buffer = NULL;
 
+// Move the HDMI DMA IRQ (and with it all line preparation) to core 1, leaving core 0
+// to the game. Core 1 must otherwise be unused (AUDIO_USE_CORE1=0, no sd_async core 1).
+#ifndef HDMI_USE_CORE1
+#define HDMI_USE_CORE1 0
+#endif
+
+// Core-1 stack in SCRATCH_X: the ISR only needs a few frames for memset/memcpy.
+#define HDMI_CORE1_STACK_WORDS 256
+
+// Guards the scanout state (buffer/geometry/page flip) and the telemetry between their
+// writers and the scanline ISR. With the ISR on core 0 masking interrupts is enough and
+// the ISR takes nothing; with HDMI_USE_CORE1 both sides take a hardware spin lock.
+#if HDMI_USE_CORE1
+static spin_lock_t *hdmi_scanout_lock = NULL;
+
+static inline uint32_t hdmi_scanout_lock_acquire(void) {
+    if (!hdmi_scanout_lock) return save_and_disable_interrupts();  // Core 1 not started yet
+    return spin_lock_blocking(hdmi_scanout_lock);
+}
+
+static inline void hdmi_scanout_lock_release(uint32_t irq_state) {
+    if (!hdmi_scanout_lock) {
+        restore_interrupts(irq_state);
+        return;
+    }
+    spin_unlock(hdmi_scanout_lock, irq_state);
+}
+
+// ISR side: interrupts are already masked at this priority.
+static inline void hdmi_isr_lock(void) {
+    spin_lock_unsafe_blocking(hdmi_scanout_lock);
+}
+
+static inline void hdmi_isr_unlock(void) {
+    spin_unlock_unsafe(hdmi_scanout_lock);
+}
+#else
+static inline uint32_t hdmi_scanout_lock_acquire(void) {
+    return save_and_disable_interrupts();
+}
+
+static inline void hdmi_scanout_lock_release(uint32_t irq_state) {
+    restore_interrupts(irq_state);
+}
+
+static inline void hdmi_isr_lock(void) {}
+static inline void hdmi_isr_unlock(void) {}
+#endif
+
+// Page flip: CPU draws into graphics_back_buffer, graphics_present() queues it and
+// vsync_handler() swaps it with graphics_buffer during vertical blanking.
+static uint8_t *graphics_back_buffer = NULL;
+static volatile bool graphics_flip_pending = false;
+static volatile uint32_t graphics_flip_count = 0;
+
 void graphics_set_buffer(uint8_t *buffer) {
     graphics_buffer = buffer;
 }
@@ -47,10 +105,47 @@ void graphics_set_shift(int x, int y) {
     graphics_buffer_shift_y = y;
 }
 
-uint8_t* get_line_buffer(int line) {
-    if (!graphics_buffer) return NULL;
-    if (line < 0 || line >= graphics_buffer_height) return NULL;
-    return graphics_buffer + line * graphics_buffer_width;
+void graphics_set_scanout(uint8_t *buffer, int w, int h, int shift_y) {
+    // The scanline ISR reads all of these; never let it see a half-updated set.
+    const uint32_t irq_state = hdmi_scanout_lock_acquire();
+    graphics_buffer = buffer;
+    graphics_buffer_width = w;
+    graphics_buffer_height = h;
+    graphics_buffer_shift_x = 0;
+    graphics_buffer_shift_y = shift_y;
+    graphics_back_buffer = NULL;
+    graphics_flip_pending = false;
+    hdmi_scanout_lock_release(irq_state);
+}
+
+void graphics_set_back_buffer(uint8_t *buffer) {
+    const uint32_t irq_state = hdmi_scanout_lock_acquire();
+    graphics_back_buffer = buffer;
+    graphics_flip_pending = false;
+    hdmi_scanout_lock_release(irq_state);
+}
+
+uint8_t* graphics_get_back_buffer(void) {
+    if (!graphics_back_buffer) return graphics_buffer;
+    // A queued but not yet shown frame is withdrawn and redrawn in place; that keeps
+    // the CPU off the buffer being scanned out without ever waiting for vsync.
+    const uint32_t irq_state = hdmi_scanout_lock_acquire();
+    graphics_flip_pending = false;
+    uint8_t *back = graphics_back_buffer;
+    hdmi_scanout_lock_release(irq_state);
+    return back;
+}
+
+void graphics_present(void) {
+    if (graphics_back_buffer) graphics_flip_pending = true;
+}
+
+bool graphics_get_flip_pending(void) {
+    return graphics_flip_pending;
+}
+
+uint32_t graphics_get_flip_count(void) {
+    return graphics_flip_count;
 }
 
 static struct video_mode_t video_mode[] = {
@@ -73,8 +168,28 @@ int get_video_mode() {
 // Forward declaration - actual implementation is after variable definitions
 static void vsync_swap_buffers(void);
 
+// Palette upload stats: entries TMDS-encoded in total and per video frame.
+static volatile uint32_t hdmi_pal_encode_count = 0;
+static volatile uint32_t hdmi_pal_encode_frame = 0;
+static volatile uint32_t hdmi_pal_encode_last_frame = 0;
+static volatile uint32_t hdmi_pal_encode_max_frame = 0;
+
 void vsync_handler() {
     vsync_swap_buffers();
+    hdmi_pal_encode_last_frame = hdmi_pal_encode_frame;
+    if (hdmi_pal_encode_frame > hdmi_pal_encode_max_frame) hdmi_pal_encode_max_frame = hdmi_pal_encode_frame;
+    hdmi_pal_encode_frame = 0;
+    if (graphics_flip_pending) {
+        hdmi_isr_lock();
+        if (graphics_flip_pending) {
+            uint8_t *shown = graphics_buffer;
+            graphics_buffer = graphics_back_buffer;
+            graphics_back_buffer = shown;
+            graphics_flip_pending = false;
+            graphics_flip_count++;
+        }
+        hdmi_isr_unlock();
+    }
 }
 
 // --- New HDMI Driver Code ---
@@ -95,6 +210,10 @@ static uint32_t palette_original[256];  // Original colors before fade
 static uint8_t g_hdmi_fade_level = 0;   // 0 = full brightness, 64 = full black
 static uint16_t g_hdmi_fade_rows = 0;   // Bitmask of rows to fade (0 = all rows)
 
+// Entries whose TMDS words in the back buffer match palette_original[] at the current
+// fade; re-setting such an entry to the same colour is skipped.
+static uint32_t palette_encoded[256 / 32];
+
 // Loading mode: skip PSRAM access in IRQ handler, just output sync signals
 // This prevents HDMI signal loss during heavy SD card/PSRAM operations
 static volatile bool g_hdmi_loading_mode = false;
@@ -107,8 +226,6 @@ bool graphics_get_loading_mode(void) {
     return g_hdmi_loading_mode;
 }
 
-// NOTE: HDMI uses indices 240..243 as service/control codes.
-// All other indices (including 244..255) are available for visible pixels.
 
 
 #define SCREEN_WIDTH (320)
@@ -178,8 +295,6 @@ static void vsync_swap_buffers(void) {
 
 //функции и константы HDMI
 
-#define BASE_HDMI_CTRL_INX (240)
-#define HDMI_CTRL_COUNT (4)
 //программа конвертации адреса
 
 uint16_t pio_program_instructions_conv_HDMI[] = {
@@ -218,60 +333,19 @@ static const struct pio_program program_PIO_HDMI = {
     .origin = -1,
 };
 
-static uint64_t get_ser_diff_data(const uint16_t dataR, const uint16_t dataG, const uint16_t dataB) {
-    uint64_t out64 = 0;
-    for (int i = 0; i < 10; i++) {
-        out64 <<= 6;
-        if (i == 5) out64 <<= 2;
-#ifdef PICO_PC
-        uint8_t bG = (dataR >> (9 - i)) & 1;
-        uint8_t bR = (dataG >> (9 - i)) & 1;
-#else
-        uint8_t bR = (dataR >> (9 - i)) & 1;
-        uint8_t bG = (dataG >> (9 - i)) & 1;
-#endif
-        uint8_t bB = (dataB >> (9 - i)) & 1;
 
-        bR |= (bR ^ 1) << 1;
-        bG |= (bG ^ 1) << 1;
-        bB |= (bB ^ 1) << 1;
 
-        if (HDMI_PIN_invert_diffpairs) {
-            bR ^= 0b11;
-            bG ^= 0b11;
-            bB ^= 0b11;
-        }
-        uint8_t d6;
-        if (HDMI_PIN_RGB_notBGR) {
-            d6 = (bR << 4) | (bG << 2) | (bB << 0);
-        }
-        else {
-            d6 = (bB << 4) | (bG << 2) | (bR << 0);
-        }
 
+// Per-channel serialized TMDS tables (see hdmi_tmds_build_tables), built on first use.
+static hdmi_tmds_tables_t tmds_ser;
+static bool tmds_ser_lut_ready = false;
 
-        out64 |= d6;
+static inline uint64_t tmds_ser_color(uint32_t color888) {
+    if (!tmds_ser_lut_ready) {
+        hdmi_tmds_build_tables(&tmds_ser);
+        tmds_ser_lut_ready = true;
     }
-    return out64;
-}
-
-//конвертор TMDS
-static uint tmds_encoder(const uint8_t d8) {
-    int s1 = 0;
-    for (int i = 0; i < 8; i++) s1 += (d8 & (1 << i)) ? 1 : 0;
-    bool is_xnor = false;
-    if ((s1 > 4) || ((s1 == 4) && ((d8 & 1) == 0))) is_xnor = true;
-    uint16_t d_out = d8 & 1;
-    uint16_t qi = d_out;
-    for (int i = 1; i < 8; i++) {
-        d_out |= ((qi << 1) ^ (d8 & (1 << i))) ^ (is_xnor << i);
-        qi = d_out & (1 << i);
-    }
-
-    if (is_xnor) d_out |= 1 << 9;
-    else d_out |= 1 << 8;
-
-    return d_out;
+    return hdmi_tmds_color(&tmds_ser, color888);
 }
 
 static void pio_set_x(PIO pio, const int sm, uint32_t v) {
@@ -296,13 +370,189 @@ uint32_t graphics_get_hdmi_underrun_count(void) {
     return hdmi_fifo_underrun_count;
 }
 
+// ISR load: SysTick (core-local, counts down at clk_sys) cycles spent in the HDMI
+// scanline ISR on each core. This is the video pipeline's share of a core, not the
+// core's total busy time (with HDMI_USE_CORE1 core 1 does nothing else).
+static volatile uint64_t hdmi_isr_cycles[2] = {0, 0};
+static volatile uint32_t hdmi_isr_core = 0;
+
+static void hdmi_systick_start(void) {
+    systick_hw->csr = 0;
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5;  // Enable, processor clock, no interrupt
+}
+
+uint64_t graphics_get_hdmi_isr_cycles(unsigned core) {
+    return (core < 2) ? hdmi_isr_cycles[core] : 0;
+}
+
+uint32_t graphics_get_hdmi_core(void) {
+    return hdmi_isr_core;
+}
+
+// SD activity, stamped by pop_fs_read so underruns can be matched to card reads.
+static volatile bool hdmi_io_busy = false;
+static volatile uint32_t hdmi_io_start_us = 0;
+static volatile uint32_t hdmi_io_count = 0;
+
+void graphics_note_io(bool busy) {
+    if (busy) {
+        hdmi_io_start_us = time_us_32();
+        hdmi_io_count++;
+    }
+    hdmi_io_busy = busy;
+}
+
+#if HDMI_TELEMETRY
+// Histogram of ISR duration in clk_sys cycles, 256-cycle buckets; the last one is overflow.
+#define HDMI_TEL_BUCKET_SHIFT 8
+#define HDMI_TEL_BUCKETS 32
+// One slot per scanline (h_total is 524, the counter wraps after 524).
+#define HDMI_TEL_LINES 528
+#define HDMI_TEL_UNDERRUN_LOG 16
+
+typedef struct {
+    uint32_t time_us;
+    uint32_t io_count;   // pop_fs_read calls so far
+    uint32_t io_age_us;  // Time since the last read started
+    uint16_t line;
+    uint8_t io_busy;     // A read was in progress
+    uint8_t pad;
+} hdmi_underrun_t;
+
+static volatile uint16_t hdmi_tel_line = 0;
+static uint32_t hdmi_tel_hist[HDMI_TEL_BUCKETS];
+static uint16_t hdmi_tel_line_max[HDMI_TEL_LINES];
+static volatile uint32_t hdmi_tel_worst = 0;
+static volatile uint16_t hdmi_tel_worst_line = 0;
+static volatile uint32_t hdmi_tel_worst_us = 0;
+static hdmi_underrun_t hdmi_tel_underruns[HDMI_TEL_UNDERRUN_LOG];
+static volatile uint32_t hdmi_tel_underrun_head = 0;
+
+static inline void hdmi_tel_record(uint32_t cycles) {
+    const uint32_t line = hdmi_tel_line;
+    uint32_t bucket = cycles >> HDMI_TEL_BUCKET_SHIFT;
+    if (bucket >= HDMI_TEL_BUCKETS) bucket = HDMI_TEL_BUCKETS - 1;
+    hdmi_tel_hist[bucket]++;
+    const uint16_t c16 = (cycles > 0xFFFFu) ? 0xFFFFu : (uint16_t)cycles;
+    if (line < HDMI_TEL_LINES && c16 > hdmi_tel_line_max[line]) hdmi_tel_line_max[line] = c16;
+    if (cycles > hdmi_tel_worst) {
+        hdmi_tel_worst = cycles;
+        hdmi_tel_worst_line = (uint16_t)line;
+        hdmi_tel_worst_us = time_us_32();
+    }
+}
+
+static inline void hdmi_tel_log_underrun(void) {
+    const uint32_t now = time_us_32();
+    hdmi_underrun_t *u = &hdmi_tel_underruns[hdmi_tel_underrun_head % HDMI_TEL_UNDERRUN_LOG];
+    u->time_us = now;
+    u->io_count = hdmi_io_count;
+    u->io_age_us = now - hdmi_io_start_us;
+    u->line = hdmi_tel_line;
+    u->io_busy = hdmi_io_busy ? 1 : 0;
+    hdmi_tel_underrun_head++;
+}
+
+uint32_t graphics_get_hdmi_worst_cycles(void) {
+    return hdmi_tel_worst;
+}
+
+void graphics_dump_hdmi_telemetry(bool reset) {
+    // Snapshot first so printing (slow over USB) sees a consistent view. The scanout
+    // lock also holds off the ISR when it runs on core 1.
+    static uint32_t hist[HDMI_TEL_BUCKETS];
+    uint32_t irq_state = hdmi_scanout_lock_acquire();
+    memcpy(hist, hdmi_tel_hist, sizeof(hist));
+    const uint32_t worst = hdmi_tel_worst;
+    const uint32_t worst_line = hdmi_tel_worst_line;
+    const uint32_t worst_us = hdmi_tel_worst_us;
+    const uint32_t head = hdmi_tel_underrun_head;
+    hdmi_scanout_lock_release(irq_state);
+
+    const uint32_t mhz = clock_get_hz(clk_sys) / 1000000u;
+    printf("HDMI telemetry @%lu MHz: irq=%lu underruns=%lu core=%lu sd_reads=%lu\n",
+        (unsigned long)mhz, (unsigned long)hdmi_irq_count, (unsigned long)hdmi_fifo_underrun_count,
+        (unsigned long)hdmi_isr_core, (unsigned long)hdmi_io_count);
+    printf("  worst ISR: %lu cycles (%lu us) on line %lu at t=%lu us\n",
+        (unsigned long)worst, (unsigned long)(mhz ? worst / mhz : 0),
+        (unsigned long)worst_line, (unsigned long)worst_us);
+
+    printf("  ISR cycles histogram (%u-cycle buckets):\n", 1u << HDMI_TEL_BUCKET_SHIFT);
+    for (int b = 0; b < HDMI_TEL_BUCKETS; b++) {
+        if (!hist[b]) continue;
+        if (b == HDMI_TEL_BUCKETS - 1) {
+            printf("    >=%5u: %lu\n", (unsigned)b << HDMI_TEL_BUCKET_SHIFT, (unsigned long)hist[b]);
+        } else {
+            printf("    %5u-%5u: %lu\n", (unsigned)b << HDMI_TEL_BUCKET_SHIFT,
+                (((unsigned)b + 1) << HDMI_TEL_BUCKET_SHIFT) - 1, (unsigned long)hist[b]);
+        }
+    }
+
+    // Eight slowest lines.
+    printf("  slowest lines:");
+    static uint8_t picked[HDMI_TEL_LINES];
+    memset(picked, 0, sizeof(picked));
+    for (int n = 0; n < 8; n++) {
+        int best = -1;
+        for (int l = 0; l < HDMI_TEL_LINES; l++) {
+            if (!picked[l] && hdmi_tel_line_max[l] && (best < 0 || hdmi_tel_line_max[l] > hdmi_tel_line_max[best])) best = l;
+        }
+        if (best < 0) break;
+        picked[best] = 1;
+        printf(" %d:%u", best, hdmi_tel_line_max[best]);
+    }
+    printf("\n");
+
+    const uint32_t n_log = (head < HDMI_TEL_UNDERRUN_LOG) ? head : HDMI_TEL_UNDERRUN_LOG;
+    printf("  underrun log (last %lu of %lu):\n", (unsigned long)n_log, (unsigned long)head);
+    for (uint32_t k = head - n_log; k != head; k++) {
+        const hdmi_underrun_t u = hdmi_tel_underruns[k % HDMI_TEL_UNDERRUN_LOG];
+        printf("    t=%lu us line=%u sd=%s read#%lu +%lu us\n",
+            (unsigned long)u.time_us, u.line, u.io_busy ? "busy" : "idle",
+            (unsigned long)u.io_count, (unsigned long)u.io_age_us);
+    }
+
+    if (reset) {
+        irq_state = hdmi_scanout_lock_acquire();
+        memset(hdmi_tel_hist, 0, sizeof(hdmi_tel_hist));
+        memset(hdmi_tel_line_max, 0, sizeof(hdmi_tel_line_max));
+        hdmi_tel_worst = 0;
+        hdmi_tel_worst_line = 0;
+        hdmi_tel_worst_us = 0;
+        hdmi_tel_underrun_head = 0;
+        hdmi_scanout_lock_release(irq_state);
+    }
+}
+#endif
+
+static inline void dma_handler_HDMI_line(void);
+
 static void dma_handler_HDMI() {
+    const uint32_t t0 = systick_hw->cvr;
+    dma_handler_HDMI_line();
+    const uint32_t cycles = (t0 - systick_hw->cvr) & 0x00FFFFFFu;
+    hdmi_isr_cycles[get_core_num()] += cycles;
+#if HDMI_TELEMETRY
+    hdmi_isr_lock();
+    hdmi_tel_record(cycles);
+    hdmi_isr_unlock();
+#endif
+}
+
+static inline void dma_handler_HDMI_line(void) {
     hdmi_irq_count++;
     
     // Check for PIO TX FIFO underrun (stall bit indicates FIFO was empty when PIO tried to pull)
     // If the FIFO is empty now and the PIO is stalled, we had an underrun
     if (pio_sm_is_tx_fifo_empty(PIO_VIDEO, SM_video)) {
         hdmi_fifo_underrun_count++;
+#if HDMI_TELEMETRY
+        hdmi_isr_lock();
+        hdmi_tel_log_underrun();
+        hdmi_isr_unlock();
+#endif
     }
     
     static uint32_t inx_buf_dma;
@@ -319,6 +569,9 @@ static void dma_handler_HDMI() {
     } else {
         ++line;
     }
+#if HDMI_TELEMETRY
+    hdmi_tel_line = (uint16_t)line;
+#endif
 
     if ((line & 1) == 0) return;
     inx_buf_dma++;
@@ -326,109 +579,27 @@ static void dma_handler_HDMI() {
     uint8_t* activ_buf = (uint8_t *)dma_lines[inx_buf_dma & 1];
 
     if (line < mode.h_width ) {
-        uint8_t* output_buffer = activ_buf + 72; //для выравнивания синхры;
+        uint8_t* output_buffer = activ_buf + HDMI_LINE_ACTIVE_OFFSET; //для выравнивания синхры;
         
         // LOADING MODE: Skip PSRAM access entirely, just output black with valid sync.
         // This prevents HDMI signal loss during heavy SD card/PSRAM operations.
         if (g_hdmi_loading_mode) {
             memset(output_buffer, 255, SCREEN_WIDTH);  // 255 = black
         } else {
-            int y = line >> 1;
-            //область изображения
-            uint8_t* input_buffer = get_line_buffer(y);
-            if (!input_buffer) {
-                // If no buffer, fill with black (255)
-                memset(output_buffer, 255, SCREEN_WIDTH);
-            } else {
-                switch (hdmi_graphics_mode) {
-                    case GRAPHICSMODE_DEFAULT:
-                        //заполняем пространство сверху и снизу графического буфера
-                        if (false || (graphics_buffer_shift_y > y) || (y >= (graphics_buffer_shift_y + graphics_buffer_height))
-                            || (graphics_buffer_shift_x >= SCREEN_WIDTH) || (
-                                (graphics_buffer_shift_x + graphics_buffer_width) < 0)) {
-                            memset(output_buffer, 255, SCREEN_WIDTH);
-                            break;
-                        }
-
-                        uint8_t* activ_buf_end = output_buffer + SCREEN_WIDTH;
-                        //рисуем пространство слева от буфера
-                        for (int i = graphics_buffer_shift_x; i-- > 0;) {
-                            *output_buffer++ = 255;
-                        }
-
-                        //рисуем сам видеобуфер+пространство справа
-                        const uint8_t* input_buffer_end = input_buffer + graphics_buffer_width;
-                        if (graphics_buffer_shift_x < 0) input_buffer -= graphics_buffer_shift_x;
-                        register size_t x = 0;
-                        while (activ_buf_end > output_buffer) {
-                            if (input_buffer < input_buffer_end) {
-                                register uint8_t c = input_buffer[x++];
-                                *output_buffer++ = (c >= BASE_HDMI_CTRL_INX && c < (BASE_HDMI_CTRL_INX + HDMI_CTRL_COUNT)) ? 255 : c;
-                            }
-                            else {
-                                *output_buffer++ = 255;
-                            }
-                        }
-                        break;
-                    default:
-                        for (int i = SCREEN_WIDTH; i--;) {
-                            uint8_t i_color = *input_buffer++;
-                            if (i_color >= BASE_HDMI_CTRL_INX && i_color < (BASE_HDMI_CTRL_INX + HDMI_CTRL_COUNT)) i_color = 255;
-                            *output_buffer++ = i_color;
-                        }
-                        break;
-                }
-            }
-        }
-
-
-        // memset(activ_buf,2,320);//test
-
-        //ССИ
-        //для выравнивания синхры
-
-        // --|_|---|_|---|_|----
-        //---|___________|-----
-        memset(activ_buf + 48,BASE_HDMI_CTRL_INX, 24);
-        memset(activ_buf,BASE_HDMI_CTRL_INX + 1, 48);
-        memset(activ_buf + 392,BASE_HDMI_CTRL_INX, 8);
-
-        //без выравнивания
-        // --|_|---|_|---|_|----
-        //------|___________|----
-        //   memset(activ_buf+320,BASE_HDMI_CTRL_INX,8);
-        //   memset(activ_buf+328,BASE_HDMI_CTRL_INX+1,48);
-        //   memset(activ_buf+376,BASE_HDMI_CTRL_INX,24);
-    }
-    else {
-        if ((line >= 490) && (line < 492)) {
-            //кадровый синхроимпульс
-            //для выравнивания синхры
-            // --|_|---|_|---|_|----
-            //---|___________|-----
-            memset(activ_buf + 48,BASE_HDMI_CTRL_INX + 2, 352);
-            memset(activ_buf,BASE_HDMI_CTRL_INX + 3, 48);
-            //без выравнивания
-            // --|_|---|_|---|_|----
-            //-------|___________|----
-
-            // memset(activ_buf,BASE_HDMI_CTRL_INX+2,328);
-            // memset(activ_buf+328,BASE_HDMI_CTRL_INX+3,48);
-            // memset(activ_buf+376,BASE_HDMI_CTRL_INX+2,24);
+            hdmi_isr_lock();
+            const hdmi_line_src_t src = {
+                .buffer = graphics_buffer,
+                .width = graphics_buffer_width,
+                .height = graphics_buffer_height,
+                .shift_x = graphics_buffer_shift_x,
+                .shift_y = graphics_buffer_shift_y,
+                .raw = (hdmi_graphics_mode != GRAPHICSMODE_DEFAULT),
+            };
+            hdmi_line_pixels(output_buffer, &src, (int)(line >> 1));
+            hdmi_isr_unlock();
         }
-        else {
-            //ССИ без изображения
-            //для выравнивания синхры
-
-            memset(activ_buf + 48,BASE_HDMI_CTRL_INX, 352);
-            memset(activ_buf,BASE_HDMI_CTRL_INX + 1, 48);
-
-            // memset(activ_buf,BASE_HDMI_CTRL_INX,328);
-            // memset(activ_buf+328,BASE_HDMI_CTRL_INX+1,48);
-            // memset(activ_buf+376,BASE_HDMI_CTRL_INX,24);
-        };
     }
-
+    hdmi_line_sync(activ_buf, line, mode.h_width);
 
     // y=(y==524)?0:(y+1);
     // inx_buf_dma++;
@@ -441,11 +612,28 @@ static inline void irq_remove_handler_DMA_core1() {
 }
 
 static inline void irq_set_exclusive_handler_DMA_core1() {
+    // IRQ enables are per core: the DMA IRQ is serviced by whichever core runs this.
+    hdmi_isr_core = get_core_num();
+    hdmi_systick_start();
     irq_set_exclusive_handler(VIDEO_DMA_IRQ, dma_handler_HDMI);
     irq_set_priority(VIDEO_DMA_IRQ, 0);
     irq_set_enabled(VIDEO_DMA_IRQ, true);
 }
 
+#if HDMI_USE_CORE1
+static uint32_t __scratch_x("hdmi_core1_stack") hdmi_core1_stack[HDMI_CORE1_STACK_WORDS];
+static volatile bool hdmi_core1_started = false;
+
+static void __not_in_flash_func(hdmi_core1_entry)(void) {
+    irq_set_exclusive_handler_DMA_core1();
+    dma_start_channel_mask((1u << dma_chan_ctrl));
+    hdmi_core1_started = true;
+    while (true) {
+        __wfi();
+    }
+}
+#endif
+
 void graphics_set_palette_hdmi(const uint8_t i, const uint32_t color888);
 
 //деинициализация - инициализация ресурсов
@@ -712,47 +900,29 @@ static inline bool hdmi_init() {
     hw_set_bits(&dma_hw->ch[dma_chan_pal_conv].ctrl_trig, DMA_CH0_CTRL_TRIG_HIGH_PRIORITY_BITS);
     hw_set_bits(&dma_hw->ch[dma_chan_pal_conv_ctrl].ctrl_trig, DMA_CH0_CTRL_TRIG_HIGH_PRIORITY_BITS);
 
+#if HDMI_USE_CORE1
+    // Core 1 installs the IRQ handler and starts scanout, then only services the IRQ.
+    if (!hdmi_core1_started) {
+        multicore_launch_core1_with_stack(hdmi_core1_entry, hdmi_core1_stack, sizeof(hdmi_core1_stack));
+        while (!hdmi_core1_started) {
+            tight_loop_contents();
+        }
+    }
+#else
     irq_set_exclusive_handler_DMA_core1();
 
     dma_start_channel_mask((1u << dma_chan_ctrl));
+#endif
 
     return true;
 };
 
-// Gamma-corrected fade table: maps (fade_level 0-63) to brightness multiplier (0-255)
-// Using gamma 2.2 curve so dark colors fade in proportionally with bright colors
-// Formula: 255 * pow((64 - fade_level) / 64.0, 1/2.2)
-static const uint8_t fade_gamma_table[64] = {
-    255, 253, 251, 249, 247, 245, 243, 241,  // 0-7
-    239, 236, 234, 231, 229, 226, 223, 220,  // 8-15
-    217, 214, 211, 208, 204, 201, 197, 193,  // 16-23
-    189, 185, 181, 176, 172, 167, 162, 156,  // 24-31
-    151, 145, 139, 133, 126, 119, 112, 104,  // 32-39
-    96,  88,  79,  69,  59,  48,  36,  23,   // 40-47
-    0,   0,   0,   0,   0,   0,   0,   0,    // 48-55 (fade to black faster)
-    0,   0,   0,   0,   0,   0,   0,   0     // 56-63
-};
-
-// Apply fade to a color: reduce brightness based on fade level
-// Uses gamma correction so dark and bright colors fade proportionally
-static inline uint32_t apply_fade_to_color(uint32_t color888, uint8_t fade_level) {
-    if (fade_level == 0) return color888;
-    if (fade_level >= 48) return 0;  // Full black at level 48+
-    
-    uint8_t r = (color888 >> 16) & 0xff;
-    uint8_t g = (color888 >> 8) & 0xff;
-    uint8_t b = (color888 >> 0) & 0xff;
-    
-    // Use gamma-corrected lookup table for perceptually uniform fade
-    uint16_t scale = fade_gamma_table[fade_level];
-    r = (r * scale) >> 8;
-    g = (g * scale) >> 8;
-    b = (b * scale) >> 8;
-    
-    return (r << 16) | (g << 8) | b;
-}
 
 void graphics_set_palette_hdmi(uint8_t i, uint32_t color888) {
+    // Unchanged entry already encoded for the current fade: nothing to do.
+    const uint32_t bit = 1u << (i & 31);
+    if ((palette_encoded[i >> 5] & bit) && palette_original[i] == (color888 & 0x00ffffff)) return;
+
     // Store original color
     palette_original[i] = color888 & 0x00ffffff;
     
@@ -773,11 +943,11 @@ void graphics_set_palette_hdmi(uint8_t i, uint32_t color888) {
 
     // Write to BACK buffer (double buffering) - DMA reads from front buffer
     uint64_t* conv_color64 = (uint64_t *)conv_color_back;
-    const uint8_t R = (faded_color >> 16) & 0xff;
-    const uint8_t G = (faded_color >> 8) & 0xff;
-    const uint8_t B = (faded_color >> 0) & 0xff;
-    conv_color64[i * 2] = get_ser_diff_data(tmds_encoder(R), tmds_encoder(G), tmds_encoder(B));
-    conv_color64[i * 2 + 1] = conv_color64[i * 2] ^ 0x0003ffffffffffffl;
+    conv_color64[i * 2] = tmds_ser_color(faded_color);
+    conv_color64[i * 2 + 1] = conv_color64[i * 2] ^ HDMI_TMDS_PAIR_XOR;
+    palette_encoded[i >> 5] |= bit;
+    hdmi_pal_encode_count++;
+    hdmi_pal_encode_frame++;
     
     // Mark back buffer as dirty - will be swapped at next vsync
     conv_color_dirty = true;
@@ -785,6 +955,13 @@ void graphics_set_palette_hdmi(uint8_t i, uint32_t color888) {
 
 // Set fade level and refresh all palette entries
 void graphics_set_fade_level(uint8_t fade_level, uint16_t which_rows) {
+    if (fade_level == g_hdmi_fade_level && which_rows == g_hdmi_fade_rows) {
+        // Same fade: only entries never encoded need work (graphics_set_palette_hdmi skips the rest).
+        for (int i = 0; i < 256; i++) {
+            graphics_set_palette_hdmi((uint8_t)i, palette_original[i]);
+        }
+        return;
+    }
     g_hdmi_fade_level = fade_level;
     g_hdmi_fade_rows = which_rows;
     
@@ -809,11 +986,11 @@ void graphics_set_fade_level(uint8_t fade_level, uint16_t which_rows) {
         
         // Write to BACK buffer (double buffering)
         uint64_t* conv_color64 = (uint64_t *)conv_color_back;
-        const uint8_t R = (color >> 16) & 0xff;
-        const uint8_t G = (color >> 8) & 0xff;
-        const uint8_t B = (color >> 0) & 0xff;
-        conv_color64[i * 2] = get_ser_diff_data(tmds_encoder(R), tmds_encoder(G), tmds_encoder(B));
-        conv_color64[i * 2 + 1] = conv_color64[i * 2] ^ 0x0003ffffffffffffl;
+        conv_color64[i * 2] = tmds_ser_color(color);
+        conv_color64[i * 2 + 1] = conv_color64[i * 2] ^ HDMI_TMDS_PAIR_XOR;
+        palette_encoded[i >> 5] |= 1u << (i & 31);
+        hdmi_pal_encode_count++;
+        hdmi_pal_encode_frame++;
     }
     graphics_restore_sync_colors();
     
@@ -825,6 +1002,18 @@ uint8_t graphics_get_fade_level(void) {
     return g_hdmi_fade_level;
 }
 
+uint32_t graphics_get_palette_encode_count(void) {
+    return hdmi_pal_encode_count;
+}
+
+uint32_t graphics_get_palette_encodes_last_frame(void) {
+    return hdmi_pal_encode_last_frame;
+}
+
+uint32_t graphics_get_palette_encodes_max_frame(void) {
+    return hdmi_pal_encode_max_frame;
+}
+
 #define RGB888(r, g, b) ((r<<16) | (g << 8 ) | b )
 
 void graphics_init_hdmi() {
@@ -840,6 +1029,10 @@ void graphics_init_hdmi() {
     // This helps prevent DMA starvation when CPU is doing heavy memory access
     bus_ctrl_hw->priority = BUSCTRL_BUS_PRIORITY_DMA_R_BITS | BUSCTRL_BUS_PRIORITY_DMA_W_BITS;
 
+#if HDMI_USE_CORE1
+    hdmi_scanout_lock = spin_lock_instance((uint)spin_lock_claim_unused(true));
+#endif
+
     hdmi_init();
 }
 
@@ -851,33 +1044,16 @@ void graphics_set_bgcolor_hdmi(uint32_t color888) //определяем зар
 void graphics_restore_sync_colors(void) {
     // Restore HDMI sync control colors after palette updates
     // Write to BOTH buffers since these must always be valid
-    const uint16_t b0 = 0b1101010100;
-    const uint16_t b1 = 0b0010101011;
-    const uint16_t b2 = 0b0101010100;
-    const uint16_t b3 = 0b1010101011;
+    (void)tmds_ser_color(0);  // Builds the tables on first use
     const int base_inx = BASE_HDMI_CTRL_INX;
-    
-    // Write to back buffer
     uint64_t* conv_color64_back = (uint64_t *)conv_color_back;
-    conv_color64_back[2 * base_inx + 0] = get_ser_diff_data(b0, b0, b3);
-    conv_color64_back[2 * base_inx + 1] = get_ser_diff_data(b0, b0, b3);
-    conv_color64_back[2 * (base_inx + 1) + 0] = get_ser_diff_data(b0, b0, b2);
-    conv_color64_back[2 * (base_inx + 1) + 1] = get_ser_diff_data(b0, b0, b2);
-    conv_color64_back[2 * (base_inx + 2) + 0] = get_ser_diff_data(b0, b0, b1);
-    conv_color64_back[2 * (base_inx + 2) + 1] = get_ser_diff_data(b0, b0, b1);
-    conv_color64_back[2 * (base_inx + 3) + 0] = get_ser_diff_data(b0, b0, b0);
-    conv_color64_back[2 * (base_inx + 3) + 1] = get_ser_diff_data(b0, b0, b0);
-    
-    // Also write to front buffer so sync is always valid
     uint64_t* conv_color64_front = (uint64_t *)conv_color_front;
-    conv_color64_front[2 * base_inx + 0] = get_ser_diff_data(b0, b0, b3);
-    conv_color64_front[2 * base_inx + 1] = get_ser_diff_data(b0, b0, b3);
-    conv_color64_front[2 * (base_inx + 1) + 0] = get_ser_diff_data(b0, b0, b2);
-    conv_color64_front[2 * (base_inx + 1) + 1] = get_ser_diff_data(b0, b0, b2);
-    conv_color64_front[2 * (base_inx + 2) + 0] = get_ser_diff_data(b0, b0, b1);
-    conv_color64_front[2 * (base_inx + 2) + 1] = get_ser_diff_data(b0, b0, b1);
-    conv_color64_front[2 * (base_inx + 3) + 0] = get_ser_diff_data(b0, b0, b0);
-    conv_color64_front[2 * (base_inx + 3) + 1] = get_ser_diff_data(b0, b0, b0);
+    for (int k = 0; k < HDMI_CTRL_COUNT; ++k) {
+        conv_color64_back[2 * (base_inx + k) + 0] = tmds_ser.sync[k];
+        conv_color64_back[2 * (base_inx + k) + 1] = tmds_ser.sync[k];
+        conv_color64_front[2 * (base_inx + k) + 0] = tmds_ser.sync[k];
+        conv_color64_front[2 * (base_inx + k) + 1] = tmds_ser.sync[k];
+    }
 }
 
 // Wrappers for existing API
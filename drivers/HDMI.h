@@ -9,6 +9,19 @@
 // Use DMA_IRQ_1 for HDMI to avoid conflict with audio on DMA_IRQ_0
 #define VIDEO_DMA_IRQ (DMA_IRQ_1)
 
+// Zero-copy scanout: during gameplay HDMI reads SDLPoP's 320x200 onscreen surface
+// directly (20-line letterbox) instead of a separate 320x240 copy.
+#ifndef RP2350_ZERO_COPY_SCANOUT
+#define RP2350_ZERO_COPY_SCANOUT 1
+#endif
+
+// Scanline ISR telemetry: cycle histogram, per-line worst case and an underrun log
+// correlated with SD reads. Costs a few cycles per line, ~1.3 KB SRAM and a serial
+// console poll per frame, so it is off unless a profiling build asks for it.
+#ifndef HDMI_TELEMETRY
+#define HDMI_TELEMETRY 0
+#endif
+
 #ifndef HDMI_BASE_PIN
 #define HDMI_BASE_PIN (6)
 #endif
@@ -59,6 +72,18 @@ uint32_t graphics_get_width(void);
 uint32_t graphics_get_height(void);
 void graphics_set_res(int w, int h);
 void graphics_set_shift(int x, int y);
+// Atomically switch scanout to a w x h buffer placed shift_y lines down the
+// 240-line output; lines outside the buffer are black.
+void graphics_set_scanout(uint8_t *buffer, int w, int h, int shift_y);
+// Tear-free double buffering (same geometry as the scanout buffer). The back buffer
+// returned by graphics_get_back_buffer() is never scanned out; graphics_present()
+// queues it and returns at once, the swap happens in vsync_handler().
+// graphics_set_scanout() drops back to single buffering.
+void graphics_set_back_buffer(uint8_t *buffer);
+uint8_t* graphics_get_back_buffer(void);
+void graphics_present(void);
+bool graphics_get_flip_pending(void);
+uint32_t graphics_get_flip_count(void);
 void graphics_set_palette(uint8_t i, uint32_t color888);
 void graphics_restore_sync_colors(void);
 void startVIDEO(uint8_t vol);
@@ -70,6 +95,13 @@ void set_palette(uint8_t n); // переключение палитр
 void graphics_set_fade_level(uint8_t fade_level, uint16_t which_rows);
 uint8_t graphics_get_fade_level(void);
 
+// Palette upload stats (for diagnostics): entries TMDS-encoded in total, during the
+// last complete video frame, and the worst frame so far. Setting an entry to its
+// current colour is free and not counted.
+uint32_t graphics_get_palette_encode_count(void);
+uint32_t graphics_get_palette_encodes_last_frame(void);
+uint32_t graphics_get_palette_encodes_max_frame(void);
+
 // Loading mode: when enabled, HDMI outputs black without accessing PSRAM
 // This prevents HDMI signal loss during heavy SD card/PSRAM operations
 void graphics_set_loading_mode(bool enable);
@@ -81,6 +113,22 @@ uint32_t graphics_get_hdmi_irq_count(void);
 // Get HDMI FIFO underrun counter (for diagnostics)
 uint32_t graphics_get_hdmi_underrun_count(void);
 
+// ISR load counters (for diagnostics): clk_sys cycles spent in the HDMI scanline ISR
+// on `core`, and which core services it (1 with HDMI_USE_CORE1).
+uint64_t graphics_get_hdmi_isr_cycles(unsigned core);
+uint32_t graphics_get_hdmi_core(void);
+
+// SD activity marker for the underrun log: pop_fs_read brackets its f_read calls with
+// graphics_note_io(true)/graphics_note_io(false). Cheap enough to call unconditionally.
+void graphics_note_io(bool busy);
+
+#if HDMI_TELEMETRY
+// Print the ISR histogram, slowest lines and underrun log via stdio (USB CDC);
+// `reset` clears them afterwards.
+void graphics_dump_hdmi_telemetry(bool reset);
+uint32_t graphics_get_hdmi_worst_cycles(void);
+#endif
+
 // Get double-buffer swap counter (for diagnostics)
 uint32_t graphics_get_buffer_swap_count(void);
 
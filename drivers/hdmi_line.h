@@ -0,0 +1,285 @@
+#ifndef HDMI_LINE_H_
+#define HDMI_LINE_H_
+
+// Scanline assembly and TMDS symbol encoding used by the HDMI driver.
+// Plain C with no Pico SDK dependencies, so tools/hdmi_sim.c can run the exact code
+// the DMA ISR runs and reproduce the per-line symbol stream on the host.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#ifndef HDMI_PIN_RGB_notBGR
+#define HDMI_PIN_RGB_notBGR (1)
+#endif
+#ifndef HDMI_PIN_invert_diffpairs
+#define HDMI_PIN_invert_diffpairs (1)
+#endif
+
+// NOTE: HDMI uses indices 240..243 as service/control codes.
+// All other indices (including 244..255) are available for visible pixels.
+// Scanout buffers must never contain 240..243: the SDL shim keeps them out when the
+// screen palette/framebuffer are written, so the ISR copies lines unfiltered.
+// Set HDMI_FILTER_CTRL_INDICES=1 to clamp them to 255 per pixel in the ISR instead.
+#ifndef HDMI_FILTER_CTRL_INDICES
+#define HDMI_FILTER_CTRL_INDICES 0
+#endif
+
+#define BASE_HDMI_CTRL_INX (240)
+#define HDMI_CTRL_COUNT (4)
+
+// DMA line layout (palette indices, one per two output pixels):
+//   [0, 48)    hsync             [48, 72)  back porch
+//   [72, 392)  320 visible pixels [392, 400) front porch
+#define HDMI_LINE_BYTES (400)
+#define HDMI_LINE_ACTIVE_OFFSET (72)
+#define HDMI_LINE_PIXELS (320)
+// Scanlines carrying the vertical sync pulse.
+#define HDMI_VSYNC_LINE_FIRST (490)
+#define HDMI_VSYNC_LINE_END (492)
+
+// Second conversion word of each palette entry (odd output pixel).
+#define HDMI_TMDS_PAIR_XOR (0x0003ffffffffffffull)
+
+// Placement of the scanout buffer in the 320x240 raster (see graphics_set_scanout).
+typedef struct {
+    const uint8_t* buffer;  // 8bpp indices, `width` bytes per row; NULL = black
+    int width;
+    int height;
+    int shift_x;
+    int shift_y;
+    bool raw;               // Not GRAPHICSMODE_DEFAULT: rows are copied as-is
+} hdmi_line_src_t;
+
+// Fill the 320 visible indices of raster row `y` (0..239).
+static inline void hdmi_line_pixels(uint8_t* output_buffer, const hdmi_line_src_t* src, int y) {
+    const int row = y - src->shift_y;
+    if (!src->buffer || row < 0 || row >= src->height) {
+        memset(output_buffer, 255, HDMI_LINE_PIXELS);  // 255 = black
+        return;
+    }
+    const uint8_t* input_buffer = src->buffer + row * src->width;
+
+    if (src->raw) {
+#if HDMI_FILTER_CTRL_INDICES
+        for (int i = HDMI_LINE_PIXELS; i--;) {
+            uint8_t i_color = *input_buffer++;
+            if (i_color >= BASE_HDMI_CTRL_INX && i_color < (BASE_HDMI_CTRL_INX + HDMI_CTRL_COUNT)) i_color = 255;
+            *output_buffer++ = i_color;
+        }
+#else
+        memcpy(output_buffer, input_buffer, HDMI_LINE_PIXELS);
+#endif
+        return;
+    }
+
+    //заполняем пространство сверху и снизу графического буфера
+    if ((src->shift_x >= HDMI_LINE_PIXELS) || ((src->shift_x + src->width) < 0)) {
+        memset(output_buffer, 255, HDMI_LINE_PIXELS);
+        return;
+    }
+
+#if !HDMI_FILTER_CTRL_INDICES
+    // Fast path: unshifted full-width line is a straight word copy.
+    if (src->shift_x == 0 && src->width >= HDMI_LINE_PIXELS && (((uintptr_t)input_buffer & 3u) == 0)) {
+        const uint32_t* src32 = (const uint32_t*)input_buffer;
+        uint32_t* dst32 = (uint32_t*)output_buffer;
+        for (int i = 0; i < HDMI_LINE_PIXELS / 4; i += 4) {
+            dst32[i + 0] = src32[i + 0];
+            dst32[i + 1] = src32[i + 1];
+            dst32[i + 2] = src32[i + 2];
+            dst32[i + 3] = src32[i + 3];
+        }
+        return;
+    }
+#endif
+
+    uint8_t* activ_buf_end = output_buffer + HDMI_LINE_PIXELS;
+    //рисуем пространство слева от буфера
+    for (int i = src->shift_x; i-- > 0;) {
+        *output_buffer++ = 255;
+    }
+
+    //рисуем сам видеобуфер+пространство справа
+    const uint8_t* input_buffer_end = input_buffer + src->width;
+    if (src->shift_x < 0) input_buffer -= src->shift_x;
+    size_t x = 0;
+    while (activ_buf_end > output_buffer) {
+        if (input_buffer + x < input_buffer_end) {
+            uint8_t c = input_buffer[x++];
+#if HDMI_FILTER_CTRL_INDICES
+            *output_buffer++ = (c >= BASE_HDMI_CTRL_INX && c < (BASE_HDMI_CTRL_INX + HDMI_CTRL_COUNT)) ? 255 : c;
+#else
+            *output_buffer++ = c;
+#endif
+        }
+        else {
+            *output_buffer++ = 255;
+        }
+    }
+}
+
+// Write the sync/porch control indices of scanline `line`; lines >= h_width are blanking.
+static inline void hdmi_line_sync(uint8_t* activ_buf, unsigned line, unsigned h_width) {
+    if (line < h_width) {
+        //ССИ
+        // --|_|---|_|---|_|----
+        //---|___________|-----
+        memset(activ_buf + 48, BASE_HDMI_CTRL_INX, 24);
+        memset(activ_buf, BASE_HDMI_CTRL_INX + 1, 48);
+        memset(activ_buf + 392, BASE_HDMI_CTRL_INX, 8);
+    }
+    else if ((line >= HDMI_VSYNC_LINE_FIRST) && (line < HDMI_VSYNC_LINE_END)) {
+        //кадровый синхроимпульс
+        memset(activ_buf + 48, BASE_HDMI_CTRL_INX + 2, 352);
+        memset(activ_buf, BASE_HDMI_CTRL_INX + 3, 48);
+    }
+    else {
+        //ССИ без изображения
+        memset(activ_buf + 48, BASE_HDMI_CTRL_INX, 352);
+        memset(activ_buf, BASE_HDMI_CTRL_INX + 1, 48);
+    }
+}
+
+// Assemble a whole DMA line as the scanline ISR does (`src` NULL = loading mode, black).
+static inline void hdmi_line_assemble(uint8_t* activ_buf, unsigned line, unsigned h_width,
+                                      const hdmi_line_src_t* src) {
+    if (line < h_width) {
+        uint8_t* output_buffer = activ_buf + HDMI_LINE_ACTIVE_OFFSET;
+        if (src) {
+            hdmi_line_pixels(output_buffer, src, (int)(line >> 1));
+        } else {
+            memset(output_buffer, 255, HDMI_LINE_PIXELS);
+        }
+    }
+    hdmi_line_sync(activ_buf, line, h_width);
+}
+
+static inline uint64_t get_ser_diff_data(const uint16_t dataR, const uint16_t dataG, const uint16_t dataB) {
+    uint64_t out64 = 0;
+    for (int i = 0; i < 10; i++) {
+        out64 <<= 6;
+        if (i == 5) out64 <<= 2;
+#ifdef PICO_PC
+        uint8_t bG = (dataR >> (9 - i)) & 1;
+        uint8_t bR = (dataG >> (9 - i)) & 1;
+#else
+        uint8_t bR = (dataR >> (9 - i)) & 1;
+        uint8_t bG = (dataG >> (9 - i)) & 1;
+#endif
+        uint8_t bB = (dataB >> (9 - i)) & 1;
+
+        bR |= (bR ^ 1) << 1;
+        bG |= (bG ^ 1) << 1;
+        bB |= (bB ^ 1) << 1;
+
+        if (HDMI_PIN_invert_diffpairs) {
+            bR ^= 0b11;
+            bG ^= 0b11;
+            bB ^= 0b11;
+        }
+        uint8_t d6;
+        if (HDMI_PIN_RGB_notBGR) {
+            d6 = (bR << 4) | (bG << 2) | (bB << 0);
+        }
+        else {
+            d6 = (bB << 4) | (bG << 2) | (bR << 0);
+        }
+
+
+        out64 |= d6;
+    }
+    return out64;
+}
+
+//конвертор TMDS
+static inline unsigned tmds_encoder(const uint8_t d8) {
+    int s1 = 0;
+    for (int i = 0; i < 8; i++) s1 += (d8 & (1 << i)) ? 1 : 0;
+    bool is_xnor = false;
+    if ((s1 > 4) || ((s1 == 4) && ((d8 & 1) == 0))) is_xnor = true;
+    uint16_t d_out = d8 & 1;
+    uint16_t qi = d_out;
+    for (int i = 1; i < 8; i++) {
+        d_out |= ((qi << 1) ^ (d8 & (1 << i))) ^ (is_xnor << i);
+        qi = d_out & (1 << i);
+    }
+
+    if (is_xnor) d_out |= 1 << 9;
+    else d_out |= 1 << 8;
+
+    return d_out;
+}
+
+// Serialized TMDS symbols per channel value (R, G, B). The three channels occupy
+// disjoint bits of get_ser_diff_data()'s output, so a colour encodes as
+// lut[0][R] | lut[1][G] | lut[2][B]: a table walk instead of three tmds_encoder()
+// runs plus the 10-step bit interleave for every palette/fade update.
+typedef struct {
+    uint64_t lut[3][256];
+    uint64_t sync[HDMI_CTRL_COUNT];
+} hdmi_tmds_tables_t;
+
+static inline void hdmi_tmds_build_tables(hdmi_tmds_tables_t* t) {
+    const uint64_t base = get_ser_diff_data(0, 0, 0);
+    const uint64_t mask_r = base ^ get_ser_diff_data(0x3ff, 0, 0);
+    const uint64_t mask_g = base ^ get_ser_diff_data(0, 0x3ff, 0);
+    const uint64_t mask_b = base ^ get_ser_diff_data(0, 0, 0x3ff);
+    for (int v = 0; v < 256; ++v) {
+        const uint16_t sym = (uint16_t)tmds_encoder((uint8_t)v);
+        t->lut[0][v] = get_ser_diff_data(sym, 0, 0) & mask_r;
+        t->lut[1][v] = get_ser_diff_data(0, sym, 0) & mask_g;
+        t->lut[2][v] = get_ser_diff_data(0, 0, sym) & mask_b;
+    }
+
+    // Control symbols for the reserved indices (see graphics_restore_sync_colors).
+    const uint16_t b0 = 0b1101010100;
+    const uint16_t b1 = 0b0010101011;
+    const uint16_t b2 = 0b0101010100;
+    const uint16_t b3 = 0b1010101011;
+    t->sync[0] = get_ser_diff_data(b0, b0, b3);
+    t->sync[1] = get_ser_diff_data(b0, b0, b2);
+    t->sync[2] = get_ser_diff_data(b0, b0, b1);
+    t->sync[3] = get_ser_diff_data(b0, b0, b0);
+}
+
+static inline uint64_t hdmi_tmds_color(const hdmi_tmds_tables_t* t, uint32_t color888) {
+    return t->lut[0][(color888 >> 16) & 0xff] |
+           t->lut[1][(color888 >> 8) & 0xff] |
+           t->lut[2][color888 & 0xff];
+}
+
+// Gamma-corrected fade table: maps (fade_level 0-63) to brightness multiplier (0-255)
+// Using gamma 2.2 curve so dark colors fade in proportionally with bright colors
+// Formula: 255 * pow((64 - fade_level) / 64.0, 1/2.2)
+static const uint8_t fade_gamma_table[64] = {
+    255, 253, 251, 249, 247, 245, 243, 241,  // 0-7
+    239, 236, 234, 231, 229, 226, 223, 220,  // 8-15
+    217, 214, 211, 208, 204, 201, 197, 193,  // 16-23
+    189, 185, 181, 176, 172, 167, 162, 156,  // 24-31
+    151, 145, 139, 133, 126, 119, 112, 104,  // 32-39
+    96,  88,  79,  69,  59,  48,  36,  23,   // 40-47
+    0,   0,   0,   0,   0,   0,   0,   0,    // 48-55 (fade to black faster)
+    0,   0,   0,   0,   0,   0,   0,   0     // 56-63
+};
+
+// Apply fade to a color: reduce brightness based on fade level
+// Uses gamma correction so dark and bright colors fade proportionally
+static inline uint32_t apply_fade_to_color(uint32_t color888, uint8_t fade_level) {
+    if (fade_level == 0) return color888;
+    if (fade_level >= 48) return 0;  // Full black at level 48+
+    
+    uint8_t r = (color888 >> 16) & 0xff;
+    uint8_t g = (color888 >> 8) & 0xff;
+    uint8_t b = (color888 >> 0) & 0xff;
+    
+    // Use gamma-corrected lookup table for perceptually uniform fade
+    uint16_t scale = fade_gamma_table[fade_level];
+    r = (r * scale) >> 8;
+    g = (g * scale) >> 8;
+    b = (b * scale) >> 8;
+    
+    return (r << 16) | (g << 8) | b;
+}
+
+#endif // HDMI_LINE_H_
@@ -0,0 +1,125 @@
+#ifndef MEM_TELEMETRY_H
+#define MEM_TELEMETRY_H
+
+// Per-category memory accounting: live bytes, high-water marks and counts per
+// allocation category. psram_allocator.c tags every PSRAM heap block with a category
+// and reports here; psram_dump_telemetry() prints the tables ('m' on the serial console).
+//
+// Plain C, no Pico SDK: tools/psram_stress.c prints the same report on the host.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Off by default like HDMI_TELEMETRY: it adds bookkeeping to every PSRAM alloc/free.
+#ifndef MEM_TELEMETRY
+#define MEM_TELEMETRY 0
+#endif
+
+typedef enum {
+    MEM_CAT_OTHER = 0,
+    MEM_CAT_SURFACE,      // SDL surfaces created outside a chtab load
+    MEM_CAT_PALETTE,
+    MEM_CAT_SOUND,        // Sound effects, MIDI instruments, music stream buffers
+    MEM_CAT_LEVEL,        // Level data and per-level palettes
+    MEM_CAT_CHTAB,        // Sprite tables and everything loaded with them
+    MEM_CAT_FILEBUF,      // Whole-file read buffers
+    MEM_CAT_COUNT
+} mem_cat_t;
+
+typedef struct {
+    uint32_t live;        // Bytes currently allocated
+    uint32_t high_water;
+    uint32_t blocks;      // Live allocations
+    uint32_t allocs;      // Allocations since boot
+    uint32_t failures;
+} mem_tel_cat_t;
+
+typedef struct {
+    mem_tel_cat_t cat[MEM_CAT_COUNT];
+    uint32_t live;        // Sum over categories
+    uint32_t high_water;
+} mem_tel_pool_t;
+
+static inline const char *mem_tel_cat_name(mem_cat_t cat) {
+    static const char *const names[MEM_CAT_COUNT] = {
+        "other", "surfaces", "palettes", "sounds", "level data", "chtabs", "file buffers",
+    };
+    return (unsigned)cat < MEM_CAT_COUNT ? names[cat] : "?";
+}
+
+static inline void mem_tel_on_alloc(mem_tel_pool_t *p, mem_cat_t cat, uint32_t bytes) {
+#if MEM_TELEMETRY
+    mem_tel_cat_t *c = &p->cat[cat];
+    c->live += bytes;
+    c->blocks++;
+    c->allocs++;
+    if (c->live > c->high_water) c->high_water = c->live;
+    p->live += bytes;
+    if (p->live > p->high_water) p->high_water = p->live;
+#else
+    (void)p; (void)cat; (void)bytes;
+#endif
+}
+
+static inline void mem_tel_on_free(mem_tel_pool_t *p, mem_cat_t cat, uint32_t bytes) {
+#if MEM_TELEMETRY
+    p->cat[cat].live -= bytes;
+    p->cat[cat].blocks--;
+    p->live -= bytes;
+#else
+    (void)p; (void)cat; (void)bytes;
+#endif
+}
+
+// A block changed size in place (realloc).
+static inline void mem_tel_on_resize(mem_tel_pool_t *p, mem_cat_t cat, uint32_t old_bytes, uint32_t new_bytes) {
+#if MEM_TELEMETRY
+    mem_tel_cat_t *c = &p->cat[cat];
+    c->live = c->live - old_bytes + new_bytes;
+    if (c->live > c->high_water) c->high_water = c->live;
+    p->live = p->live - old_bytes + new_bytes;
+    if (p->live > p->high_water) p->high_water = p->live;
+#else
+    (void)p; (void)cat; (void)old_bytes; (void)new_bytes;
+#endif
+}
+
+static inline void mem_tel_on_failure(mem_tel_pool_t *p, mem_cat_t cat) {
+#if MEM_TELEMETRY
+    p->cat[cat].failures++;
+#else
+    (void)p; (void)cat;
+#endif
+}
+
+// Clears the high-water marks down to the current live values.
+static inline void mem_tel_reset_high_water(mem_tel_pool_t *p) {
+    for (int i = 0; i < MEM_CAT_COUNT; ++i) p->cat[i].high_water = p->cat[i].live;
+    p->high_water = p->live;
+}
+
+typedef int (*mem_tel_print_fn)(const char *fmt, ...);
+
+// One table: a line per category with live / high-water KB, block counts and the
+// share of `capacity` (0 = no share column).
+static inline void mem_tel_print_pool(const mem_tel_pool_t *p, const char *title, uint32_t capacity,
+                                      mem_tel_print_fn out) {
+    out("%s: %lu KB live, %lu KB high water", title, (unsigned long)(p->live / 1024),
+        (unsigned long)(p->high_water / 1024));
+    if (capacity) {
+        out(" of %lu KB (%lu%% / %lu%%)", (unsigned long)(capacity / 1024),
+            (unsigned long)((uint64_t)p->live * 100u / capacity),
+            (unsigned long)((uint64_t)p->high_water * 100u / capacity));
+    }
+    out("\n  %-13s %9s %9s %7s %9s %5s\n", "category", "live KB", "high KB", "blocks", "allocs", "fail");
+    for (int i = 0; i < MEM_CAT_COUNT; ++i) {
+        const mem_tel_cat_t *c = &p->cat[i];
+        if (!c->allocs && !c->failures) continue;
+        out("  %-13s %9lu %9lu %7lu %9lu %5lu\n", mem_tel_cat_name((mem_cat_t)i), (unsigned long)(c->live / 1024),
+            (unsigned long)(c->high_water / 1024), (unsigned long)c->blocks, (unsigned long)c->allocs,
+            (unsigned long)c->failures);
+    }
+}
+
+#endif // MEM_TELEMETRY_H
@@ -5,8 +5,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <malloc.h>
 #include "pico/stdlib.h"
 #include "hardware/sync.h"
+#include "psram_tlsf.h"
+#include "mem_telemetry.h"
 
 static spin_lock_t *psram_lock = NULL;
 
@@ -24,7 +27,6 @@ static uint8_t *psram_start = (uint8_t *)PSRAM_BASE;
 // 64-128KB: Scratch 2 (Conversion)
 // 128-384KB: File Load Buffer (256KB)
 #define SCRATCH_SIZE (512 * 1024)
-static size_t psram_offset = SCRATCH_SIZE;
 
 // Temp allocator support
 // NOTE: In this project, audio is currently stubbed during bring-up.
@@ -34,7 +36,166 @@ static size_t psram_offset = SCRATCH_SIZE;
 static size_t psram_temp_offset = 0;
 static int psram_temp_mode = 0;
 static int psram_sram_mode = 0; // Force SRAM allocation (proper malloc/free)
-static size_t psram_session_mark = 0; // Save point for game session memory
+
+// General heap: TLSF over [SCRATCH_SIZE, PERM_SIZE) with real free and coalescing.
+// The temp region stays a bump arena (reset wholesale), and the game session is an
+// arena inside the heap: blocks allocated after psram_mark_session() carry a tag and
+// psram_restore_session() frees all of them in one pass.
+static tlsf_t psram_heap;
+static bool psram_heap_ready = false;
+static bool psram_session_marked = false;
+
+#define PSRAM_IN_HEAP(p) ((uintptr_t)(p) >= PSRAM_BASE + SCRATCH_SIZE && (uintptr_t)(p) < PSRAM_BASE + PERM_SIZE)
+#define PSRAM_IN_TEMP(p) ((uintptr_t)(p) >= PSRAM_BASE + PERM_SIZE && (uintptr_t)(p) < PSRAM_BASE + PSRAM_SIZE)
+
+// Every heap block starts with a prefix whose last word (just below the returned
+// pointer) is a mark: TLSF_FLAG_USER, the allocation category in bits 3..7 and the
+// arena id + 1 in bits 8.. (0 = no arena). Arena blocks also carry list links.
+//
+// Scoped arenas: named groups of heap blocks. While an arena is pushed,
+// psram_arena_malloc() links its blocks into that arena; they can still be freed one
+// by one, and psram_arena_reset() frees whatever is left.
+typedef struct psram_arena_link {
+    struct psram_arena_link *next;
+    struct psram_arena_link *prev;
+} psram_arena_link_t;
+
+#define PSRAM_PLAIN_PREFIX 8u
+#define PSRAM_ARENA_PREFIX ((sizeof(psram_arena_link_t) + sizeof(uint32_t) + 7u) & ~(size_t)7u)
+#define PSRAM_MARK(arena, cat) ((((uint32_t)(arena) + 1u) << 8) | ((uint32_t)(cat) << 3) | TLSF_FLAG_USER)
+
+typedef struct {
+    const char *name;
+    psram_arena_link_t head;  // Circular list of live blocks
+    uint32_t budget;
+    uint32_t used;            // Heap bytes held by the arena's blocks
+    uint32_t high_water;
+    uint32_t blocks;
+    uint32_t over_budget;
+    uint32_t resets;
+} psram_arena_t;
+
+static psram_arena_t psram_arenas[PSRAM_ARENA_MAX];
+static int psram_arena_n = 0;
+static psram_arena_reset_hook_t psram_arena_reset_hook = NULL;
+static int psram_arena_stack[PSRAM_ARENA_DEPTH];
+static int psram_arena_depth = 0;
+
+// Per-category accounting (heap bytes, block headers included) and the category
+// scope set with psram_set_category().
+static mem_tel_pool_t psram_tel;
+static mem_cat_t psram_scope_cat = MEM_CAT_OTHER;
+
+static inline void psram_heap_init_locked(void) {
+    tlsf_init(&psram_heap, psram_start + SCRATCH_SIZE, PERM_SIZE - SCRATCH_SIZE);
+    psram_heap_ready = true;
+    for (int i = 0; i < psram_arena_n; ++i) {
+        psram_arena_t *a = &psram_arenas[i];
+        a->head.next = a->head.prev = &a->head;
+        a->used = a->blocks = 0;
+    }
+    for (int i = 0; i < MEM_CAT_COUNT; ++i) {
+        psram_tel.cat[i].live = psram_tel.cat[i].blocks = 0;
+    }
+    psram_tel.live = 0;
+}
+
+static inline uint32_t psram_block_mark(const void *ptr) {
+    return ((const uint32_t *)ptr)[-1];
+}
+static inline int psram_mark_arena(uint32_t mark) {
+    return (int)(mark >> 8) - 1;
+}
+static inline mem_cat_t psram_mark_cat(uint32_t mark) {
+    return (mem_cat_t)((mark >> 3) & 31u);
+}
+static inline size_t psram_mark_prefix(uint32_t mark) {
+    return psram_mark_arena(mark) >= 0 ? PSRAM_ARENA_PREFIX : PSRAM_PLAIN_PREFIX;
+}
+static inline uint8_t *psram_block_start(void *ptr) {
+    return (uint8_t *)ptr - psram_mark_prefix(psram_block_mark(ptr));
+}
+// Heap bytes a block occupies, TLSF header included (matches psram_heap.used).
+static inline uint32_t psram_block_bytes(const void *block) {
+    return tlsf_block_size(&psram_heap, block) + TLSF_HDR;
+}
+
+// A category scope wins over the allocation site's own category, so for example the
+// surfaces loaded for a chtab count as chtab memory.
+static inline mem_cat_t psram_effective_cat(mem_cat_t cat) {
+    return psram_scope_cat != MEM_CAT_OTHER ? psram_scope_cat : cat;
+}
+
+static void *psram_heap_alloc_locked(size_t size, int arena, mem_cat_t cat) {
+    if (!psram_heap_ready) psram_heap_init_locked();
+    const size_t prefix = arena >= 0 ? PSRAM_ARENA_PREFIX : PSRAM_PLAIN_PREFIX;
+    // Arena blocks are not part of the session: psram_arena_reset() owns them.
+    uint8_t *block = (uint8_t *)tlsf_malloc(&psram_heap, size + prefix, arena < 0 && psram_session_marked);
+    if (!block) {
+        mem_tel_on_failure(&psram_tel, cat);
+        if (arena >= 0) {
+            DBG_PRINTF("PSRAM arena '%s' OOM! Req %d, arena %d, heap used %d\n", psram_arenas[arena].name,
+                (int)size, (int)psram_arenas[arena].used, (int)psram_heap.used);
+        } else {
+            DBG_PRINTF("PSRAM Perm OOM! Req %d (%s), used %d\n", (int)size, mem_tel_cat_name(cat),
+                (int)psram_heap.used);
+        }
+        return NULL;
+    }
+    uint8_t *ptr = block + prefix;
+    ((uint32_t *)ptr)[-1] = PSRAM_MARK(arena, cat);
+    const uint32_t bytes = psram_block_bytes(block);
+    mem_tel_on_alloc(&psram_tel, cat, bytes);
+
+    if (arena >= 0) {
+        psram_arena_t *a = &psram_arenas[arena];
+        psram_arena_link_t *link = (psram_arena_link_t *)block;
+        link->next = a->head.next;
+        link->prev = &a->head;
+        a->head.next->prev = link;
+        a->head.next = link;
+        a->used += bytes;
+        a->blocks++;
+        if (a->used > a->high_water) a->high_water = a->used;
+        if (a->budget && a->used > a->budget && a->over_budget++ == 0) {
+            DBG_PRINTF("PSRAM arena '%s' over budget: %d of %d bytes\n", a->name, (int)a->used, (int)a->budget);
+        }
+    }
+    return ptr;
+}
+
+static void psram_heap_release_locked(void *ptr) {
+    const uint32_t mark = psram_block_mark(ptr);
+    uint8_t *block = (uint8_t *)ptr - psram_mark_prefix(mark);
+    const uint32_t bytes = psram_block_bytes(block);
+    const int arena = psram_mark_arena(mark);
+    if (arena >= 0) {
+        psram_arena_t *a = &psram_arenas[arena];
+        psram_arena_link_t *link = (psram_arena_link_t *)block;
+        link->prev->next = link->next;
+        link->next->prev = link->prev;
+        a->used -= bytes;
+        a->blocks--;
+    }
+    mem_tel_on_free(&psram_tel, psram_mark_cat(mark), bytes);
+    tlsf_free(&psram_heap, block);
+}
+
+// Session restore frees tagged blocks behind the allocator's back: keep the books.
+static void psram_session_block_freed(void *ctx, void *block) {
+    (void)ctx;
+    const uint32_t mark = ((const uint32_t *)((uint8_t *)block + PSRAM_PLAIN_PREFIX))[-1];
+    mem_tel_on_free(&psram_tel, psram_mark_cat(mark), psram_block_bytes(block));
+}
+
+static inline void psram_lock_acquire(void) {
+    if (!psram_lock) {
+        int lock_num = spin_lock_claim_unused(true);
+        psram_lock = spin_lock_instance(lock_num);
+    }
+    // Use spin lock WITHOUT disabling interrupts - HDMI IRQ must keep running
+    spin_lock_unsafe_blocking(psram_lock);
+}
 
 void psram_set_temp_mode(int enable) {
     if (!psram_lock) {
@@ -78,27 +239,21 @@ void psram_set_temp_offset(size_t offset) {
 }
 
 void *psram_malloc(size_t size) {
+    return psram_malloc_cat(size, MEM_CAT_OTHER);
+}
+
+void *psram_malloc_cat(size_t size, mem_cat_t cat) {
     // If SRAM mode is enabled, use regular malloc (for peels that need proper free)
     if (psram_sram_mode) {
         return malloc(size);
     }
 
-    if (!psram_lock) {
-        int lock_num = spin_lock_claim_unused(true);
-        psram_lock = spin_lock_instance(lock_num);
-    }
-
-    // Use spin lock WITHOUT disabling interrupts - HDMI IRQ must keep running
-    // The bump allocator is simple enough that it's safe even if interrupted
-    spin_lock_unsafe_blocking(psram_lock);
-    
-    // Align to 4 bytes
-    size = (size + 3) & ~3;
-    
-    // Add header for size tracking (needed for realloc)
-    size_t total_size = size + sizeof(size_t);
+    psram_lock_acquire();
 
     if (psram_temp_mode) {
+        // Temp arena: bump with a size header (needed for realloc)
+        size = (size + 3) & ~3;
+        size_t total_size = size + sizeof(size_t);
         if (psram_temp_offset + total_size > TEMP_SIZE) {
             DBG_PRINTF("PSRAM Temp OOM! Req %d, free %d\n", (int)size, (int)(TEMP_SIZE - psram_temp_offset));
             spin_unlock_unsafe(psram_lock);
@@ -110,30 +265,51 @@ void *psram_malloc(size_t size) {
         psram_temp_offset += total_size;
         spin_unlock_unsafe(psram_lock);
         return ptr;
-    } else {
-        if (psram_offset + total_size > PERM_SIZE) {
-            DBG_PRINTF("PSRAM Perm OOM! Req %d, free %d\n", (int)size, (int)(PERM_SIZE - psram_offset));
-            spin_unlock_unsafe(psram_lock);
-            return NULL;
-        }
-        
-        size_t *header = (size_t *)(psram_start + psram_offset);
-        *header = size;
-        
-        void *ptr = (void *)(header + 1);
-        // printf("psram_malloc(%d) -> %p (offset %d) Total Perm: %d\n", (int)size, ptr, (int)psram_offset, (int)(psram_offset + total_size));
-        psram_offset += total_size;
-        spin_unlock_unsafe(psram_lock);
-        return ptr;
     }
+
+    void *ptr = psram_heap_alloc_locked(size, -1, psram_effective_cat(cat));
+    spin_unlock_unsafe(psram_lock);
+    return ptr;
 }
 
 void *psram_realloc(void *ptr, size_t new_size) {
     if (ptr == NULL) return psram_malloc(new_size);
     if (new_size == 0) { psram_free(ptr); return NULL; }
 
-    if ((uintptr_t)ptr >= PSRAM_BASE && (uintptr_t)ptr < (PSRAM_BASE + PSRAM_SIZE)) {
-        // It's in PSRAM
+    if (PSRAM_IN_HEAP(ptr)) {
+        psram_lock_acquire();
+        const uint32_t mark = psram_block_mark(ptr);
+        const int arena = psram_mark_arena(mark);
+        uint8_t *block = psram_block_start(ptr);
+        const size_t prefix = (size_t)((uint8_t *)ptr - block);
+        const uint32_t old_bytes = psram_block_bytes(block);
+        const size_t old_size = tlsf_block_size(&psram_heap, block) - prefix;
+        // Shrink, or grow a plain block into a free neighbour (not while temp
+        // allocations are requested)
+        bool in_place = (new_size <= old_size);
+        if (!in_place && arena < 0 && !psram_temp_mode && tlsf_grow_in_place(&psram_heap, block, new_size + prefix)) {
+            mem_tel_on_resize(&psram_tel, psram_mark_cat(mark), old_bytes, psram_block_bytes(block));
+            in_place = true;
+        }
+        void *new_ptr = ptr;
+        if (!in_place) {
+            // Same arena and category as the old block
+            new_ptr = (arena >= 0 && !psram_temp_mode) ? psram_heap_alloc_locked(new_size, arena, psram_mark_cat(mark))
+                                                       : NULL;
+        }
+        spin_unlock_unsafe(psram_lock);
+        if (in_place) return ptr;
+
+        if (!new_ptr) new_ptr = psram_malloc_cat(new_size, psram_mark_cat(mark));
+        if (new_ptr) {
+            memcpy(new_ptr, ptr, old_size);
+            psram_free(ptr);
+        }
+        return new_ptr;
+    }
+
+    if (PSRAM_IN_TEMP(ptr)) {
+        // Temp arena: the old block is reclaimed when the arena is reset
         size_t *header = (size_t *)ptr - 1;
         size_t old_size = *header;
 
@@ -141,13 +317,9 @@ void *psram_realloc(void *ptr, size_t new_size) {
             return ptr; // Shrink or same size: do nothing
         }
 
-        // We need to allocate new memory, which requires locking
-        // psram_malloc handles locking internally, so we are safe there.
         void *new_ptr = psram_malloc(new_size);
         if (new_ptr) {
-            // memcpy is safe as long as we own the pointers
             memcpy(new_ptr, ptr, old_size);
-            // psram_free(ptr); // No-op for bump allocator
         }
         return new_ptr;
     }
@@ -177,7 +349,11 @@ void *psram_get_file_buffer(size_t size) {
 
 void psram_free(void *ptr) {
     if (ptr >= (void*)PSRAM_BASE && ptr < (void*)(PSRAM_BASE + PSRAM_SIZE)) {
-        // It's in PSRAM, do nothing (bump allocator)
+        // Scratch / file buffers and the temp arena are not individually freed
+        if (!PSRAM_IN_HEAP(ptr) || !psram_heap_ready) return;
+        psram_lock_acquire();
+        psram_heap_release_locked(ptr);
+        spin_unlock_unsafe(psram_lock);
         return;
     }
     // It's not in PSRAM, assume it's from malloc
@@ -185,25 +361,210 @@ void psram_free(void *ptr) {
 }
 
 void psram_reset(void) {
-    psram_offset = SCRATCH_SIZE; // Reset to after scratch area
+    psram_lock_acquire();
+    psram_heap_init_locked();
     psram_temp_offset = 0;
-    psram_session_mark = 0;
+    psram_session_marked = false;
+    spin_unlock_unsafe(psram_lock);
 }
 
 void psram_mark_session(void) {
-    psram_session_mark = psram_offset;
-    DBG_PRINTF("PSRAM: Session marked at offset %d (%.2f MB used)\n", 
-           (int)psram_session_mark, psram_session_mark / (1024.0 * 1024.0));
+    psram_session_marked = true;
+    DBG_PRINTF("PSRAM: Session marked (%.2f MB used, %d blocks)\n",
+           psram_heap.used / (1024.0 * 1024.0), (int)psram_heap.allocs);
 }
 
 void psram_restore_session(void) {
-    if (psram_session_mark == 0) {
+    if (!psram_session_marked) {
         DBG_PRINTF("PSRAM: Warning - no session mark set, cannot restore\n");
         return;
     }
-    size_t freed = psram_offset - psram_session_mark;
-    psram_offset = psram_session_mark;
+    psram_lock_acquire();
+    const uint32_t freed = psram_heap_ready ? tlsf_free_tagged(&psram_heap, psram_session_block_freed, NULL) : 0;
     psram_temp_offset = 0;
-    DBG_PRINTF("PSRAM: Session restored to offset %d (freed %.2f MB)\n",
-           (int)psram_offset, freed / (1024.0 * 1024.0));
+    spin_unlock_unsafe(psram_lock);
+    DBG_PRINTF("PSRAM: Session restored (freed %.2f MB, %.2f MB still used)\n",
+           freed / (1024.0 * 1024.0), psram_heap.used / (1024.0 * 1024.0));
+}
+
+void psram_get_heap_stats(psram_heap_stats_t *out) {
+    if (!out) return;
+    psram_lock_acquire();
+    if (!psram_heap_ready) psram_heap_init_locked();
+    const tlsf_walk_t w = tlsf_walk(&psram_heap);
+    out->heap_size = psram_heap.pool_size;
+    out->used = psram_heap.used;
+    out->high_water = psram_heap.high_water;
+    out->allocs = psram_heap.allocs;
+    out->failures = psram_heap.failures;
+    out->free_bytes = w.free_bytes;
+    out->largest_free = w.largest_free;
+    out->free_blocks = w.free_blocks;
+    out->temp_used = (uint32_t)psram_temp_offset;
+    out->consistent = w.ok;
+    spin_unlock_unsafe(psram_lock);
+}
+
+// --- Scoped arenas ---
+
+int psram_arena_create(const char *name, size_t budget) {
+    psram_lock_acquire();
+    int id = -1;
+    for (int i = 0; i < psram_arena_n; ++i) {
+        if (strcmp(psram_arenas[i].name, name) == 0) {
+            id = i;
+            break;
+        }
+    }
+    if (id < 0 && psram_arena_n < PSRAM_ARENA_MAX) {
+        id = psram_arena_n++;
+        psram_arena_t *a = &psram_arenas[id];
+        memset(a, 0, sizeof(*a));
+        a->name = name;
+        a->head.next = a->head.prev = &a->head;
+    }
+    if (id >= 0) psram_arenas[id].budget = (uint32_t)budget;
+    spin_unlock_unsafe(psram_lock);
+    if (id < 0) DBG_PRINTF("PSRAM: no free arena slot for '%s'\n", name);
+    return id;
+}
+
+bool psram_arena_push(int id) {
+    if (id < 0 || id >= psram_arena_n) return false;
+    psram_lock_acquire();
+    const bool ok = psram_arena_depth < PSRAM_ARENA_DEPTH;
+    if (ok) psram_arena_stack[psram_arena_depth++] = id;
+    spin_unlock_unsafe(psram_lock);
+    if (!ok) DBG_PRINTF("PSRAM: arena stack full, '%s' not pushed\n", psram_arenas[id].name);
+    return ok;
+}
+
+void psram_arena_pop(int id) {
+    psram_lock_acquire();
+    if (psram_arena_depth > 0 && psram_arena_stack[psram_arena_depth - 1] == id) {
+        psram_arena_depth--;
+    } else {
+        DBG_PRINTF("PSRAM: arena pop of %d does not match the top of the stack\n", id);
+    }
+    spin_unlock_unsafe(psram_lock);
+}
+
+int psram_arena_current(void) {
+    return psram_arena_depth > 0 ? psram_arena_stack[psram_arena_depth - 1] : -1;
+}
+
+void *psram_arena_malloc(size_t size, mem_cat_t cat) {
+    if (psram_sram_mode) {
+        return malloc(size);
+    }
+    psram_lock_acquire();
+    const int id = psram_temp_mode ? -1 : psram_arena_current();
+    void *ptr = (id >= 0) ? psram_heap_alloc_locked(size, id, psram_effective_cat(cat)) : NULL;
+    spin_unlock_unsafe(psram_lock);
+    return (id >= 0) ? ptr : psram_malloc_cat(size, cat);
+}
+
+void psram_arena_set_reset_hook(psram_arena_reset_hook_t hook) {
+    psram_arena_reset_hook = hook;
+}
+
+int psram_arena_of(const void *ptr) {
+    if (!ptr || !psram_heap_ready || !PSRAM_IN_HEAP(ptr)) return -1;
+    return psram_mark_arena(psram_block_mark(ptr));
+}
+
+void psram_arena_reset(int id) {
+    if (id < 0 || id >= psram_arena_n) return;
+    psram_arena_t *a = &psram_arenas[id];
+    // Outside the lock: the hook frees through psram_free().
+    if (psram_arena_reset_hook) psram_arena_reset_hook(id);
+    psram_lock_acquire();
+    const uint32_t blocks = a->blocks, bytes = a->used;
+    while (a->head.next != &a->head) {
+        psram_heap_release_locked((uint8_t *)a->head.next + PSRAM_ARENA_PREFIX);
+    }
+    a->resets++;
+    spin_unlock_unsafe(psram_lock);
+    DBG_PRINTF("PSRAM: arena '%s' reset, freed %d blocks / %d KB (high water %d KB)\n", a->name, (int)blocks,
+        (int)(bytes / 1024), (int)(a->high_water / 1024));
+}
+
+bool psram_arena_get_stats(int id, psram_arena_stats_t *out) {
+    if (id < 0 || id >= psram_arena_n || !out) return false;
+    const psram_arena_t *a = &psram_arenas[id];
+    psram_lock_acquire();
+    out->name = a->name;
+    out->budget = a->budget;
+    out->used = a->used;
+    out->high_water = a->high_water;
+    out->blocks = a->blocks;
+    out->over_budget = a->over_budget;
+    out->resets = a->resets;
+    int depth = -1;
+    for (int i = 0; i < psram_arena_depth; ++i) {
+        if (psram_arena_stack[i] == id) depth = i;
+    }
+    out->depth = depth;
+    spin_unlock_unsafe(psram_lock);
+    return true;
+}
+
+int psram_arena_count(void) {
+    return psram_arena_n;
+}
+
+// --- Telemetry ---
+
+mem_cat_t psram_set_category(mem_cat_t cat) {
+    const mem_cat_t prev = psram_scope_cat;
+    psram_scope_cat = cat;
+    return prev;
+}
+
+void psram_get_telemetry(mem_tel_pool_t *out) {
+    if (!out) return;
+    psram_lock_acquire();
+    *out = psram_tel;
+    spin_unlock_unsafe(psram_lock);
+}
+
+// Pico SDK linker symbols: end of .bss (start of the SRAM heap) and its upper limit.
+extern char __bss_end__, __StackLimit;
+
+void psram_dump_telemetry(bool reset_high_water) {
+    // Snapshot first so printing (slow over USB) sees a consistent view.
+    static mem_tel_pool_t tel;
+    psram_heap_stats_t heap;
+    psram_get_heap_stats(&heap);
+    psram_get_telemetry(&tel);
+
+    printf("Memory telemetry\n");
+    mem_tel_print_pool(&tel, "PSRAM heap", heap.heap_size, printf);
+    printf("  heap: %lu blocks, %lu KB free in %lu blocks, largest free %lu KB, %lu failed allocs%s\n",
+        (unsigned long)heap.allocs, (unsigned long)(heap.free_bytes / 1024), (unsigned long)heap.free_blocks,
+        (unsigned long)(heap.largest_free / 1024), (unsigned long)heap.failures,
+        heap.consistent ? "" : ", WALK FOUND CORRUPTION");
+    printf("  fixed: scratch %u KB, file buffer %u KB, temp arena %lu of %u KB\n", 256u, 256u,
+        (unsigned long)(heap.temp_used / 1024), (unsigned)(TEMP_SIZE / 1024));
+    for (int i = 0; i < psram_arena_count(); ++i) {
+        psram_arena_stats_t as;
+        if (!psram_arena_get_stats(i, &as)) continue;
+        printf("  arena %-15s %6lu KB live, %6lu KB high, %5lu blocks, budget %lu KB (%lu over), %lu resets%s\n",
+            as.name, (unsigned long)(as.used / 1024), (unsigned long)(as.high_water / 1024),
+            (unsigned long)as.blocks, (unsigned long)(as.budget / 1024), (unsigned long)as.over_budget,
+            (unsigned long)as.resets, as.depth >= 0 ? " [pushed]" : "");
+    }
+
+    // newlib never returns heap memory, so the arena size is the SRAM heap's high water.
+    const struct mallinfo mi = mallinfo();
+    const uintptr_t sram_heap_cap = (uintptr_t)&__StackLimit - (uintptr_t)&__bss_end__;
+    printf("SRAM heap: %lu KB live, %lu KB high water of %lu KB; static data + bss %lu KB\n",
+        (unsigned long)(mi.uordblks / 1024), (unsigned long)(mi.arena / 1024), (unsigned long)(sram_heap_cap / 1024),
+        (unsigned long)(((uintptr_t)&__bss_end__ - SRAM_BASE) / 1024));
+
+    if (reset_high_water) {
+        psram_lock_acquire();
+        mem_tel_reset_high_water(&psram_tel);
+        spin_unlock_unsafe(psram_lock);
+    }
 }
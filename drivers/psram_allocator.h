@@ -2,13 +2,17 @@
 #define PSRAM_ALLOCATOR_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "mem_telemetry.h"
 
-void *psram_malloc(size_t size);
+void *psram_malloc(size_t size);                    // Category MEM_CAT_OTHER
+void *psram_malloc_cat(size_t size, mem_cat_t cat);
 void *psram_realloc(void *ptr, size_t size);
 void psram_free(void *ptr);
 void psram_reset(void);
-void psram_mark_session(void);    // Mark current offset for game session
-void psram_restore_session(void); // Restore to marked offset
+void psram_mark_session(void);    // Later allocations belong to the game session
+void psram_restore_session(void); // Free every allocation made since the mark
 void *psram_get_scratch_1(size_t size);
 void *psram_get_scratch_2(size_t size);
 void *psram_get_file_buffer(size_t size);
@@ -20,4 +24,69 @@ void psram_set_temp_offset(size_t offset);
 
 void psram_set_sram_mode(int enable); // Force SRAM allocation for proper malloc/free
 
+// General PSRAM heap (TLSF: O(1) malloc/free, neighbours coalesced on free).
+typedef struct {
+    uint32_t heap_size;
+    uint32_t used;          // Allocated bytes including block headers
+    uint32_t high_water;
+    uint32_t allocs;        // Live blocks
+    uint32_t failures;      // Allocations that found no block
+    uint32_t free_bytes;
+    uint32_t largest_free;  // Largest single allocation that would succeed now
+    uint32_t free_blocks;   // Fragmentation: number of separate free blocks
+    uint32_t temp_used;     // Temp arena bytes in use
+    bool consistent;        // Heap walk found no corruption
+} psram_heap_stats_t;
+
+// Walks the heap (O(blocks)): for diagnostics, not per frame.
+void psram_get_heap_stats(psram_heap_stats_t *out);
+
+// Scoped arenas: named groups of heap blocks with usage accounting, e.g. "game",
+// "level", "room-transient". psram_arena_push() makes an arena current (they nest)
+// and psram_arena_malloc() allocates into the current one; with no arena pushed it
+// is psram_malloc(). Arena blocks are released with psram_free() as usual;
+// psram_arena_reset() frees everything still left in an arena in one call.
+#define PSRAM_ARENA_MAX 8
+#define PSRAM_ARENA_DEPTH 8
+
+// Returns the id of the arena called `name` (a string literal), creating it if needed;
+// -1 if all slots are taken. `budget` (0 = none) only warns and counts when exceeded.
+int psram_arena_create(const char *name, size_t budget);
+bool psram_arena_push(int id);
+void psram_arena_pop(int id);     // `id` must be the top of the stack
+int psram_arena_current(void);    // -1 when no arena is pushed
+void *psram_arena_malloc(size_t size, mem_cat_t cat);
+void psram_arena_reset(int id);   // Frees every live block of the arena
+int psram_arena_of(const void *ptr);  // Arena of a heap block, -1 for any other pointer
+
+// Called by psram_arena_reset() before it frees anything, so the owner of structured
+// blocks (SDL surfaces) can release its leftovers properly first.
+typedef void (*psram_arena_reset_hook_t)(int id);
+void psram_arena_set_reset_hook(psram_arena_reset_hook_t hook);
+
+typedef struct {
+    const char *name;
+    uint32_t budget;
+    uint32_t used;          // Heap bytes held, including block headers
+    uint32_t high_water;
+    uint32_t blocks;        // Live blocks
+    uint32_t over_budget;   // Allocations made while above budget
+    uint32_t resets;
+    int depth;              // Position on the arena stack, -1 if not pushed
+} psram_arena_stats_t;
+
+bool psram_arena_get_stats(int id, psram_arena_stats_t *out);
+int psram_arena_count(void);
+
+// Allocation categories (mem_telemetry.h). While a category scope is set, heap
+// allocations count against it instead of their call site's category, so a loader can
+// attribute everything it allocates. Returns the previous scope (restore it after);
+// MEM_CAT_OTHER means no scope.
+mem_cat_t psram_set_category(mem_cat_t cat);
+void psram_get_telemetry(mem_tel_pool_t *out);
+
+// Prints per-category PSRAM usage, fixed regions, arenas and SRAM heap usage to the
+// serial console; `reset_high_water` then lowers the high-water marks to current usage.
+void psram_dump_telemetry(bool reset_high_water);
+
 #endif
@@ -0,0 +1,318 @@
+#ifndef PSRAM_TLSF_H
+#define PSRAM_TLSF_H
+
+// Two-level segregated fit (TLSF) heap: O(1) malloc and free with immediate
+// coalescing of neighbouring free blocks. Used by psram_allocator.c over PSRAM.
+//
+// Blocks are addressed by 32-bit offsets from the pool base, so the same code runs on
+// the host (tools/psram_stress.c) against an ordinary buffer. Every block starts with
+// an 8-byte header: offset of the previous physical block, then the payload size
+// (a multiple of 8) with flags in the low bits. A free block keeps its free-list links
+// in the first 8 payload bytes. A zero-size used block terminates the pool.
+//
+// Plain C, no Pico SDK and no locking: the caller serialises access.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define TLSF_ALIGN 8u
+#define TLSF_HDR 8u
+#define TLSF_MIN_PAYLOAD 8u
+#define TLSF_SL_LOG2 4
+#define TLSF_SL_COUNT (1 << TLSF_SL_LOG2)
+#define TLSF_FL_SHIFT (TLSF_SL_LOG2 + 3)              // log2(TLSF_SL_COUNT * TLSF_ALIGN)
+#define TLSF_SMALL_SIZE (1u << TLSF_FL_SHIFT)         // Sizes below this share first level 0
+#define TLSF_FL_COUNT 20                              // Up to 2^(20 + 6) bytes per block
+#define TLSF_NONE 0xFFFFFFFFu
+
+#define TLSF_FLAG_FREE 1u
+#define TLSF_FLAG_TAG 2u      // Caller-defined marker (session arena); see tlsf_free_tagged()
+#define TLSF_FLAG_USER 4u     // Never set by the heap: callers may use it in their own headers
+#define TLSF_FLAG_MASK 7u
+
+typedef struct {
+    uint8_t *base;
+    uint32_t pool_size;
+    uint32_t fl_bitmap;
+    uint32_t sl_bitmap[TLSF_FL_COUNT];
+    uint32_t heads[TLSF_FL_COUNT][TLSF_SL_COUNT];
+
+    uint32_t used;        // Payload bytes of allocated blocks (plus headers)
+    uint32_t high_water;
+    uint32_t allocs;      // Live allocation count
+    uint32_t failures;
+} tlsf_t;
+
+typedef struct {
+    uint32_t prev_phys;
+    uint32_t size;        // Payload size | flags
+} tlsf_hdr_t;
+
+static inline tlsf_hdr_t *tlsf_hdr(const tlsf_t *t, uint32_t off) {
+    return (tlsf_hdr_t *)(t->base + off);
+}
+static inline uint32_t *tlsf_links(const tlsf_t *t, uint32_t off) {
+    return (uint32_t *)(t->base + off + TLSF_HDR);  // [0] next free, [1] prev free
+}
+static inline uint32_t tlsf_size(const tlsf_hdr_t *h) {
+    return h->size & ~TLSF_FLAG_MASK;
+}
+static inline uint32_t tlsf_next_phys(const tlsf_t *t, uint32_t off) {
+    return off + TLSF_HDR + tlsf_size(tlsf_hdr(t, off));
+}
+
+static inline int tlsf_fls(uint32_t x) {
+    return 31 - __builtin_clz(x);
+}
+static inline int tlsf_ffs(uint32_t x) {
+    return __builtin_ctz(x);
+}
+
+static inline void tlsf_mapping(uint32_t size, int *fl, int *sl) {
+    if (size < TLSF_SMALL_SIZE) {
+        *fl = 0;
+        *sl = (int)(size / (TLSF_SMALL_SIZE / TLSF_SL_COUNT));
+    } else {
+        const int f = tlsf_fls(size);
+        *sl = (int)((size >> (f - TLSF_SL_LOG2)) ^ (1u << TLSF_SL_LOG2));
+        *fl = f - (TLSF_FL_SHIFT - 1);
+    }
+}
+
+static inline void tlsf_insert(tlsf_t *t, uint32_t off) {
+    int fl, sl;
+    tlsf_mapping(tlsf_size(tlsf_hdr(t, off)), &fl, &sl);
+    const uint32_t head = t->heads[fl][sl];
+    uint32_t *links = tlsf_links(t, off);
+    links[0] = head;
+    links[1] = TLSF_NONE;
+    if (head != TLSF_NONE) tlsf_links(t, head)[1] = off;
+    t->heads[fl][sl] = off;
+    t->fl_bitmap |= 1u << fl;
+    t->sl_bitmap[fl] |= 1u << sl;
+}
+
+static inline void tlsf_remove(tlsf_t *t, uint32_t off) {
+    int fl, sl;
+    tlsf_mapping(tlsf_size(tlsf_hdr(t, off)), &fl, &sl);
+    const uint32_t *links = tlsf_links(t, off);
+    const uint32_t next = links[0], prev = links[1];
+    if (next != TLSF_NONE) tlsf_links(t, next)[1] = prev;
+    if (prev != TLSF_NONE) {
+        tlsf_links(t, prev)[0] = next;
+    } else {
+        t->heads[fl][sl] = next;
+        if (next == TLSF_NONE) {
+            t->sl_bitmap[fl] &= ~(1u << sl);
+            if (!t->sl_bitmap[fl]) t->fl_bitmap &= ~(1u << fl);
+        }
+    }
+}
+
+// `pool` must be 8-byte aligned; `size` at least 64 bytes.
+static inline void tlsf_init(tlsf_t *t, void *pool, uint32_t size) {
+    memset(t, 0, sizeof(*t));
+    memset(t->heads, 0xFF, sizeof(t->heads));
+    t->base = (uint8_t *)pool;
+    t->pool_size = size & ~(TLSF_ALIGN - 1);
+
+    // One free block spanning the pool, then the zero-size sentinel.
+    const uint32_t sentinel = t->pool_size - TLSF_HDR;
+    tlsf_hdr_t *first = tlsf_hdr(t, 0);
+    first->prev_phys = TLSF_NONE;
+    first->size = (sentinel - TLSF_HDR) | TLSF_FLAG_FREE;
+    tlsf_hdr_t *end = tlsf_hdr(t, sentinel);
+    end->prev_phys = 0;
+    end->size = 0;
+    tlsf_insert(t, 0);
+}
+
+static inline uint32_t tlsf_adjust(size_t size) {
+    if (size < TLSF_MIN_PAYLOAD) size = TLSF_MIN_PAYLOAD;
+    return (uint32_t)((size + TLSF_ALIGN - 1) & ~(size_t)(TLSF_ALIGN - 1));
+}
+
+// Returns NULL when no free block is large enough. `tag` sets TLSF_FLAG_TAG.
+static inline void *tlsf_malloc(tlsf_t *t, size_t request, bool tag) {
+    if (request == 0 || request > (1u << 30)) return NULL;
+    const uint32_t size = tlsf_adjust(request);
+
+    // Round up to the next list boundary so any block found there is big enough.
+    uint32_t search = size;
+    if (search >= TLSF_SMALL_SIZE) search += (1u << (tlsf_fls(search) - TLSF_SL_LOG2)) - 1;
+    int fl, sl;
+    tlsf_mapping(search, &fl, &sl);
+    if (fl >= TLSF_FL_COUNT) {
+        t->failures++;
+        return NULL;
+    }
+    uint32_t sl_map = t->sl_bitmap[fl] & (~0u << sl);
+    if (!sl_map) {
+        const uint32_t fl_map = (fl + 1 < 32) ? (t->fl_bitmap & (~0u << (fl + 1))) : 0;
+        if (!fl_map) {
+            t->failures++;
+            return NULL;
+        }
+        fl = tlsf_ffs(fl_map);
+        sl_map = t->sl_bitmap[fl];
+    }
+    sl = tlsf_ffs(sl_map);
+    const uint32_t off = t->heads[fl][sl];
+    tlsf_remove(t, off);
+
+    tlsf_hdr_t *h = tlsf_hdr(t, off);
+    const uint32_t have = tlsf_size(h);
+    if (have >= size + TLSF_HDR + TLSF_MIN_PAYLOAD) {
+        // Split: the tail becomes a new free block.
+        const uint32_t rest = off + TLSF_HDR + size;
+        tlsf_hdr_t *r = tlsf_hdr(t, rest);
+        r->prev_phys = off;
+        r->size = (have - size - TLSF_HDR) | TLSF_FLAG_FREE;
+        tlsf_hdr(t, tlsf_next_phys(t, rest))->prev_phys = rest;
+        h->size = size;
+        tlsf_insert(t, rest);
+    } else {
+        h->size = have;
+    }
+    if (tag) h->size |= TLSF_FLAG_TAG;
+
+    t->used += tlsf_size(h) + TLSF_HDR;
+    if (t->used > t->high_water) t->high_water = t->used;
+    t->allocs++;
+    return t->base + off + TLSF_HDR;
+}
+
+static inline bool tlsf_owns(const tlsf_t *t, const void *ptr) {
+    return (const uint8_t *)ptr >= t->base + TLSF_HDR && (const uint8_t *)ptr < t->base + t->pool_size;
+}
+
+static inline uint32_t tlsf_block_size(const tlsf_t *t, const void *ptr) {
+    return tlsf_size(tlsf_hdr(t, (uint32_t)((const uint8_t *)ptr - t->base) - TLSF_HDR));
+}
+
+static inline void tlsf_free(tlsf_t *t, void *ptr) {
+    uint32_t off = (uint32_t)((uint8_t *)ptr - t->base) - TLSF_HDR;
+    tlsf_hdr_t *h = tlsf_hdr(t, off);
+    if (h->size & TLSF_FLAG_FREE) return;  // Double free: ignore
+
+    t->used -= tlsf_size(h) + TLSF_HDR;
+    t->allocs--;
+    h->size = tlsf_size(h) | TLSF_FLAG_FREE;
+
+    // Coalesce with the next and previous physical blocks.
+    const uint32_t next = tlsf_next_phys(t, off);
+    tlsf_hdr_t *n = tlsf_hdr(t, next);
+    if (n->size & TLSF_FLAG_FREE) {
+        tlsf_remove(t, next);
+        h->size = (tlsf_size(h) + TLSF_HDR + tlsf_size(n)) | TLSF_FLAG_FREE;
+    }
+    if (h->prev_phys != TLSF_NONE) {
+        tlsf_hdr_t *p = tlsf_hdr(t, h->prev_phys);
+        if (p->size & TLSF_FLAG_FREE) {
+            tlsf_remove(t, h->prev_phys);
+            p->size = (tlsf_size(p) + TLSF_HDR + tlsf_size(h)) | TLSF_FLAG_FREE;
+            off = h->prev_phys;
+            h = p;
+        }
+    }
+    tlsf_hdr(t, tlsf_next_phys(t, off))->prev_phys = off;
+    tlsf_insert(t, off);
+}
+
+// Grow in place by absorbing a free successor; returns false if that is not possible.
+static inline bool tlsf_grow_in_place(tlsf_t *t, void *ptr, size_t request) {
+    const uint32_t off = (uint32_t)((uint8_t *)ptr - t->base) - TLSF_HDR;
+    tlsf_hdr_t *h = tlsf_hdr(t, off);
+    const uint32_t size = tlsf_adjust(request);
+    const uint32_t have = tlsf_size(h);
+    if (have >= size) return true;
+    const uint32_t next = tlsf_next_phys(t, off);
+    tlsf_hdr_t *n = tlsf_hdr(t, next);
+    if (!(n->size & TLSF_FLAG_FREE) || have + TLSF_HDR + tlsf_size(n) < size) return false;
+
+    tlsf_remove(t, next);
+    const uint32_t total = have + TLSF_HDR + tlsf_size(n);
+    const uint32_t flags = h->size & TLSF_FLAG_TAG;
+    if (total >= size + TLSF_HDR + TLSF_MIN_PAYLOAD) {
+        const uint32_t rest = off + TLSF_HDR + size;
+        tlsf_hdr_t *r = tlsf_hdr(t, rest);
+        r->prev_phys = off;
+        r->size = (total - size - TLSF_HDR) | TLSF_FLAG_FREE;
+        tlsf_hdr(t, tlsf_next_phys(t, rest))->prev_phys = rest;
+        tlsf_insert(t, rest);
+        h->size = size | flags;
+    } else {
+        h->size = total | flags;
+        tlsf_hdr(t, tlsf_next_phys(t, off))->prev_phys = off;
+    }
+    t->used += tlsf_size(h) - have;
+    if (t->used > t->high_water) t->high_water = t->used;
+    return true;
+}
+
+// Free every allocated block carrying TLSF_FLAG_TAG (walks the pool once), calling
+// `on_free` (optional) with each block's payload first.
+// Returns the number of payload bytes released.
+static inline uint32_t tlsf_free_tagged(tlsf_t *t, void (*on_free)(void *ctx, void *payload), void *ctx) {
+    uint32_t released = 0;
+    uint32_t off = 0;
+    while (tlsf_size(tlsf_hdr(t, off)) != 0) {
+        tlsf_hdr_t *h = tlsf_hdr(t, off);
+        if ((h->size & (TLSF_FLAG_TAG | TLSF_FLAG_FREE)) == TLSF_FLAG_TAG) {
+            released += tlsf_size(h);
+            const uint32_t prev = h->prev_phys;
+            if (on_free) on_free(ctx, t->base + off + TLSF_HDR);
+            tlsf_free(t, t->base + off + TLSF_HDR);
+            // Merged into a free predecessor: continue from there.
+            if (prev != TLSF_NONE && (tlsf_hdr(t, prev)->size & TLSF_FLAG_FREE) &&
+                tlsf_next_phys(t, prev) > off) {
+                off = prev;
+            }
+        }
+        off = tlsf_next_phys(t, off);
+    }
+    return released;
+}
+
+typedef struct {
+    uint32_t free_bytes;
+    uint32_t largest_free;
+    uint32_t free_blocks;
+    uint32_t used_blocks;
+    bool ok;              // Headers, links and bitmaps are consistent
+} tlsf_walk_t;
+
+// Consistency check and fragmentation summary (O(blocks); for diagnostics only).
+static inline tlsf_walk_t tlsf_walk(const tlsf_t *t) {
+    tlsf_walk_t w = {0, 0, 0, 0, true};
+    uint32_t off = 0, prev = TLSF_NONE;
+    bool prev_free = false;
+    while (off < t->pool_size) {
+        const tlsf_hdr_t *h = tlsf_hdr(t, off);
+        if (h->prev_phys != prev) w.ok = false;
+        const uint32_t size = tlsf_size(h);
+        if (size == 0) break;
+        if (h->size & TLSF_FLAG_FREE) {
+            if (prev_free) w.ok = false;  // Two adjacent free blocks: missed coalesce
+            int fl, sl;
+            tlsf_mapping(size, &fl, &sl);
+            if (!(t->sl_bitmap[fl] & (1u << sl))) w.ok = false;
+            w.free_bytes += size;
+            w.free_blocks++;
+            if (size > w.largest_free) w.largest_free = size;
+            prev_free = true;
+        } else {
+            w.used_blocks++;
+            prev_free = false;
+        }
+        prev = off;
+        off += TLSF_HDR + size;
+    }
+    if (off != t->pool_size - TLSF_HDR) w.ok = false;
+    if (w.used_blocks != t->allocs) w.ok = false;
+    return w;
+}
+
+#endif // PSRAM_TLSF_H
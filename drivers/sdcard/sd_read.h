@@ -0,0 +1,152 @@
+#ifndef SD_READ_H
+#define SD_READ_H
+
+// Sector read state machine for SD cards in SPI mode (CMD17 / CMD18).
+//
+// The command and the per-block token wait are a few bytes each and are exchanged by
+// the CPU; the 512 data bytes of every block go through io->rx_start(), which the
+// driver backs with DMA, so the CPU is free while a block streams in. One sd_read_step()
+// exchanges at most SD_READ_TOKEN_POLLS token bytes, a CRC trailer and a stop command.
+//
+// Plain C, no Pico SDK: sdcard.c plugs in the SPI/PIO/DMA hooks, tools/sd_read_sim.c a
+// mock card.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SD_READ_CMD12 12            // STOP_TRANSMISSION
+#define SD_READ_CMD17 17            // READ_SINGLE_BLOCK
+#define SD_READ_CMD18 18            // READ_MULTIPLE_BLOCK
+#define SD_READ_TOKEN_START 0xFE
+#define SD_READ_BLOCK 512
+
+#ifndef SD_READ_TOKEN_TIMEOUT_MS
+#define SD_READ_TOKEN_TIMEOUT_MS 200
+#endif
+#ifndef SD_READ_TOKEN_POLLS
+#define SD_READ_TOKEN_POLLS 16      // Token bytes polled per step
+#endif
+
+typedef struct {
+    void *ctx;
+    uint8_t (*send_cmd)(void *ctx, uint8_t cmd, uint32_t arg);  // Selects the card, returns R1
+    uint8_t (*xchg)(void *ctx, uint8_t byte);
+    void (*rx_start)(void *ctx, uint8_t *dst, uint32_t len);    // Clock in len bytes (0xFF out)
+    bool (*rx_busy)(void *ctx);
+    void (*deselect)(void *ctx);
+    uint32_t (*millis)(void *ctx);
+} sd_read_io_t;
+
+typedef enum {
+    SD_READ_IDLE = 0,
+    SD_READ_BUSY,
+    SD_READ_OK,
+    SD_READ_ERROR,
+} sd_read_status_t;
+
+typedef enum {
+    SD_READ_ERR_NONE = 0,
+    SD_READ_ERR_CMD,                // Command rejected (R1 != 0)
+    SD_READ_ERR_TIMEOUT,            // No data token in time
+    SD_READ_ERR_TOKEN,              // Data error token (out of range, ECC, ...)
+    SD_READ_ERR_CRC,                // Block CRC16 mismatch (only with check_crc)
+} sd_read_err_t;
+
+typedef struct {
+    const sd_read_io_t *io;
+    uint8_t *buff;
+    uint32_t left;                  // Blocks still to receive
+    uint32_t t0;                    // Token wait start (ms)
+    uint16_t crc;                   // CRC16 trailer of the last block received
+    uint8_t r1;                     // Response to the read command
+    uint8_t token;                  // Last non-0xFF byte seen while waiting for a token
+    bool multi;
+    bool check_crc;
+    bool in_data;                   // Block transfer in flight (else waiting for its token)
+    sd_read_status_t status;
+    sd_read_err_t err;
+} sd_read_t;
+
+// CRC16-CCITT (polynomial 0x1021, initial 0) as the card computes it over a data block.
+static inline uint16_t sd_crc16(const uint8_t *data, uint32_t len) {
+    uint16_t crc = 0;
+    for (uint32_t i = 0; i < len; ++i) {
+        crc = (uint16_t)((uint8_t)(crc >> 8) | (crc << 8));
+        crc ^= data[i];
+        crc ^= (uint8_t)(crc & 0xFF) >> 4;
+        crc ^= (uint16_t)(crc << 12);
+        crc ^= (uint16_t)((crc & 0xFF) << 5);
+    }
+    return crc;
+}
+
+static inline void sd_read_finish(sd_read_t *r, sd_read_err_t err) {
+    const sd_read_io_t *io = r->io;
+    if (r->multi) io->send_cmd(io->ctx, SD_READ_CMD12, 0);
+    io->deselect(io->ctx);
+    r->err = err;
+    r->status = err ? SD_READ_ERROR : SD_READ_OK;
+}
+
+// `addr` is the card address: the sector for block-addressed cards, bytes otherwise.
+// `check_crc` verifies every block against its CRC16 trailer.
+static inline sd_read_status_t sd_read_start(sd_read_t *r, const sd_read_io_t *io, uint8_t *buff, uint32_t addr,
+                                             uint32_t count, bool check_crc) {
+    r->io = io;
+    r->buff = buff;
+    r->left = count;
+    r->multi = count > 1;
+    r->check_crc = check_crc;
+    r->in_data = false;
+    r->crc = 0;
+    r->token = 0xFF;
+    r->err = SD_READ_ERR_NONE;
+    r->r1 = io->send_cmd(io->ctx, r->multi ? SD_READ_CMD18 : SD_READ_CMD17, addr);
+    if (r->r1 != 0) {
+        r->multi = false;           // Nothing to stop
+        sd_read_finish(r, SD_READ_ERR_CMD);
+        return r->status;
+    }
+    r->t0 = io->millis(io->ctx);
+    r->status = SD_READ_BUSY;
+    return r->status;
+}
+
+static inline sd_read_status_t sd_read_step(sd_read_t *r) {
+    if (r->status != SD_READ_BUSY) return r->status;
+    const sd_read_io_t *io = r->io;
+
+    if (r->in_data) {
+        if (io->rx_busy(io->ctx)) return SD_READ_BUSY;
+        r->crc = (uint16_t)(io->xchg(io->ctx, 0xFF) << 8);
+        r->crc |= io->xchg(io->ctx, 0xFF);
+        r->in_data = false;
+        if (r->check_crc && r->crc != sd_crc16(r->buff, SD_READ_BLOCK)) {
+            sd_read_finish(r, SD_READ_ERR_CRC);
+            return r->status;
+        }
+        r->buff += SD_READ_BLOCK;
+        if (--r->left == 0) {
+            sd_read_finish(r, SD_READ_ERR_NONE);
+            return r->status;
+        }
+        r->t0 = io->millis(io->ctx);
+    }
+
+    for (int i = 0; i < SD_READ_TOKEN_POLLS; ++i) {
+        const uint8_t token = io->xchg(io->ctx, 0xFF);
+        if (token == 0xFF) continue;
+        r->token = token;
+        if (token != SD_READ_TOKEN_START) {
+            sd_read_finish(r, SD_READ_ERR_TOKEN);
+            return r->status;
+        }
+        io->rx_start(io->ctx, r->buff, SD_READ_BLOCK);
+        r->in_data = true;
+        return SD_READ_BUSY;
+    }
+    if (io->millis(io->ctx) - r->t0 >= SD_READ_TOKEN_TIMEOUT_MS) sd_read_finish(r, SD_READ_ERR_TIMEOUT);
+    return r->status;
+}
+
+#endif // SD_READ_H
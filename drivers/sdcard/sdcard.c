@@ -1,5 +1,7 @@
 #include "sdcard.h"
 
+#include <string.h>
+
 #include "pico.h"
 #include "pico/stdlib.h"
 #include "hardware/clocks.h"
@@ -9,10 +11,12 @@
 #include "pio_spi.h"
 #endif
 #include "hardware/gpio.h"
+#include "hardware/dma.h"
 //#include "hardware/gpio_ex.h"
 
 #include "ff.h"
 #include "diskio.h"
+#include "sd_read.h"
 
 
 /*--------------------------------------------------------------------------
@@ -24,6 +28,7 @@
 /* MMC/SD command */
 #define CMD0	(0)			/* GO_IDLE_STATE */
 #define CMD1	(1)			/* SEND_OP_COND (MMC) */
+#define CMD6	(6)			/* SWITCH_FUNC (SDC) */
 #define	ACMD41	(0x80+41)	/* SEND_OP_COND (SDC) */
 #define CMD8	(8)			/* SEND_IF_COND */
 #define CMD9	(9)			/* SEND_CSD */
@@ -51,7 +56,24 @@
 #define CT_BLOCK       0x08            /* Block addressing */
 
 #define CLK_SLOW	(100 * KHZ)
-#define CLK_FAST	(30 * MHZ)
+#define CLK_FAST	(30 * MHZ)	/* Ceiling for cards without high-speed mode */
+
+#ifndef SDCARD_MAX_CLK_MHZ
+#define SDCARD_MAX_CLK_MHZ	50	/* Highest SPI clock tried (board / wiring limit) */
+#endif
+#ifndef SDCARD_CHECK_CRC
+#define SDCARD_CHECK_CRC	0	/* CRC16-check every read, at any clock */
+#endif
+#ifndef SDCARD_CRC_SAMPLE
+#define SDCARD_CRC_SAMPLE	16	/* Within TRAN_SPEED, CRC16-check one read in this many (0 = none) */
+#endif
+#ifndef SDCARD_READ_RETRIES
+#define SDCARD_READ_RETRIES	2	/* Retries of a failed read, each one clock step lower */
+#endif
+#ifndef SDCARD_PIO_CLKDIV
+#define SDCARD_PIO_CLKDIV	8.0f	/* clk_sys / (2 * div); slow for HDMI stability */
+#endif
+#define SDCARD_CLK_TEST_READS	16	/* CRC-checked sector reads per step of the clock test */
 
 static volatile
 DSTATUS Stat = STA_NOINIT;	/* Physical drive status */
@@ -94,13 +116,6 @@ static void FCLK_SLOW(void)
 #endif
 }
 
-static void FCLK_FAST(void)
-{
-#ifndef SDCARD_PIO
-    spi_set_baudrate(SDCARD_SPI_BUS, CLK_FAST);
-#endif
-}
-
 static void CS_HIGH(void)
 {
     cs_deselect(SDCARD_PIN_SPI0_CS);
@@ -111,6 +126,8 @@ static void CS_LOW(void)
     cs_select(SDCARD_PIN_SPI0_CS);
 }
 
+static void sd_dma_init(void);
+
 /* Initialize MMC interface */
 static
 void init_spi(void)
@@ -162,7 +179,7 @@ void init_spi(void)
 
 	// Slower clock to reduce bus contention with HDMI DMA
 	// Original was 3.0f (~40MHz), now 8.0f (~15MHz) for HDMI stability
-	float clkdiv = 8.0f;
+	float clkdiv = SDCARD_PIO_CLKDIV;
 	int cpol = 0;
 	int cpha = 0;
 	uint cpha0_prog_offs = pio_add_program(pio_spi.pio, &spi_cpha0_program);
@@ -177,6 +194,7 @@ void init_spi(void)
 				SDCARD_PIN_SPI0_MISO
 	);
 #endif
+	sd_dma_init();
 }
 
 /* Exchange a byte */
@@ -211,6 +229,75 @@ void rcvr_spi_multi (
 }
 
 
+/*-----------------------------------------------------------------------*/
+/* DMA block receive                                                     */
+/*-----------------------------------------------------------------------*/
+
+/* A TX channel clocks out 0xFF from one fixed byte while an RX channel drains the FIFO
+   into the buffer, both paced by the SPI / PIO DREQs. Normal priority, so HDMI scanout
+   DMA keeps precedence. Without free channels the blocking receive is used. */
+static int sd_dma_tx = -1;
+static int sd_dma_rx = -1;
+static uint8_t sd_dma_ones = 0xFF;
+
+static void sd_dma_init(void)
+{
+	if (sd_dma_rx >= 0) return;
+	const int tx = dma_claim_unused_channel(false);
+	if (tx < 0) return;
+	const int rx = dma_claim_unused_channel(false);
+	if (rx < 0) {
+		dma_channel_unclaim((uint)tx);
+		return;
+	}
+	sd_dma_tx = tx;
+	sd_dma_rx = rx;
+}
+
+static void sd_dma_rx_start(void *ctx, uint8_t *dst, uint32_t len)
+{
+	(void)ctx;
+	if (sd_dma_rx < 0) {
+		rcvr_spi_multi(dst, len);
+		return;
+	}
+#ifndef SDCARD_PIO
+	volatile void *txfifo = &spi_get_hw(SDCARD_SPI_BUS)->dr;
+	const volatile void *rxfifo = &spi_get_hw(SDCARD_SPI_BUS)->dr;
+	const uint dreq_tx = spi_get_dreq(SDCARD_SPI_BUS, true);
+	const uint dreq_rx = spi_get_dreq(SDCARD_SPI_BUS, false);
+#else
+	volatile void *txfifo = &pio_spi.pio->txf[pio_spi.sm];
+	const volatile void *rxfifo = &pio_spi.pio->rxf[pio_spi.sm];
+	const uint dreq_tx = pio_get_dreq(pio_spi.pio, pio_spi.sm, true);
+	const uint dreq_rx = pio_get_dreq(pio_spi.pio, pio_spi.sm, false);
+#endif
+	dma_channel_config c = dma_channel_get_default_config((uint)sd_dma_rx);
+	channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+	channel_config_set_read_increment(&c, false);
+	channel_config_set_write_increment(&c, true);
+	channel_config_set_dreq(&c, dreq_rx);
+	channel_config_set_high_priority(&c, false);
+	dma_channel_configure((uint)sd_dma_rx, &c, dst, rxfifo, len, false);
+
+	c = dma_channel_get_default_config((uint)sd_dma_tx);
+	channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+	channel_config_set_read_increment(&c, false);
+	channel_config_set_write_increment(&c, false);
+	channel_config_set_dreq(&c, dreq_tx);
+	channel_config_set_high_priority(&c, false);
+	dma_channel_configure((uint)sd_dma_tx, &c, txfifo, &sd_dma_ones, len, false);
+
+	dma_start_channel_mask((1u << sd_dma_rx) | (1u << sd_dma_tx));
+}
+
+static bool sd_dma_rx_busy(void *ctx)
+{
+	(void)ctx;
+	return sd_dma_rx >= 0 && dma_channel_is_busy((uint)sd_dma_rx);
+}
+
+
 /*-----------------------------------------------------------------------*/
 /* Wait for card ready                                                   */
 /*-----------------------------------------------------------------------*/
@@ -336,6 +423,207 @@ BYTE send_cmd (		/* Return value: R1 resp (bit7==1:Failed to send) */
 	return res;							/* Return received response */
 }
 
+/*-----------------------------------------------------------------------*/
+/* Asynchronous read state (sd_read.h)                                   */
+/*-----------------------------------------------------------------------*/
+
+static uint8_t sd_io_send_cmd(void *ctx, uint8_t cmd, uint32_t arg) { (void)ctx; return send_cmd(cmd, arg); }
+static uint8_t sd_io_xchg(void *ctx, uint8_t dat) { (void)ctx; return xchg_spi(dat); }
+static void sd_io_deselect(void *ctx) { (void)ctx; deselect(); }
+static uint32_t sd_io_millis(void *ctx) { (void)ctx; return _millis(); }
+
+static const sd_read_io_t sd_read_io = {
+	.ctx = NULL,
+	.send_cmd = sd_io_send_cmd,
+	.xchg = sd_io_xchg,
+	.rx_start = sd_dma_rx_start,
+	.rx_busy = sd_dma_rx_busy,
+	.deselect = sd_io_deselect,
+	.millis = sd_io_millis,
+};
+
+static sd_read_t sd_rd;
+static disk_read_cb_t sd_rd_cb;
+static void *sd_rd_ctx;
+static BYTE *sd_rd_buff;		/* The read in flight, for retries */
+static DWORD sd_rd_addr;
+static UINT sd_rd_count;
+static BYTE sd_rd_tries;
+static DWORD sd_rd_serial;		/* Reads started, for CRC sampling */
+
+
+/*-----------------------------------------------------------------------*/
+/* Bus clock negotiation                                                 */
+/*-----------------------------------------------------------------------*/
+
+/* Step-up ladder. The first entry is the floor: used for the CSD / CMD6 exchanges and
+   never stepped below. */
+static const BYTE sd_clk_steps_mhz[] = { 12, 20, 25, 30, 36, 40, 45, 50, 62 };
+#define SD_CLK_STEPS	(int)(sizeof(sd_clk_steps_mhz) / sizeof(sd_clk_steps_mhz[0]))
+
+static int sd_clk_step;
+static sd_clock_info_t sd_info;
+
+static
+void sd_clock_set (
+	int step		/* Index into sd_clk_steps_mhz */
+)
+{
+	sd_clk_step = step;
+#ifndef SDCARD_PIO
+	sd_info.clk_hz = spi_set_baudrate(SDCARD_SPI_BUS, sd_clk_steps_mhz[step] * MHZ);
+#else
+	sd_info.clk_hz = (DWORD)(clock_get_hz(clk_sys) / (2.0f * SDCARD_PIO_CLKDIV));	/* Fixed divider */
+#endif
+}
+
+/* One step down after a read error; false if already at the floor */
+static
+bool sd_clock_step_down (void)
+{
+	if (sd_clk_step == 0) return false;
+	sd_clock_set(sd_clk_step - 1);
+	sd_info.fallbacks++;
+	return true;
+}
+
+/* TRAN_SPEED (CSD byte 3): transfer rate unit x time value */
+static
+DWORD sd_tran_speed_hz (
+	BYTE ts
+)
+{
+	static const BYTE value10[16] = { 0, 10, 12, 13, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60, 70, 80 };
+	static const DWORD unit[4] = { 10 * KHZ, 100 * KHZ, 1 * MHZ, 10 * MHZ };	/* 100k/1M/10M/100M bit/s, / 10 */
+	return unit[(ts & 7) > 3 ? 3 : (ts & 7)] * value10[(ts >> 3) & 15];
+}
+
+static
+int sd_read_csd (	/* 1:OK, 0:Error */
+	BYTE *csd		/* 16 bytes */
+)
+{
+	const int ok = (send_cmd(CMD9, 0) == 0) && rcvr_datablock(csd, 16);
+	deselect();
+	return ok;
+}
+
+/* CMD6: query, then switch function group 1 (access mode) to high speed */
+static
+int sd_switch_high_speed (void)	/* 1:Switched, 0:Not supported / failed */
+{
+	BYTE sw[64];	/* 512-bit switch function status */
+
+	if (send_cmd(CMD6, 0x00FFFFF1) != 0 || !rcvr_datablock(sw, 64)) {	/* Check mode */
+		deselect();
+		return 0;
+	}
+	deselect();
+	if (!(sw[13] & 0x02)) return 0;		/* Group 1 function 1 not supported */
+
+	if (send_cmd(CMD6, 0x80FFFFF1) != 0 || !rcvr_datablock(sw, 64)) {	/* Switch mode */
+		deselect();
+		return 0;
+	}
+	deselect();						/* Also the 8 clocks the switch needs */
+	return (sw[16] & 0x0F) == 1;	/* Group 1 now on function 1 */
+}
+
+/* CRC-checked single-block reads of the first sectors at the current clock */
+static
+int sd_clock_test (void)	/* 1:Passed, 0:Failed */
+{
+	BYTE buf[512];
+	sd_read_t r;
+
+	for (DWORD s = 0; s < SDCARD_CLK_TEST_READS; s++) {
+		sd_read_start(&r, &sd_read_io, buf, (CardType & CT_BLOCK) ? s : s * 512, 1, true);
+		while (sd_read_step(&r) == SD_READ_BUSY) tight_loop_contents();
+		if (r.status != SD_READ_OK) return 0;
+	}
+	return 1;
+}
+
+/* Pick the bus clock: card limit from CSD TRAN_SPEED (after trying high-speed mode),
+   then step up while the read test passes. */
+static
+void sd_negotiate_clock (void)
+{
+	BYTE csd[16];
+	DWORD ceiling;
+	int i, top = 0;
+
+	memset(&sd_info, 0, sizeof(sd_info));
+	sd_clock_set(0);
+	if (sd_read_csd(csd)) {
+		sd_info.card_max_hz = sd_tran_speed_hz(csd[3]);
+		/* CCC class 10 (switch) advertised by the card */
+		if ((CardType & CT_SD2) && (csd[4] & 0x40) && sd_switch_high_speed()) {
+			sd_info.high_speed = true;
+			if (sd_read_csd(csd)) sd_info.card_max_hz = sd_tran_speed_hz(csd[3]);	/* Now 50 MHz */
+		}
+	}
+
+	/* Cards without high-speed mode have always run at CLK_FAST here, above their 25 MHz */
+	ceiling = (sd_info.card_max_hz > CLK_FAST) ? sd_info.card_max_hz : CLK_FAST;
+	if (ceiling > SDCARD_MAX_CLK_MHZ * MHZ) ceiling = SDCARD_MAX_CLK_MHZ * MHZ;
+
+#ifndef SDCARD_PIO
+	for (i = 1; i < SD_CLK_STEPS && sd_clk_steps_mhz[i] * MHZ <= ceiling; i++) {
+		sd_clock_set(i);
+		if (!sd_clock_test()) {
+			sd_info.test_failures++;
+			break;
+		}
+		top = i;
+	}
+#else
+	(void)i;
+#endif
+	sd_clock_set(top);
+	sd_info.negotiated_hz = sd_info.clk_hz;
+}
+
+/* READ_SINGLE_BLOCK / READ_MULTIPLE_BLOCK of the stored read; CMD12 and deselect happen
+   when it ends. false if it failed at once. Every read is CRC16-checked while the clock is
+   above the card's TRAN_SPEED, and so are retries. Within TRAN_SPEED the CPU CRC16 would
+   hold up every block, so one read in SDCARD_CRC_SAMPLE is checked: a clock that passed
+   the negotiation test but turns marginal still fails a read and steps down. */
+static
+bool sd_read_issue (void)
+{
+	bool check_crc = SDCARD_CHECK_CRC || sd_rd_tries > 0 || sd_info.clk_hz > sd_info.card_max_hz;
+#if SDCARD_CRC_SAMPLE
+	if (sd_rd_tries == 0 && sd_rd_serial % SDCARD_CRC_SAMPLE == 0) check_crc = true;
+#endif
+	return sd_read_start(&sd_rd, &sd_read_io, sd_rd_buff, sd_rd_addr, sd_rd_count, check_crc) == SD_READ_BUSY;
+}
+
+/* The read failed: count it and, while retries are left, restart it one clock step
+   lower. Address / parameter errors are not retried. true if the read is running again. */
+static
+bool sd_read_recover (void)
+{
+	for (;;) {
+		if (sd_rd.err == SD_READ_ERR_CRC) sd_info.crc_errors++;
+		else sd_info.read_errors++;
+		if (sd_rd.err == SD_READ_ERR_CMD && (sd_rd.r1 & 0x60)) return false;
+		if (sd_rd_tries >= SDCARD_READ_RETRIES) return false;
+		sd_rd_tries++;
+		sd_info.retries++;
+		sd_clock_step_down();
+		if (sd_read_issue()) return true;
+	}
+}
+
+/* Finish the read in flight before the bus is used for anything else */
+static
+void disk_read_wait (void)
+{
+	while (disk_read_poll()) tight_loop_contents();
+}
+
+
 /*--------------------------------------------------------------------------
 
    Public Functions
@@ -357,6 +645,7 @@ DSTATUS disk_initialize (
 
 
 	if (drv) return STA_NOINIT;			/* Supports only drive 0 */
+	disk_read_wait();
 	init_spi();							/* Initialize SPI */
     sleep_ms(10);
 
@@ -393,7 +682,7 @@ DSTATUS disk_initialize (
 	deselect();
 
 	if (ty) {			/* OK */
-		FCLK_FAST();			/* Set fast clock */
+		sd_negotiate_clock();	/* Set fast clock */
 		Stat &= ~STA_NOINIT;	/* Clear STA_NOINIT flag */
 	} else {			/* Failed */
 		Stat = STA_NOINIT;
@@ -423,36 +712,71 @@ DSTATUS disk_status (
 /* Read sector(s)                                                        */
 /*-----------------------------------------------------------------------*/
 
-DRESULT disk_read (
-	BYTE drv,		/* Physical drive number (0) */
-	BYTE *buff,		/* Pointer to the data buffer to store read data */
-	LBA_t sector,	/* Start sector number (LBA) */
-	UINT count		/* Number of sectors to read (1..128) */
+DRESULT disk_read_start (
+	BYTE drv,			/* Physical drive number (0) */
+	BYTE *buff,			/* Pointer to the data buffer to store read data */
+	LBA_t sector,		/* Start sector number (LBA) */
+	UINT count,			/* Number of sectors to read (1..128) */
+	disk_read_cb_t cb,	/* Completion callback (may be NULL) */
+	void *ctx
 )
 {
 	if (drv || !count) return RES_PARERR;		/* Check parameter */
 	if (Stat & STA_NOINIT) return RES_NOTRDY;	/* Check if drive is ready */
 
+	disk_read_wait();
 	if (!(CardType & CT_BLOCK)) sector *= 512;	/* LBA ot BA conversion (byte addressing cards) */
 
-	if (count == 1) {	/* Single sector read */
-		if ((send_cmd(CMD17, sector) == 0)	/* READ_SINGLE_BLOCK */
-			&& rcvr_datablock(buff, 512)) {
-			count = 0;
-		}
-	}
-	else {				/* Multiple sector read */
-		if (send_cmd(CMD18, sector) == 0) {	/* READ_MULTIPLE_BLOCK */
-			do {
-				if (!rcvr_datablock(buff, 512)) break;
-				buff += 512;
-			} while (--count);
-			send_cmd(CMD12, 0);				/* STOP_TRANSMISSION */
-		}
-	}
-	deselect();
+	sd_rd_buff = buff;
+	sd_rd_addr = (DWORD)sector;
+	sd_rd_count = count;
+	sd_rd_tries = 0;
+	sd_rd_serial++;
+	if (!sd_read_issue() && !sd_read_recover()) return RES_ERROR;
+	sd_rd_cb = cb;
+	sd_rd_ctx = ctx;
+	return RES_OK;
+}
 
-	return count ? RES_ERROR : RES_OK;	/* Return result */
+bool disk_read_poll (void)
+{
+	if (sd_rd.status != SD_READ_BUSY) return false;
+	if (sd_read_step(&sd_rd) == SD_READ_BUSY) return true;
+	if (sd_rd.status == SD_READ_ERROR && sd_read_recover()) return true;
+
+	disk_read_cb_t cb = sd_rd_cb;
+	sd_rd_cb = NULL;
+	if (cb) cb(sd_rd.status == SD_READ_OK ? RES_OK : RES_ERROR, sd_rd_ctx);
+	return false;
+}
+
+WORD disk_read_last_crc (void)
+{
+	return sd_rd.crc;
+}
+
+bool disk_read_uses_dma (void)
+{
+	return sd_dma_rx >= 0;
+}
+
+void disk_get_clock_info (sd_clock_info_t *out)
+{
+	if (out) *out = sd_info;
+}
+
+DRESULT disk_read (
+	BYTE drv,		/* Physical drive number (0) */
+	BYTE *buff,		/* Pointer to the data buffer to store read data */
+	LBA_t sector,	/* Start sector number (LBA) */
+	UINT count		/* Number of sectors to read (1..128) */
+)
+{
+	DRESULT res = disk_read_start(drv, buff, sector, count, NULL, NULL);
+	if (res != RES_OK) return res;
+
+	disk_read_wait();
+	return (sd_rd.status == SD_READ_OK) ? RES_OK : RES_ERROR;	/* Return result */
 }
 
 
@@ -519,6 +843,7 @@ DRESULT disk_write (
 	if (drv || !count) return RES_PARERR;		/* Check parameter */
 	if (Stat & STA_NOINIT) return RES_NOTRDY;	/* Check drive status */
 	if (Stat & STA_PROTECT) return RES_WRPRT;	/* Check write protect */
+	disk_read_wait();
 
 	if (!(CardType & CT_BLOCK)) sector *= 512;	/* LBA ==> BA conversion (byte addressing cards) */
 
@@ -564,6 +889,7 @@ DRESULT disk_ioctl (
 
 	if (drv) return RES_PARERR;					/* Check parameter */
 	if (Stat & STA_NOINIT) return RES_NOTRDY;	/* Check if drive is ready */
+	disk_read_wait();
 
 	res = RES_ERROR;
 
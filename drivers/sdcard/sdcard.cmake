@@ -8,6 +8,6 @@ if (NOT TARGET sdcard)
             ${CMAKE_CURRENT_LIST_DIR}/pio_spi.c
     )
 
-    target_link_libraries(sdcard INTERFACE fatfs pico_stdlib hardware_clocks hardware_spi hardware_pio)
+    target_link_libraries(sdcard INTERFACE fatfs pico_stdlib hardware_clocks hardware_spi hardware_pio hardware_dma)
     target_include_directories(sdcard INTERFACE ${CMAKE_CURRENT_LIST_DIR})
 endif ()
@@ -24,4 +24,40 @@
 #define SDCARD_PIN_SPI0_MISO   4
 #endif
 
+#include <stdbool.h>
+#include "ff.h"
+#include "diskio.h"
+
+/* Asynchronous sector read (one at a time). disk_read_start() sends CMD17/CMD18 and
+   returns; the data blocks are received by DMA while disk_read_poll() is called, and
+   `cb` (may be NULL) runs from the poll that completes the read. disk_read() is the
+   same read polled to completion. */
+typedef void (*disk_read_cb_t)(DRESULT res, void *ctx);
+
+DRESULT disk_read_start(BYTE drv, BYTE *buff, LBA_t sector, UINT count, disk_read_cb_t cb, void *ctx);
+bool disk_read_poll(void);	/* true while the read is still in flight */
+
+/* CRC16 trailer of the last data block received, and whether block data is moved by DMA
+   (false if no DMA channels were free: blocking SPI transfers are used instead). */
+WORD disk_read_last_crc(void);
+bool disk_read_uses_dma(void);
+
+/* Bus clock: negotiated in disk_initialize() from CSD TRAN_SPEED and a CMD6 high-speed
+   switch, then stepped up while CRC-checked test reads pass. A failed read is retried
+   one clock step lower (SDCARD_READ_RETRIES times), with CRC checks. Normal reads are
+   CRC-checked above TRAN_SPEED, and one in SDCARD_CRC_SAMPLE within it. */
+typedef struct {
+	DWORD clk_hz;			/* Current SPI clock */
+	DWORD negotiated_hz;	/* Clock chosen at initialization */
+	DWORD card_max_hz;		/* CSD TRAN_SPEED */
+	bool high_speed;		/* Card switched to high-speed mode */
+	DWORD test_failures;	/* Clock steps that failed the read test */
+	DWORD crc_errors;		/* Data blocks with a bad CRC16 (in CRC-checked reads) */
+	DWORD read_errors;		/* Other failed reads: timeouts, error tokens, rejected commands */
+	DWORD retries;
+	DWORD fallbacks;		/* Clock steps down after errors */
+} sd_clock_info_t;
+
+void disk_get_clock_info(sd_clock_info_t *out);
+
 #endif // _SDCARD_H_
@@ -3,11 +3,16 @@
 #include "board_config.h"
 #include "HDMI.h"
 #include "pico/stdlib.h"
+#include "hardware/clocks.h"
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <stdalign.h>
 #include "psram_allocator.h"
 #include "pop_fs.h"
+#include "inverse_cmap.h"
+#include "blit8.h"
+#include "dma_rect.h"
 #include "ps2kbd/ps2kbd_wrapper.h"
 
 // USB HID keyboard support (optional)
@@ -33,7 +38,8 @@ static const char *g_sdl_error = "";
 #endif
 
 #if RP2350_POP_ONSCREEN_PIXELS_IN_SRAM_TEST
-static uint8_t g_pop_onscreen_pixels_sram[320u * 200u];
+// Word-aligned: the HDMI ISR copies scanlines from it 32 bits at a time.
+static alignas(4) uint8_t g_pop_onscreen_pixels_sram[320u * 200u];
 static bool g_pop_onscreen_pixels_in_use = false;
 static bool g_pop_onscreen_pixels_printed = false;
 #endif
@@ -72,14 +78,22 @@ static inline void rp2350_fixup_onscreen_surface_format(SDL_Surface *s, const ch
 #define IS_PSRAM(ptr) ((uintptr_t)(ptr) >= 0x11000000 && (uintptr_t)(ptr) < 0x12000000)
 #define SDL_PALETTE_FLAG_OWNS_COLORS 0x1
 
+// Palette versions are drawn from one sequence, so a (pointer, version) pair never
+// aliases even when a freed palette's memory is reused.
+static Uint32 rp2350_palette_version_seq = 0;
+
+static inline void rp2350_palette_touch(SDL_Palette *pal) {
+    pal->version = ++rp2350_palette_version_seq;
+}
+
 static SDL_Palette *SDL_CreatePaletteInternal(int ncolors) {
-    SDL_Palette *pal = (SDL_Palette *)psram_malloc(sizeof(SDL_Palette));
+    SDL_Palette *pal = (SDL_Palette *)psram_malloc_cat(sizeof(SDL_Palette), MEM_CAT_PALETTE);
     if (!pal) {
         DBG_PRINTF("SDL_CreatePalette: psram_malloc(SDL_Palette) failed\n");
         return NULL;
     }
 
-    pal->colors = (SDL_Color *)psram_malloc(sizeof(SDL_Color) * ncolors);
+    pal->colors = (SDL_Color *)psram_malloc_cat(sizeof(SDL_Color) * ncolors, MEM_CAT_PALETTE);
     if (!pal->colors) {
         DBG_PRINTF("SDL_CreatePalette: psram_malloc(colors) failed (ncolors=%d)\n", ncolors);
         psram_free(pal);
@@ -90,6 +104,7 @@ static SDL_Palette *SDL_CreatePaletteInternal(int ncolors) {
     pal->ncolors = ncolors;
     pal->refcount = 1;
     pal->flags = SDL_PALETTE_FLAG_OWNS_COLORS;
+    rp2350_palette_touch(pal);
     return pal;
 }
 
@@ -138,34 +153,197 @@ static SDL_Palette* get_screen_palette(void) {
     return NULL;
 }
 
+// Shared nearest-colour lookup (see inverse_cmap.h). Slot 0 follows the screen palette,
+// slot 1 whichever other palette was asked for last (image conversion, offscreen targets).
+// Both are rebuilt lazily when the palette's version changes, i.e. on SDL_SetPaletteColors;
+// slot 1 survives a switch to another palette with the same colours (sprite conversion).
+static invcmap_t rp2350_invcmap[2];
+
+static Uint8 rp2350_palette_nearest(const SDL_Palette *palette, int first, int count, Uint8 r, Uint8 g, Uint8 b) {
+    if (!palette || !palette->colors) return 0;
+    if (first < 0) first = 0;
+    if (count > palette->ncolors - first) count = palette->ncolors - first;
+    if (count > 256 - first) count = 256 - first;
+    if (count <= 0) return 0;
+
+    // HDMI scanout reserves 240..243 for control/sync patterns.
+    const bool is_screen_palette = (palette == get_screen_palette());
+    if (is_screen_palette && first >= 240 && first + count <= 244) return 0;
+
+    invcmap_t *m = &rp2350_invcmap[is_screen_palette ? 0 : 1];
+    invcmap_bind(m, palette, palette->version, (const uint8_t *)palette->colors, first, count, is_screen_palette);
+    return invcmap_lookup(m, (const uint8_t *)palette->colors, r, g, b);
+}
+
+Uint8 SDL_PaletteNearestIndex(SDL_Palette *palette, int first, int count, Uint8 r, Uint8 g, Uint8 b) {
+    return rp2350_palette_nearest(palette, first, count, r, g, b);
+}
+
 static Uint8 find_best_palette_index(const SDL_Color *src_color, const SDL_Palette *dst_palette) {
-    int best_distance = INT_MAX;
-    Uint8 best_index = 0;
     if (!dst_palette || dst_palette->ncolors <= 0) {
         return 0;
     }
+    return rp2350_palette_nearest(dst_palette, 0, dst_palette->ncolors, src_color->r, src_color->g, src_color->b);
+}
 
-    const bool is_screen_palette = (dst_palette == get_screen_palette());
+// --- RP2350 reserved-index remap ---
+// HDMI scanout reserves 240..243 for control/sync codes. With zero-copy scanout nothing
+// filters the onscreen surface before the ISR sees it, so writes into it are remapped to
+// the nearest displayable screen-palette entry. Rebuilt lazily after palette changes.
+static Uint8 g_screen_reserved_remap[4] = {255, 255, 255, 255};
+static const SDL_Palette *g_screen_reserved_remap_palette = NULL;
+static bool g_screen_reserved_remap_dirty = true;
 
-    for (int i = 0; i < dst_palette->ncolors; ++i) {
-        // HDMI scanout reserves 240..243 for control/sync patterns.
-        if (is_screen_palette && i >= 240 && i <= 243) {
-            continue;
-        }
-        const SDL_Color *dst_color = &dst_palette->colors[i];
-        int dr = (int)src_color->r - (int)dst_color->r;
-        int dg = (int)src_color->g - (int)dst_color->g;
-        int db = (int)src_color->b - (int)dst_color->b;
-        int distance = dr * dr + dg * dg + db * db;
-        if (distance < best_distance) {
-            best_distance = distance;
-            best_index = (Uint8)i;
-            if (distance == 0) {
-                break;
+static void rp2350_rebuild_reserved_remap(void) {
+    SDL_Palette *pal = get_screen_palette();
+    for (int k = 0; k < 4; ++k) {
+        const int idx = 240 + k;
+        g_screen_reserved_remap[k] = (pal && idx < pal->ncolors)
+            ? find_best_palette_index(&pal->colors[idx], pal)
+            : 255;
+    }
+    g_screen_reserved_remap_palette = pal;
+    g_screen_reserved_remap_dirty = false;
+}
+
+static inline Uint8 rp2350_screen_safe_index(Uint8 idx) {
+    if (idx < 240 || idx > 243) return idx;
+    if (g_screen_reserved_remap_dirty || g_screen_reserved_remap_palette != get_screen_palette()) {
+        rp2350_rebuild_reserved_remap();
+    }
+    return g_screen_reserved_remap[idx - 240];
+}
+
+// SDL_Surface.reserved_scan: whether a surface's pixels hold any of 240..243.
+#define RP2350_RESERVED_UNKNOWN 0
+#define RP2350_RESERVED_NONE 1
+#define RP2350_RESERVED_SOME 2
+
+Uint8 SDL_SurfaceSafeIndex(SDL_Surface *surface, Uint8 index) {
+    if (!surface || surface != onscreen_surface_) return index;
+    return rp2350_screen_safe_index(index);
+}
+
+// --- RP2350 onscreen dirty-span tracking ---
+// During gameplay SDLPoP only redraws a few small regions per frame (see drects in
+// seg008.c), but SDL_UpdateTexture used to copy + filter the whole 320x200 frame.
+// Every write into the onscreen surface (shim blits/fills, SDL_LockSurface, and the
+// RP2350 direct-write paths in seg009.c via SDL_AddDirtyRect) records the touched
+// span per row, and SDL_UpdateTexture only copies those spans.
+#ifndef RP2350_DIRTY_RECT_UPDATES
+#define RP2350_DIRTY_RECT_UPDATES 1
+#endif
+
+#define RP2350_SCREEN_W 320
+#define RP2350_SCREEN_H 200
+#define RP2350_OUTPUT_H 240
+
+// Tear-free presentation for the copy scanout path: SDL_UpdateTexture draws into the
+// HDMI back buffer and queues a page flip performed at vsync (see graphics_present()).
+// Buffers are 320x200 scanned with a 20-line letterbox: the front one lives inside
+// main.c's 320x240 graphics_buffer, the second one below. Zero-copy scanout stays
+// single buffered: SDLPoP redraws incrementally, so the buffer it draws the next frame
+// into would first need this frame's changes, and it is on screen until the flip lands;
+// present would have to wait for vsync every frame.
+#ifndef RP2350_DOUBLE_BUFFER
+#define RP2350_DOUBLE_BUFFER 0
+#endif
+
+#if RP2350_DOUBLE_BUFFER && RP2350_ZERO_COPY_SCANOUT
+#error "RP2350_DOUBLE_BUFFER needs the copy scanout path (RP2350_ZERO_COPY_SCANOUT=0)"
+#endif
+
+#if RP2350_DOUBLE_BUFFER
+#define RP2350_DIRTY_SETS 2
+static alignas(4) uint8_t g_fb_second[RP2350_SCREEN_W * RP2350_SCREEN_H];
+static Uint8 *g_fb_pair[2] = {NULL, g_fb_second};
+#else
+#define RP2350_DIRTY_SETS 1
+#endif
+
+// One span set per scanout buffer: each buffer is behind the onscreen surface by
+// everything drawn since that buffer was last updated.
+typedef struct {
+    uint16_t x0[RP2350_SCREEN_H];  // First dirty column per row
+    uint16_t x1[RP2350_SCREEN_H];  // One past last dirty column (x1 <= x0: clean)
+    int y0;                        // Dirty row bounds [y0, y1)
+    int y1;
+} rp2350_dirty_spans_t;
+
+static rp2350_dirty_spans_t g_dirty[RP2350_DIRTY_SETS];
+static bool g_letterbox_valid = false;        // Top/bottom bands already cleared in framebuffer
+static Uint8 *g_letterbox_fb = NULL;          // Framebuffer the bands were cleared in
+
+static void rp2350_dirty_mark(int x, int y, int w, int h) {
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > RP2350_SCREEN_W) w = RP2350_SCREEN_W - x;
+    if (y + h > RP2350_SCREEN_H) h = RP2350_SCREEN_H - y;
+    if (w <= 0 || h <= 0) return;
+
+    const uint16_t x0 = (uint16_t)x;
+    const uint16_t x1 = (uint16_t)(x + w);
+    for (int set = 0; set < RP2350_DIRTY_SETS; ++set) {
+        rp2350_dirty_spans_t *d = &g_dirty[set];
+        for (int row = y; row < y + h; ++row) {
+            if (d->x1[row] <= d->x0[row]) {
+                d->x0[row] = x0;
+                d->x1[row] = x1;
+            } else {
+                if (x0 < d->x0[row]) d->x0[row] = x0;
+                if (x1 > d->x1[row]) d->x1[row] = x1;
             }
         }
+        if (d->y1 <= d->y0) {
+            d->y0 = y;
+            d->y1 = y + h;
+        } else {
+            if (y < d->y0) d->y0 = y;
+            if (y + h > d->y1) d->y1 = y + h;
+        }
+    }
+}
+
+static inline void rp2350_dirty_mark_all(void) {
+    rp2350_dirty_mark(0, 0, RP2350_SCREEN_W, RP2350_SCREEN_H);
+}
+
+static void rp2350_dirty_clear(rp2350_dirty_spans_t *d) {
+    for (int row = d->y0; row < d->y1; ++row) {
+        d->x0[row] = 0;
+        d->x1[row] = 0;
+    }
+    d->y0 = 0;
+    d->y1 = 0;
+}
+
+// Span set tracking what `fb` is missing.
+static inline rp2350_dirty_spans_t *rp2350_dirty_for(const Uint8 *fb) {
+#if RP2350_DOUBLE_BUFFER
+    return &g_dirty[fb == g_fb_pair[1] ? 1 : 0];
+#else
+    (void)fb;
+    return &g_dirty[0];
+#endif
+}
+
+// Invalidate everything (new SDLPoP session, framebuffer overwritten by the start screen, ...).
+static void rp2350_dirty_reset(void) {
+    rp2350_dirty_mark_all();
+    g_letterbox_valid = false;
+}
+
+void SDL_AddDirtyRect(SDL_Surface *surface, const SDL_Rect *rect) {
+    if (!surface) return;
+    if (surface != onscreen_surface_) {
+        surface->reserved_scan = RP2350_RESERVED_UNKNOWN;  // Written directly: rescan
+        return;
+    }
+    if (!rect) {
+        rp2350_dirty_mark_all();
+        return;
     }
-    return best_index;
+    rp2350_dirty_mark(rect->x, rect->y, rect->w, rect->h);
 }
 
 // Globals
@@ -176,6 +354,8 @@ int SDL_Init(Uint32 flags) {
     // HDMI and PS2 are initialized in main.c before calling pop_main
     // But if pop_main calls SDL_Init, we can just return success.
     start_time = time_us_32() / 1000;
+    // The start screen draws straight into the framebuffer between sessions.
+    rp2350_dirty_reset();
     return 0;
 }
 
@@ -237,13 +417,55 @@ void SDL_DestroyRenderer(SDL_Renderer *renderer) {
 void SDL_DestroyWindow(SDL_Window *window) {
 }
 
+// --- Surfaces in PSRAM arenas ---
+// psram_arena_reset() frees whatever an arena still holds as raw heap blocks. For a
+// surface that would leave its sprite-cache slot pointing at freed memory and leak its
+// span table and palette (both in the general heap), so surfaces allocated in an arena
+// are listed here and the reset hook puts the leftovers through SDL_FreeSurface first.
+static SDL_Surface *rp2350_arena_surfaces = NULL;
+
+static void rp2350_arena_release_surfaces(int id) {
+    int released = 0;
+    SDL_Surface *s = rp2350_arena_surfaces;
+    while (s) {
+        SDL_Surface *next = s->arena_next;
+        if (s->arena == id) {
+            SDL_FreeSurface(s);
+            released++;
+        }
+        s = next;
+    }
+    if (released) DBG_PRINTF("SDL: released %d leftover surface(s) of arena %d\n", released, id);
+}
+
+static void rp2350_arena_track(SDL_Surface *s) {
+    s->arena = (Sint8)psram_arena_of(s);
+    s->arena_prev = NULL;
+    s->arena_next = NULL;
+    if (s->arena < 0) return;
+    psram_arena_set_reset_hook(rp2350_arena_release_surfaces);
+    s->arena_next = rp2350_arena_surfaces;
+    if (rp2350_arena_surfaces) rp2350_arena_surfaces->arena_prev = s;
+    rp2350_arena_surfaces = s;
+}
+
+static void rp2350_arena_untrack(SDL_Surface *s) {
+    if (s->arena < 0) return;
+    if (s->arena_prev) s->arena_prev->arena_next = s->arena_next;
+    else rp2350_arena_surfaces = s->arena_next;
+    if (s->arena_next) s->arena_next->arena_prev = s->arena_prev;
+    s->arena = -1;
+}
+
 SDL_Surface *SDL_CreateRGBSurface(Uint32 flags, int width, int height, int depth, Uint32 Rmask, Uint32 Gmask, Uint32 Bmask, Uint32 Amask) {
     bool force_full_palette = (flags & SDL_FORCE_FULL_PALETTE) != 0;
     bool no_palette = (flags & SDL_NO_PALETTE) != 0;
     Uint32 stored_flags = flags & ~(SDL_FORCE_FULL_PALETTE | SDL_NO_PALETTE);
     // printf("SDL_CreateRGBSurface: %dx%d %d bpp\n", width, height, depth);
-    // Allocate everything in PSRAM to avoid SRAM OOM panics.
-    SDL_Surface *s = (SDL_Surface *)psram_malloc(sizeof(SDL_Surface));
+    // Allocate everything in PSRAM to avoid SRAM OOM panics. Surface, format and pixels
+    // come from the current PSRAM arena (e.g. "level"); palettes can be shared between
+    // surfaces, so they stay in the general heap.
+    SDL_Surface *s = (SDL_Surface *)psram_arena_malloc(sizeof(SDL_Surface), MEM_CAT_SURFACE);
     if (!s) {
         DBG_PRINTF("SDL_CreateRGBSurface: psram_malloc(SDL_Surface) failed\n");
         return NULL;
@@ -253,7 +475,7 @@ SDL_Surface *SDL_CreateRGBSurface(Uint32 flags, int width, int height, int depth
     s->w = width;
     s->h = height;
     
-    s->format = (SDL_PixelFormat *)psram_malloc(sizeof(SDL_PixelFormat));
+    s->format = (SDL_PixelFormat *)psram_arena_malloc(sizeof(SDL_PixelFormat), MEM_CAT_SURFACE);
     if (!s->format) {
         DBG_PRINTF("SDL_CreateRGBSurface: psram_malloc(SDL_PixelFormat) failed\n");
         psram_free(s);
@@ -330,6 +552,7 @@ SDL_Surface *SDL_CreateRGBSurface(Uint32 flags, int width, int height, int depth
             g_pop_onscreen_pixels_in_use = true;
             s->pixels = g_pop_onscreen_pixels_sram;
             memset(s->pixels, 0, (size_t)s->pitch * (size_t)height);
+            rp2350_dirty_reset();
             if (!g_pop_onscreen_pixels_printed) {
                 g_pop_onscreen_pixels_printed = true;
                 DBG_PRINTF("SDL_CreateRGBSurface: onscreen pixels pinned to SRAM (pixels=%p pitch=%d flags=0x%lx force_full_palette=%d)\n",
@@ -337,14 +560,14 @@ SDL_Surface *SDL_CreateRGBSurface(Uint32 flags, int width, int height, int depth
             }
         } else {
             DBG_PRINTF("SDL_CreateRGBSurface: onscreen SRAM pixels already in use; falling back to PSRAM\n");
-            s->pixels = psram_malloc((size_t)s->pitch * (size_t)height);
+            s->pixels = psram_arena_malloc((size_t)s->pitch * (size_t)height, MEM_CAT_SURFACE);
         }
     } else {
-        s->pixels = psram_malloc((size_t)s->pitch * (size_t)height);
+        s->pixels = psram_arena_malloc((size_t)s->pitch * (size_t)height, MEM_CAT_SURFACE);
     }
 #else
     // Use PSRAM for pixel data if available
-    s->pixels = psram_malloc((size_t)s->pitch * (size_t)height);
+    s->pixels = psram_arena_malloc((size_t)s->pitch * (size_t)height, MEM_CAT_SURFACE);
 #endif
     if (!s->pixels) {
         DBG_PRINTF("SDL_CreateRGBSurface: psram_malloc(pixels) failed. Size: %d\n", s->pitch * height);
@@ -365,6 +588,11 @@ SDL_Surface *SDL_CreateRGBSurface(Uint32 flags, int width, int height, int depth
     s->refcount = 1;
     s->colorkey = 0;
     s->use_colorkey = SDL_FALSE;
+    s->spans = NULL;
+    s->cache_slot = -1;
+    s->cache_heat = 0;
+    s->reserved_scan = RP2350_RESERVED_UNKNOWN;  // Loaders write pixels directly after this
+    rp2350_arena_track(s);
 
     // Default blend/alpha behavior (SDL2-like): surfaces with alpha default to BLEND.
     s->blendMode = (depth == 32 || (s->format && s->format->Amask)) ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE;
@@ -379,8 +607,249 @@ SDL_Surface *SDL_CreateRGBSurface(Uint32 flags, int width, int height, int depth
     return s;
 }
 
+// --- DMA rect engine (dma_rect.c) ---
+// Plain 8bpp copies and fills of at least RP2350_DMA_RECT_MIN_BYTES run on DMA while
+// the CPU returns to the game; smaller ones are cheaper on the CPU than the setup and
+// fence. Blits and fills wait only when the queued rect overlaps the pixels they read or
+// write (rp2350_fence_pixels); other entry points that touch pixels fence outright.
+#ifndef RP2350_DMA_RECT
+#define RP2350_DMA_RECT 1
+#endif
+#ifndef RP2350_DMA_RECT_MIN_BYTES
+#define RP2350_DMA_RECT_MIN_BYTES 4096
+#endif
+
+static bool rp2350_dma_rect_ok(int w, int h) {
+#if RP2350_DMA_RECT
+    static int ready = -1;
+    if ((Uint32)w * (Uint32)h < RP2350_DMA_RECT_MIN_BYTES) return false;
+    if (ready < 0) ready = dma_rect_init() ? 1 : 0;
+    return ready == 1;
+#else
+    (void)w; (void)h;
+    return false;
+#endif
+}
+
+void SDL_FenceSurfaces(void) {
+#if RP2350_DMA_RECT
+    dma_rect_fence();
+#endif
+}
+
+// Wait for the queued DMA rect if it touches `r` of `surface` (NULL: all of it).
+static void rp2350_fence_pixels(const SDL_Surface *surface, const SDL_Rect *r, bool write) {
+#if RP2350_DMA_RECT
+    if (!surface->pixels) return;
+    const int bpp = (surface->format && surface->format->BytesPerPixel) ? surface->format->BytesPerPixel : 1;
+    const SDL_Rect all = { 0, 0, surface->w, surface->h };
+    if (!r) r = &all;
+    dma_rect_fence_rect((const Uint8 *)surface->pixels + r->y * surface->pitch + r->x * bpp, surface->pitch,
+                        r->w * bpp, r->h, write);
+#else
+    (void)surface; (void)r; (void)write;
+#endif
+}
+
+void SDL_CopyRect8(Uint8 *dst, int dst_pitch, const Uint8 *src, int src_pitch, int w, int h) {
+    if (!dst || !src || w <= 0 || h <= 0) return;
+    if (rp2350_dma_rect_ok(w, h) && dma_rect_copy(dst, dst_pitch, src, src_pitch, w, h)) return;
+#if RP2350_DMA_RECT
+    dma_rect_fence_rect(src, src_pitch, w, h, false);
+    dma_rect_fence_rect(dst, dst_pitch, w, h, true);
+#endif
+    for (int y = 0; y < h; ++y) memcpy(dst + y * dst_pitch, src + y * src_pitch, (size_t)w);
+}
+
+// --- Transparent-span sprites (blit8_spans_t) ---
+#ifndef RP2350_SPRITE_SPANS
+#define RP2350_SPRITE_SPANS 1
+#endif
+
+static Uint32 rp2350_spans_built = 0;
+static Uint32 rp2350_spans_bytes = 0;
+static Uint32 rp2350_spans_blits = 0;
+
+static void rp2350_surface_drop_spans(SDL_Surface *surface) {
+    if (surface && surface->spans) {
+        psram_free(surface->spans);
+        surface->spans = NULL;
+    }
+}
+
+int SDL_SurfaceBuildSpans(SDL_Surface *surface) {
+#if RP2350_SPRITE_SPANS
+    if (!surface || !surface->pixels || !surface->format || surface->format->BytesPerPixel != 1) return 1;
+    SDL_FenceSurfaces();
+    if (!surface->use_colorkey || surface == onscreen_surface_ || surface->w > 0xFFFF || surface->h <= 0) return 1;
+    rp2350_surface_drop_spans(surface);
+
+    const Uint8 key = (Uint8)surface->colorkey;
+    Uint32 opaque = 0;
+    const Uint32 n_runs = blit8_spans_count((const Uint8 *)surface->pixels, surface->pitch, surface->w, surface->h,
+                                            key, &opaque);
+    // Mostly opaque sprites gain little over the SWAR colour-key kernel.
+    const Uint32 pixels = (Uint32)surface->w * (Uint32)surface->h;
+    if (n_runs >= 0x10000u || opaque * 4u > pixels * 3u) return 1;
+
+    const size_t bytes = blit8_spans_bytes(surface->h, n_runs);
+    void *mem = psram_malloc_cat(bytes, MEM_CAT_SURFACE);
+    if (!mem) return -1;
+    surface->spans = blit8_spans_build(mem, (const Uint8 *)surface->pixels, surface->pitch, surface->w, surface->h,
+                                       key, n_runs);
+    rp2350_spans_built++;
+    rp2350_spans_bytes += (Uint32)bytes;
+    return 0;
+#else
+    (void)surface;
+    return 1;
+#endif
+}
+
+// --- SRAM hot-sprite cache ---
+// Surfaces blitted repeatedly (kid frames, torches, guards) get an SRAM copy of their
+// pixels; blits read the copy instead of going over QSPI, which also keeps them out of
+// the HDMI ISR's way. Fixed size classes, LRU within a class; surfaces larger than the
+// biggest class stay in PSRAM. Writing into a surface drops its copy.
+#ifndef RP2350_SPRITE_CACHE
+#define RP2350_SPRITE_CACHE 1
+#endif
+// PSRAM blits before a surface is copied to SRAM (one-off blits are not worth a copy).
+#ifndef RP2350_SPRITE_CACHE_PROMOTE
+#define RP2350_SPRITE_CACHE_PROMOTE 2
+#endif
+
+#if RP2350_SPRITE_CACHE
+#define RP2350_SC_CLASSES 3
+#define RP2350_SC_SLOTS (16 + 8 + 8)
+static const struct {
+    Uint16 size;
+    Uint8 first;
+    Uint8 count;
+} rp2350_sc_class[RP2350_SC_CLASSES] = {
+    { 512, 0, 16 },   // Torches, tiles, small frames
+    { 1024, 16, 8 },  // Median kid/guard frame
+    { 2048, 24, 8 },  // Largest kid/guard frames
+};
+static alignas(4) uint8_t rp2350_sc_pool[16u * 512u + 8u * 1024u + 8u * 2048u];
+static uint8_t *rp2350_sc_data[RP2350_SC_SLOTS];
+static SDL_Surface *rp2350_sc_owner[RP2350_SC_SLOTS];
+static Uint32 rp2350_sc_last_use[RP2350_SC_SLOTS];
+static Uint32 rp2350_sc_tick = 0;
+#endif
+static Uint32 rp2350_sc_hits = 0;
+static Uint32 rp2350_sc_misses = 0;
+static Uint32 rp2350_sc_promotions = 0;
+static Uint32 rp2350_sc_evictions = 0;
+
+static void rp2350_sprite_cache_drop(SDL_Surface *surface) {
+#if RP2350_SPRITE_CACHE
+    if (surface->cache_slot >= 0) rp2350_sc_owner[surface->cache_slot] = NULL;
+#endif
+    surface->cache_slot = -1;
+    surface->cache_heat = 0;
+}
+
+// Pixels to read for a blit from `src`: the SRAM copy when cached, else src->pixels.
+static const Uint8 *rp2350_sprite_cache_pixels(SDL_Surface *src) {
+#if RP2350_SPRITE_CACHE
+    if (src->cache_slot >= 0) {
+        rp2350_sc_last_use[src->cache_slot] = ++rp2350_sc_tick;
+        rp2350_sc_hits++;
+        return rp2350_sc_data[src->cache_slot];
+    }
+    const Uint32 bytes = (Uint32)src->pitch * (Uint32)src->h;
+    if (!IS_PSRAM(src->pixels) || bytes > rp2350_sc_class[RP2350_SC_CLASSES - 1].size) {
+        return (const Uint8 *)src->pixels;
+    }
+    rp2350_sc_misses++;
+    if (src->cache_heat < 255) src->cache_heat++;
+    if (src->cache_heat < RP2350_SPRITE_CACHE_PROMOTE) return (const Uint8 *)src->pixels;
+
+    if (!rp2350_sc_data[0]) {
+        uint8_t *p = rp2350_sc_pool;
+        for (int c = 0; c < RP2350_SC_CLASSES; ++c) {
+            for (int i = 0; i < rp2350_sc_class[c].count; ++i) {
+                rp2350_sc_data[rp2350_sc_class[c].first + i] = p;
+                p += rp2350_sc_class[c].size;
+            }
+        }
+    }
+    int c = 0;
+    while (rp2350_sc_class[c].size < bytes) c++;
+    int slot = rp2350_sc_class[c].first;
+    for (int i = rp2350_sc_class[c].first; i < rp2350_sc_class[c].first + rp2350_sc_class[c].count; ++i) {
+        if (!rp2350_sc_owner[i]) {
+            slot = i;
+            break;
+        }
+        if (rp2350_sc_last_use[i] < rp2350_sc_last_use[slot]) slot = i;
+    }
+    if (rp2350_sc_owner[slot]) {
+        rp2350_sc_owner[slot]->cache_slot = -1;
+        rp2350_sc_owner[slot]->cache_heat = 0;
+        rp2350_sc_evictions++;
+    }
+#if RP2350_DMA_RECT
+    dma_rect_fence_rect(rp2350_sc_data[slot], (int)bytes, (int)bytes, 1, true);  // Evicted pixels may be a DMA source
+#endif
+    memcpy(rp2350_sc_data[slot], src->pixels, bytes);
+    rp2350_sc_owner[slot] = src;
+    rp2350_sc_last_use[slot] = ++rp2350_sc_tick;
+    src->cache_slot = (Sint16)slot;
+    rp2350_sc_promotions++;
+    return rp2350_sc_data[slot];
+#else
+    return (const Uint8 *)src->pixels;
+#endif
+}
+
+void SDL_GetSpriteCacheStats(Uint32 *hits, Uint32 *misses, Uint32 *promotions, Uint32 *evictions) {
+    if (hits) *hits = rp2350_sc_hits;
+    if (misses) *misses = rp2350_sc_misses;
+    if (promotions) *promotions = rp2350_sc_promotions;
+    if (evictions) *evictions = rp2350_sc_evictions;
+}
+
+// --- HDMI control indices in blit sources ---
+// Indices 240..243 are control codes for the scanout (see rp2350_screen_safe_index), so
+// blits into the onscreen surface remap them, but only when the source holds one:
+// identity blits keep the copy, SWAR and DMA paths. A surface is scanned once after
+// its pixels change; shim blits and fills that cannot write a control index keep the
+// result.
+static inline bool rp2350_is_reserved_index(Uint8 idx) {
+    return (Uint8)(idx - 240) < 4;
+}
+
+static bool rp2350_surface_has_reserved(SDL_Surface *surface) {
+    if (surface->reserved_scan == RP2350_RESERVED_UNKNOWN) {
+        surface->reserved_scan = RP2350_RESERVED_NONE;
+        for (int y = 0; y < surface->h; ++y) {
+            const Uint8 *row = (const Uint8 *)surface->pixels + y * surface->pitch;
+            for (int x = 0; x < surface->w; ++x) {
+                if (rp2350_is_reserved_index(row[x])) {
+                    surface->reserved_scan = RP2350_RESERVED_SOME;
+                    return true;
+                }
+            }
+        }
+    }
+    return surface->reserved_scan == RP2350_RESERVED_SOME;
+}
+
+// The surface's pixels are about to change: derived copies are stale.
+static void rp2350_surface_pixels_changed(SDL_Surface *surface) {
+    if (!surface) return;
+    rp2350_surface_drop_spans(surface);
+    rp2350_sprite_cache_drop(surface);
+    surface->reserved_scan = RP2350_RESERVED_UNKNOWN;
+}
+
 void SDL_FreeSurface(SDL_Surface *surface) {
     if (surface) {
+        SDL_FenceSurfaces();  // A queued DMA rect may still read or write these pixels
+        rp2350_surface_pixels_changed(surface);
+        rp2350_arena_untrack(surface);
         if (surface->pixels) {
 #if RP2350_POP_ONSCREEN_PIXELS_IN_SRAM_TEST
             if (surface->pixels == g_pop_onscreen_pixels_sram) {
@@ -421,6 +890,7 @@ int SDL_SetPaletteColors(SDL_Palette *palette, const SDL_Color *colors, int firs
 
     SDL_Palette* screen_palette = get_screen_palette();
     bool update_hardware = (palette == screen_palette);
+    rp2350_palette_touch(palette);
     // printf("SDL_SetPaletteColors: first=%d n=%d\n", firstcolor, ncolors);
     for (int i = 0; i < ncolors; i++) {
         int idx = firstcolor + i;
@@ -433,7 +903,7 @@ int SDL_SetPaletteColors(SDL_Palette *palette, const SDL_Color *colors, int firs
                 }
                 uint32_t color888 = (colors[i].r << 16) | (colors[i].g << 8) | colors[i].b;
                 graphics_set_palette(idx, color888);
-                if (idx >= 0 && idx < 256) {
+                if (idx >= 0 && idx < 256 && rp2350_screen_palette_rgb888_cache[idx] != color888) {
                     rp2350_screen_palette_rgb888_cache[idx] = color888;
                     rp2350_rgb_to_idx_dirty = true;
                 }
@@ -443,6 +913,7 @@ int SDL_SetPaletteColors(SDL_Palette *palette, const SDL_Color *colors, int firs
     }
     if (update_hardware) {
         graphics_restore_sync_colors();
+        g_screen_reserved_remap_dirty = true;
     }
     return 0;
 }
@@ -504,6 +975,74 @@ static inline uint8_t rp2350_rgb888_to_index(uint32_t rgb888) {
     return 0;
 }
 
+// Cross-palette index maps for 8bpp blits, keyed by both palettes and their versions.
+// Fonts and menu images blit from the same few palettes over and over; a hit saves
+// up to 256 find_best_palette_index() searches.
+#define RP2350_PALMAP_CACHE_SIZE 8
+
+typedef struct {
+    const SDL_Palette *src;
+    const SDL_Palette *dst;
+    Uint32 src_version;
+    Uint32 dst_version;
+    Uint32 last_use;
+    bool use_map;           // false: palettes match (or source is empty), copy indices as-is
+    Uint8 map[256];
+} rp2350_palmap_entry_t;
+
+static rp2350_palmap_entry_t rp2350_palmap_cache[RP2350_PALMAP_CACHE_SIZE];
+static Uint32 rp2350_palmap_clock = 0;
+static Uint32 rp2350_palmap_hits = 0;
+static Uint32 rp2350_palmap_misses = 0;
+
+static bool is_palette_empty(SDL_Palette *pal);
+
+static const rp2350_palmap_entry_t *rp2350_palmap_lookup(SDL_Palette *src_palette, SDL_Palette *dst_palette) {
+    rp2350_palmap_entry_t *victim = &rp2350_palmap_cache[0];
+    for (int i = 0; i < RP2350_PALMAP_CACHE_SIZE; ++i) {
+        rp2350_palmap_entry_t *e = &rp2350_palmap_cache[i];
+        if (e->src == src_palette && e->dst == dst_palette &&
+            e->src_version == src_palette->version && e->dst_version == dst_palette->version) {
+            e->last_use = ++rp2350_palmap_clock;
+            rp2350_palmap_hits++;
+            return e;
+        }
+        if (e->last_use < victim->last_use) victim = e;
+    }
+
+    rp2350_palmap_misses++;
+    rp2350_palmap_entry_t *e = victim;
+    e->src = src_palette;
+    e->dst = dst_palette;
+    e->src_version = src_palette->version;
+    e->dst_version = dst_palette->version;
+    e->last_use = ++rp2350_palmap_clock;
+    e->use_map = false;
+
+    // Only map if source palette is NOT empty (has colors) AND differs from dest
+    if (!is_palette_empty(src_palette)) {
+        bool palettes_differ = true;
+        if (src_palette->ncolors == dst_palette->ncolors) {
+             if (memcmp(src_palette->colors, dst_palette->colors, src_palette->ncolors * sizeof(SDL_Color)) == 0) {
+                 palettes_differ = false;
+             }
+        }
+
+        if (palettes_differ) {
+            e->use_map = true;
+            for (int i = 0; i < 256; ++i) {
+                e->map[i] = (Uint8)i;
+            }
+            int max_src_colors = src_palette->ncolors;
+            if (max_src_colors > 256) max_src_colors = 256;
+            for (int i = 0; i < max_src_colors; ++i) {
+                e->map[i] = find_best_palette_index(&src_palette->colors[i], dst_palette);
+            }
+        }
+    }
+    return e;
+}
+
 static bool is_palette_empty(SDL_Palette *pal) {
     if (!pal || !pal->colors) return true;
     // Check if all colors are black.
@@ -566,9 +1105,23 @@ int SDL_BlitSurface(SDL_Surface *src, const SDL_Rect *srcrect, SDL_Surface *dst,
 
     if (s_rect.w <= 0 || s_rect.h <= 0) return 0;
 
+    // All of src: the control-index scan and the sprite cache read it whole.
+    const SDL_Rect d_area = { d_rect.x, d_rect.y, s_rect.w, s_rect.h };
+    rp2350_fence_pixels(src, NULL, false);
+    rp2350_fence_pixels(dst, &d_area, true);
+
+    if (dst == onscreen_surface_) {
+        rp2350_dirty_mark(d_rect.x, d_rect.y, s_rect.w, s_rect.h);
+    }
+
     const int src_bpp = src->format ? src->format->BytesPerPixel : 1;
     const int dst_bpp = dst->format ? dst->format->BytesPerPixel : 1;
     const bool paletted_copy = (src_bpp == 1 && dst_bpp == 1);
+    // Checked before dst's pixels are marked changed (src may be dst).
+    const bool src_reserved = RP2350_ZERO_COPY_SCANOUT && paletted_copy && src != onscreen_surface_ &&
+                              rp2350_surface_has_reserved(src);
+    const Uint8 dst_reserved = dst->reserved_scan;
+    rp2350_surface_pixels_changed(dst);
     Uint8 palette_map[256];
     bool use_palette_map = false;
 
@@ -576,32 +1129,35 @@ int SDL_BlitSurface(SDL_Surface *src, const SDL_Rect *srcrect, SDL_Surface *dst,
         SDL_Palette *src_palette = src->format->palette;
         SDL_Palette *dst_palette = dst->format->palette;
         
-        // Only map if source palette is NOT empty (has colors) AND differs from dest
-        if (src_palette && dst_palette && src_palette != dst_palette && !is_palette_empty(src_palette)) {
-            bool palettes_differ = true;
-            if (src_palette->ncolors == dst_palette->ncolors) {
-                 if (memcmp(src_palette->colors, dst_palette->colors, src_palette->ncolors * sizeof(SDL_Color)) == 0) {
-                     palettes_differ = false;
-                 }
-            }
-
-            if (palettes_differ) {
+        if (src_palette && dst_palette && src_palette != dst_palette) {
+            const rp2350_palmap_entry_t *pm = rp2350_palmap_lookup(src_palette, dst_palette);
+            if (pm->use_map) {
                 use_palette_map = true;
-                for (int i = 0; i < 256; ++i) {
-                    palette_map[i] = (Uint8)i;
-                }
-                int max_src_colors = src_palette->ncolors;
-                if (max_src_colors > 256) max_src_colors = 256;
-                for (int i = 0; i < max_src_colors; ++i) {
-                    palette_map[i] = find_best_palette_index(&src_palette->colors[i], dst_palette);
-                }
+                memcpy(palette_map, pm->map, sizeof(palette_map));
             }
         }
     }
 
+#if RP2350_ZERO_COPY_SCANOUT
+    // The onscreen surface is scanned out as-is: keep HDMI control indices out of it.
+    if (paletted_copy && dst == onscreen_surface_ && (use_palette_map || src_reserved)) {
+        if (!use_palette_map) {
+            for (int i = 0; i < 256; ++i) palette_map[i] = (Uint8)i;
+            use_palette_map = true;
+        }
+        for (int i = 0; i < 256; ++i) palette_map[i] = rp2350_screen_safe_index(palette_map[i]);
+    }
+#endif
+    // An identity copy of control-index-free pixels leaves a clean destination clean.
+    if (paletted_copy && !use_palette_map && !src_reserved && dst_reserved == RP2350_RESERVED_NONE) {
+        dst->reserved_scan = RP2350_RESERVED_NONE;
+    }
+
     Uint8 *src_pixels = (Uint8 *)src->pixels;
     Uint8 *dst_pixels = (Uint8 *)dst->pixels;
+    if (paletted_copy && src != dst) src_pixels = (Uint8 *)rp2350_sprite_cache_pixels(src);
 
+#if MURMPRINCE_DEBUG
     // Debug print for blit (throttled)
     static int blit_debug_count = 0;
     if (blit_debug_count < 20) {
@@ -610,21 +1166,36 @@ int SDL_BlitSurface(SDL_Surface *src, const SDL_Rect *srcrect, SDL_Surface *dst,
             (void*)(dst->format ? dst->format->palette : NULL));
         blit_debug_count++;
     }
+#endif
+
+    if (paletted_copy && src->spans && src->use_colorkey &&
+        ((const blit8_spans_t *)src->spans)->key == (Uint8)src->colorkey) {
+        blit8_spans_blit((const blit8_spans_t *)src->spans, dst_pixels + d_rect.y * dst->pitch + d_rect.x, dst->pitch,
+                         src_pixels, src->pitch, s_rect.x, s_rect.y, s_rect.w, s_rect.h,
+                         use_palette_map ? palette_map : NULL);
+        rp2350_spans_blits++;
+        return 0;
+    }
+    if (paletted_copy && !src->use_colorkey && !use_palette_map && rp2350_dma_rect_ok(s_rect.w, s_rect.h) &&
+        dma_rect_copy(dst_pixels + d_rect.y * dst->pitch + d_rect.x, dst->pitch,
+                      src_pixels + s_rect.y * src->pitch + s_rect.x, src->pitch, s_rect.w, s_rect.h)) {
+        return 0;
+    }
+    if (paletted_copy) {
+        // Kernel chosen once per blit (see blit8.h).
+        blit8_rect(dst_pixels + d_rect.y * dst->pitch + d_rect.x, dst->pitch,
+                   src_pixels + s_rect.y * src->pitch + s_rect.x, src->pitch,
+                   s_rect.w, s_rect.h,
+                   src->use_colorkey ? (int)(Uint8)src->colorkey : BLIT8_NO_KEY,
+                   use_palette_map ? palette_map : NULL);
+        return 0;
+    }
 
     for (int y = 0; y < s_rect.h; y++) {
         Uint8 *s_row = src_pixels + (s_rect.y + y) * src->pitch + s_rect.x * src_bpp;
         Uint8 *d_row = dst_pixels + (d_rect.y + y) * dst->pitch + d_rect.x * dst_bpp;
         
-        if (paletted_copy) {
-            for (int x = 0; x < s_rect.w; ++x) {
-                Uint8 pixel = s_row[x];
-                if (src->use_colorkey && pixel == (Uint8)src->colorkey) {
-                    continue;
-                }
-                Uint8 mapped_pixel = use_palette_map ? palette_map[pixel] : pixel;
-                d_row[x] = mapped_pixel;
-            }
-        } else if (src_bpp == 3 && dst_bpp == 1) {
+        if (src_bpp == 3 && dst_bpp == 1) {
             // 24bpp -> 8bpp conversion (No Alpha)
             // Used for fonts/images loaded as RGB
             SDL_Palette *dst_pal = dst->format->palette;
@@ -791,10 +1362,70 @@ int SDL_BlitSurface(SDL_Surface *src, const SDL_Rect *srcrect, SDL_Surface *dst,
     return 0;
 }
 
+int SDL_BlitXor8(SDL_Surface *src, const SDL_Rect *srcrect, SDL_Surface *dst, const SDL_Rect *dstrect) {
+    if (!src || !dst || !src->format || !dst->format) return -1;
+    if (src->format->BytesPerPixel != 1 || dst->format->BytesPerPixel != 1) return -1;
+    SDL_FenceSurfaces();
+    rp2350_fixup_onscreen_surface_format(dst, "SDL_BlitXor8");
+
+    SDL_Rect s_rect = srcrect ? *srcrect : (SDL_Rect){0, 0, src->w, src->h};
+    SDL_Rect d_rect = dstrect ? (SDL_Rect){dstrect->x, dstrect->y, s_rect.w, s_rect.h}
+                              : (SDL_Rect){0, 0, s_rect.w, s_rect.h};
+
+    // Clip the source to the surface, then the destination to its clip_rect.
+    if (s_rect.x < 0) { s_rect.w += s_rect.x; d_rect.x -= s_rect.x; s_rect.x = 0; }
+    if (s_rect.y < 0) { s_rect.h += s_rect.y; d_rect.y -= s_rect.y; s_rect.y = 0; }
+    if (s_rect.x + s_rect.w > src->w) s_rect.w = src->w - s_rect.x;
+    if (s_rect.y + s_rect.h > src->h) s_rect.h = src->h - s_rect.y;
+    const SDL_Rect clip = dst->clip_rect;
+    if (d_rect.x < clip.x) { const int d = clip.x - d_rect.x; s_rect.x += d; s_rect.w -= d; d_rect.x = clip.x; }
+    if (d_rect.y < clip.y) { const int d = clip.y - d_rect.y; s_rect.y += d; s_rect.h -= d; d_rect.y = clip.y; }
+    if (d_rect.x + s_rect.w > clip.x + clip.w) s_rect.w = clip.x + clip.w - d_rect.x;
+    if (d_rect.y + s_rect.h > clip.y + clip.h) s_rect.h = clip.y + clip.h - d_rect.y;
+    if (s_rect.w <= 0 || s_rect.h <= 0) return 0;
+
+    SDL_Palette *src_pal = src->format->palette ? src->format->palette : get_screen_palette();
+    SDL_Palette *dst_pal = dst->format->palette ? dst->format->palette : get_screen_palette();
+    if (!src_pal || !dst_pal || dst_pal->ncolors <= 0) return -1;
+
+    rp2350_surface_pixels_changed(dst);
+    d_rect.w = s_rect.w;
+    d_rect.h = s_rect.h;
+    SDL_AddDirtyRect(dst, &d_rect);
+
+    // XOR in RGB like SDLPoP's 24bpp helper did, mapped back with the inverse colormap.
+    // Black source pixels XOR to the unchanged colour and are skipped outright.
+    const Uint8 *s_base = (const Uint8 *)src->pixels + s_rect.y * src->pitch + s_rect.x;
+    Uint8 *d_base = (Uint8 *)dst->pixels + d_rect.y * dst->pitch + d_rect.x;
+    int last_key = -1;
+    Uint8 last_out = 0;
+    for (int y = 0; y < s_rect.h; ++y) {
+        const Uint8 *s_row = s_base + y * src->pitch;
+        Uint8 *d_row = d_base + y * dst->pitch;
+        for (int x = 0; x < s_rect.w; ++x) {
+            const Uint8 si = s_row[x];
+            if (si >= src_pal->ncolors) continue;
+            const SDL_Color sc = src_pal->colors[si];
+            if ((sc.r | sc.g | sc.b) == 0) continue;
+            const Uint8 di = d_row[x];
+            const int key = (si << 8) | di;
+            if (key != last_key) {
+                const SDL_Color dc = (di < dst_pal->ncolors) ? dst_pal->colors[di] : (SDL_Color){0, 0, 0, 255};
+                last_out = rp2350_palette_nearest(dst_pal, 0, dst_pal->ncolors, dc.r ^ sc.r, dc.g ^ sc.g, dc.b ^ sc.b);
+                last_key = key;
+            }
+            d_row[x] = last_out;
+        }
+    }
+    return 0;
+}
+
 int SDL_FillRect(SDL_Surface *dst, const SDL_Rect *rect, Uint32 color) {
     if (!dst) return -1;
 
     rp2350_fixup_onscreen_surface_format(dst, "SDL_FillRect");
+    const Uint8 dst_reserved = dst->reserved_scan;
+    rp2350_surface_pixels_changed(dst);
     SDL_Rect d_rect = {0, 0, dst->w, dst->h};
     if (rect) d_rect = *rect;
 
@@ -807,9 +1438,24 @@ int SDL_FillRect(SDL_Surface *dst, const SDL_Rect *rect, Uint32 color) {
     if (d_rect.w <= 0 || d_rect.h <= 0) return 0;
 
     if (!dst->format || !dst->pixels || dst->pitch <= 0) return -1;
+    rp2350_fence_pixels(dst, &d_rect, true);
+
+    if (dst == onscreen_surface_) {
+        rp2350_dirty_mark(d_rect.x, d_rect.y, d_rect.w, d_rect.h);
+#if RP2350_ZERO_COPY_SCANOUT
+        color = rp2350_screen_safe_index((Uint8)color);
+#endif
+    }
 
     const int bpp = dst->format->BytesPerPixel ? dst->format->BytesPerPixel : 1;
+    if (bpp == 1 && dst_reserved == RP2350_RESERVED_NONE && !rp2350_is_reserved_index((Uint8)color)) {
+        dst->reserved_scan = RP2350_RESERVED_NONE;
+    }
     Uint8 *dst_pixels = (Uint8 *)dst->pixels;
+    if (bpp == 1 && rp2350_dma_rect_ok(d_rect.w, d_rect.h) &&
+        dma_rect_fill(dst_pixels + d_rect.y * dst->pitch + d_rect.x, dst->pitch, (Uint8)color, d_rect.w, d_rect.h)) {
+        return 0;
+    }
     for (int y = 0; y < d_rect.h; y++) {
         Uint8 *d_row = dst_pixels + (d_rect.y + y) * dst->pitch + d_rect.x * bpp;
         if (bpp == 1) {
@@ -857,7 +1503,20 @@ int SDL_RenderCopy(SDL_Renderer *renderer, SDL_Texture *texture, const SDL_Rect
 }
 
 static inline Uint8 *rp2350_framebuffer(void) {
+#if RP2350_DOUBLE_BUFFER
+    // First present of a session (main.c resets scanout to its 320x240 buffer between
+    // sessions): use that buffer's 320x200 middle as front and flip against g_fb_second.
+    if (graphics_get_back_buffer() == graphics_get_buffer() && graphics_get_buffer()) {
+        const int shift_y = (RP2350_OUTPUT_H - RP2350_SCREEN_H) / 2;
+        g_fb_pair[0] = (Uint8 *)graphics_get_buffer() + shift_y * RP2350_SCREEN_W;
+        graphics_set_scanout(g_fb_pair[0], RP2350_SCREEN_W, RP2350_SCREEN_H, shift_y);
+        graphics_set_back_buffer(g_fb_pair[1]);
+        rp2350_dirty_reset();
+    }
+    return (Uint8 *)graphics_get_back_buffer();
+#else
     return (Uint8 *)graphics_get_buffer();
+#endif
 }
 
 #ifndef RP2350_SDL_VISUAL_HEARTBEAT
@@ -907,6 +1566,9 @@ static void rp2350_draw_test_pattern(uint8_t *dst, int dst_pitch, int w, int h,
 }
 
 int SDL_UpdateTexture(SDL_Texture *texture, const SDL_Rect *rect, const void *pixels, int pitch) {
+    // Present: every queued DMA rect must have landed before the frame is read.
+    SDL_FenceSurfaces();
+
     // Copy pixels to graphics_buffer
     // Assuming 320x200 input and 320x240 output
     // We center it vertically?
@@ -962,6 +1624,75 @@ int SDL_UpdateTexture(SDL_Texture *texture, const SDL_Rect *rect, const void *pi
     if ((frame_count % 60) == 0) {
         gpio_put(25, !gpio_get(25));
     }
+#if HDMI_TELEMETRY || MEM_TELEMETRY
+    // On-demand telemetry over the serial console: 't' dumps HDMI scanout, 'm' memory;
+    // upper case also resets.
+    {
+        const int ch = getchar_timeout_us(0);
+#if HDMI_TELEMETRY
+        if (ch == 't' || ch == 'T') {
+            graphics_dump_hdmi_telemetry(ch == 'T');
+        }
+#endif
+#if MEM_TELEMETRY
+        if (ch == 'm' || ch == 'M') {
+            psram_dump_telemetry(ch == 'M');
+        }
+#endif
+    }
+#endif
+#if MURMPRINCE_DEBUG
+    // HDMI scanline ISR load per core (compare HDMI_USE_CORE1=0/1) and blit cache stats, every ~10 s.
+    {
+        static uint32_t busy_last_us = 0;
+        static uint64_t isr_last[2] = {0, 0};
+        const uint32_t now_us = time_us_32();
+        if (busy_last_us == 0) {
+            busy_last_us = now_us;
+        } else if ((now_us - busy_last_us) >= 10000000u) {
+            const uint64_t window = (uint64_t)(now_us - busy_last_us) * (clock_get_hz(clk_sys) / 1000000u);
+            for (unsigned core = 0; core < 2; ++core) {
+                const uint64_t isr = graphics_get_hdmi_isr_cycles(core);
+                DBG_PRINTF("HDMI ISR load core%u: %lu.%lu%%\n", core,
+                    (unsigned long)((isr - isr_last[core]) * 100u / window),
+                    (unsigned long)(((isr - isr_last[core]) * 1000u / window) % 10u));
+                isr_last[core] = isr;
+            }
+            DBG_PRINTF("Palette map cache: %lu hits, %lu misses\n",
+                (unsigned long)rp2350_palmap_hits, (unsigned long)rp2350_palmap_misses);
+            DBG_PRINTF("Sprite spans: %lu sprites, %lu bytes, %lu span blits\n",
+                (unsigned long)rp2350_spans_built, (unsigned long)rp2350_spans_bytes,
+                (unsigned long)rp2350_spans_blits);
+            DBG_PRINTF("Sprite cache: %lu hits, %lu misses, %lu promoted, %lu evicted\n",
+                (unsigned long)rp2350_sc_hits, (unsigned long)rp2350_sc_misses,
+                (unsigned long)rp2350_sc_promotions, (unsigned long)rp2350_sc_evictions);
+            {
+                pop_fs_stats_t fs;
+                pop_fs_get_stats(&fs);
+                DBG_PRINTF("SD reads: %lu calls, %lu KB, %lu KB/s avg, %lu KB/s peak, %lu bursts, "
+                    "%lu underruns\n", (unsigned long)fs.reads, (unsigned long)(fs.bytes / 1024),
+                    (unsigned long)(fs.busy_us ? fs.bytes * 1000000u / ((uint64_t)fs.busy_us * 1024u) : 0),
+                    (unsigned long)fs.peak_kbps, (unsigned long)fs.bursts, (unsigned long)fs.underruns);
+                DBG_PRINTF("SD pacing: %lu KB/s cap, %lu chunks paced, %lu ms waited\n",
+                    (unsigned long)fs.pace_kbps, (unsigned long)fs.paced, (unsigned long)(fs.pace_us / 1000));
+                DBG_PRINTF("SD opens: %lu cached, %lu misses answered, %lu walked, %lu dirs listed, %lu flushes\n",
+                    (unsigned long)fs.open_hits, (unsigned long)fs.open_misses, (unsigned long)fs.open_walks,
+                    (unsigned long)fs.dir_lists, (unsigned long)fs.cache_flushes);
+            }
+#if RP2350_DMA_RECT
+            {
+                dma_rect_stats_t ds;
+                dma_rect_get_stats(&ds);
+                DBG_PRINTF("DMA rect: %lu rects, %lu bytes, %lu fallbacks, %lu fence waits (%lu us), "
+                    "%lu fences skipped\n", (unsigned long)ds.rects, (unsigned long)ds.bytes,
+                    (unsigned long)ds.fallbacks, (unsigned long)ds.fence_waits, (unsigned long)ds.fence_us,
+                    (unsigned long)ds.fence_skips);
+            }
+#endif
+            busy_last_us = now_us;
+        }
+    }
+#endif
 
 #if RP2350_DUMP_FIRST_FRAME_BYTES
     if (frame_count == 1 && pixels && pitch > 0) {
@@ -984,17 +1715,35 @@ int SDL_UpdateTexture(SDL_Texture *texture, const SDL_Rect *rect, const void *pi
     return 0;
 #endif
 
-    if (y_offset > 0) {
+    // Handle 8bpp (expected), plus 16/24/32bpp frames by mapping RGB back to palette indices.
+    // Only infer bpp for the exact tightly-packed cases; otherwise treat as 8bpp indexed.
+    const int src_bpp = (pitch == w * 4) ? 4 : ((pitch == w * 3) ? 3 : ((pitch == w * 2) ? 2 : 1));
+
+    const bool src_is_onscreen = onscreen_surface_ && pixels == onscreen_surface_->pixels &&
+                                 pitch == onscreen_surface_->pitch;
+#if RP2350_DIRTY_RECT_UPDATES
+    // Partial copy only for the tracked 8bpp onscreen surface; the first frames stay full
+    // so the diagnostics below see a complete image.
+    const bool dirty_path = src_is_onscreen && src_bpp == 1 && frame_count > 3 && !RP2350_DEBUG_INDEX_BAR;
+    if (rect && src_is_onscreen) {
+        rp2350_dirty_mark(rect->x, rect->y, rect->w, rect->h);
+    }
+    // The letterbox bands never change during a session: clear them once per framebuffer.
+    const bool clear_letterbox = !g_letterbox_valid || dst != g_letterbox_fb;
+    g_letterbox_valid = true;
+    g_letterbox_fb = dst;
+#else
+    const bool dirty_path = false;
+    const bool clear_letterbox = true;
+#endif
+
+    if (clear_letterbox && y_offset > 0) {
         memset(dst, 0, dst_pitch * y_offset);
     }
-    if (bottom_pad > 0) {
+    if (clear_letterbox && bottom_pad > 0) {
         memset(dst + (y_offset + h) * dst_pitch, 0, dst_pitch * bottom_pad);
     }
 
-    // Handle 8bpp (expected), plus 16/24/32bpp frames by mapping RGB back to palette indices.
-    // Only infer bpp for the exact tightly-packed cases; otherwise treat as 8bpp indexed.
-    const int src_bpp = (pitch == w * 4) ? 4 : ((pitch == w * 3) ? 3 : ((pitch == w * 2) ? 2 : 1));
-
     if (frame_count <= 3 && src && pitch > 0) {
         DBG_PRINTF("SDL_UpdateTexture: frame=%d inferred src_bpp=%d\\n", frame_count, src_bpp);
         if (src_bpp == 1) {
@@ -1023,52 +1772,89 @@ int SDL_UpdateTexture(SDL_Texture *texture, const SDL_Rect *rect, const void *pi
         }
     }
 
-    for (int y = 0; y < h; y++) {
-        Uint8 *drow = dst + (y + y_offset) * dst_pitch;
-        const Uint8 *srow = src + y * pitch;
+#if RP2350_ZERO_COPY_SCANOUT
+    // Scan out straight from the SRAM-pinned onscreen surface: nothing to copy.
+    if (src_is_onscreen && src_bpp == 1 && rp2350_is_pinned_onscreen_surface(onscreen_surface_)) {
+        if (dst != onscreen_surface_->pixels) {
+            graphics_set_scanout((uint8_t *)onscreen_surface_->pixels, w, h, (RP2350_OUTPUT_H - h) / 2);
+            DBG_PRINTF("SDL_UpdateTexture: zero-copy scanout from onscreen surface %p\n", onscreen_surface_->pixels);
+        }
+        rp2350_dirty_clear(&g_dirty[0]);
+        return 0;
+    }
+#endif
 
-        if (src_bpp == 1) {
-            memcpy(drow, srow, w);
+    if (dirty_path) {
+        rp2350_dirty_spans_t *spans = rp2350_dirty_for(dst);
+        for (int y = spans->y0; y < spans->y1; ++y) {
+            const int x0 = spans->x0[y];
+            const int x1 = spans->x1[y];
+            if (x1 <= x0) continue;
+            Uint8 *drow = dst + (y + y_offset) * dst_pitch;
+            const Uint8 *srow = src + y * pitch;
+            memcpy(drow + x0, srow + x0, (size_t)(x1 - x0));
             // HDMI scanout reservation: indices 240..243 are control/sync codes.
-            for (int x = 0; x < w; ++x) {
+            for (int x = x0; x < x1; ++x) {
                 if (drow[x] >= 240 && drow[x] <= 243) drow[x] = 255;
             }
-        } else if (src_bpp == 2) {
-            // Assume RGB565 little-endian.
-            const uint16_t *s16 = (const uint16_t *)srow;
-            for (int x = 0; x < w; ++x) {
-                const uint16_t p = s16[x];
-                const uint8_t r = (uint8_t)((p >> 11) & 0x1F);
-                const uint8_t g = (uint8_t)((p >> 5) & 0x3F);
-                const uint8_t b = (uint8_t)(p & 0x1F);
-                const uint8_t r8 = (uint8_t)((r * 255u) / 31u);
-                const uint8_t g8 = (uint8_t)((g * 255u) / 63u);
-                const uint8_t b8 = (uint8_t)((b * 255u) / 31u);
-                const uint32_t rgb = ((uint32_t)r8 << 16) | ((uint32_t)g8 << 8) | (uint32_t)b8;
-                uint8_t idx = rp2350_rgb888_to_index(rgb);
-                drow[x] = (idx >= 240 && idx <= 243) ? 255 : idx;
-            }
-        } else if (src_bpp == 3) {
-            for (int x = 0; x < w; ++x) {
-                const uint8_t r = srow[x * 3 + 0];
-                const uint8_t g = srow[x * 3 + 1];
-                const uint8_t b = srow[x * 3 + 2];
-                const uint32_t rgb = ((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b;
-                uint8_t idx = rp2350_rgb888_to_index(rgb);
-                drow[x] = (idx >= 240 && idx <= 243) ? 255 : idx;
+        }
+        rp2350_dirty_clear(spans);
+    } else {
+        for (int y = 0; y < h; y++) {
+            Uint8 *drow = dst + (y + y_offset) * dst_pitch;
+            const Uint8 *srow = src + y * pitch;
+
+            if (src_bpp == 1) {
+                memcpy(drow, srow, w);
+                // HDMI scanout reservation: indices 240..243 are control/sync codes.
+                for (int x = 0; x < w; ++x) {
+                    if (drow[x] >= 240 && drow[x] <= 243) drow[x] = 255;
+                }
+            } else if (src_bpp == 2) {
+                // Assume RGB565 little-endian.
+                const uint16_t *s16 = (const uint16_t *)srow;
+                for (int x = 0; x < w; ++x) {
+                    const uint16_t p = s16[x];
+                    const uint8_t r = (uint8_t)((p >> 11) & 0x1F);
+                    const uint8_t g = (uint8_t)((p >> 5) & 0x3F);
+                    const uint8_t b = (uint8_t)(p & 0x1F);
+                    const uint8_t r8 = (uint8_t)((r * 255u) / 31u);
+                    const uint8_t g8 = (uint8_t)((g * 255u) / 63u);
+                    const uint8_t b8 = (uint8_t)((b * 255u) / 31u);
+                    const uint32_t rgb = ((uint32_t)r8 << 16) | ((uint32_t)g8 << 8) | (uint32_t)b8;
+                    uint8_t idx = rp2350_rgb888_to_index(rgb);
+                    drow[x] = (idx >= 240 && idx <= 243) ? 255 : idx;
+                }
+            } else if (src_bpp == 3) {
+                for (int x = 0; x < w; ++x) {
+                    const uint8_t r = srow[x * 3 + 0];
+                    const uint8_t g = srow[x * 3 + 1];
+                    const uint8_t b = srow[x * 3 + 2];
+                    const uint32_t rgb = ((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b;
+                    uint8_t idx = rp2350_rgb888_to_index(rgb);
+                    drow[x] = (idx >= 240 && idx <= 243) ? 255 : idx;
+                }
+            } else {
+                const uint32_t *srow32 = (const uint32_t *)srow;
+                for (int x = 0; x < w; ++x) {
+                    // Our 32bpp surfaces are treated as little-endian RGBA in this port.
+                    const uint32_t p = srow32[x];
+                    const uint8_t r = (uint8_t)(p & 0xFF);
+                    const uint8_t g = (uint8_t)((p >> 8) & 0xFF);
+                    const uint8_t b = (uint8_t)((p >> 16) & 0xFF);
+                    const uint32_t rgb = ((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b;
+                    uint8_t idx = rp2350_rgb888_to_index(rgb);
+                    drow[x] = (idx >= 240 && idx <= 243) ? 255 : idx;
+                }
             }
+        }
+
+        // A full copy of the onscreen surface leaves nothing pending; any other source
+        // replaced the framebuffer contents, so the next onscreen update must be full.
+        if (src_is_onscreen && src_bpp == 1) {
+            rp2350_dirty_clear(rp2350_dirty_for(dst));
         } else {
-            const uint32_t *srow32 = (const uint32_t *)srow;
-            for (int x = 0; x < w; ++x) {
-                // Our 32bpp surfaces are treated as little-endian RGBA in this port.
-                const uint32_t p = srow32[x];
-                const uint8_t r = (uint8_t)(p & 0xFF);
-                const uint8_t g = (uint8_t)((p >> 8) & 0xFF);
-                const uint8_t b = (uint8_t)((p >> 16) & 0xFF);
-                const uint32_t rgb = ((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b;
-                uint8_t idx = rp2350_rgb888_to_index(rgb);
-                drow[x] = (idx >= 240 && idx <= 243) ? 255 : idx;
-            }
+            rp2350_dirty_mark_all();
         }
     }
 
@@ -1098,6 +1884,9 @@ int SDL_UpdateTexture(SDL_Texture *texture, const SDL_Rect *rect, const void *pi
 #if RP2350_SDL_VISUAL_HEARTBEAT
     if (dst) dst[(output_height - 1) * dst_pitch + 0] = (frame_count & 1) ? 15 : 0;
 #endif
+
+    // Double buffering: queue the flip; vsync_handler() swaps buffers. No-op otherwise.
+    graphics_present();
     
     return 0;
 }
@@ -1493,8 +2282,8 @@ SDL_RWops *SDL_RWFromFile(const char *file, const char *mode) {
     // Use the reusable PSRAM file buffer when possible.
     Uint8* buffer = (Uint8*)psram_get_file_buffer(file_size);
     if (!buffer) {
-        // Fallback: allocate from PSRAM permanent pool (may leak; acceptable during bring-up).
-        buffer = (Uint8*)psram_malloc(file_size);
+        // Fallback: allocate from the PSRAM heap (freed by mem_close).
+        buffer = (Uint8*)psram_malloc_cat(file_size, MEM_CAT_FILEBUF);
     }
     if (!buffer) {
         if (do_print) {
@@ -1517,7 +2306,8 @@ SDL_RWops *SDL_RWFromFile(const char *file, const char *mode) {
 
     SDL_RWops* rw = SDL_RWFromConstMem(buffer, (int)file_size);
     if (!rw) {
-        free(buffer);
+        if (IS_PSRAM(buffer)) psram_free(buffer);
+        else free(buffer);
         return NULL;
     }
     // Mark as owning memory so close frees it.
@@ -1733,6 +2523,7 @@ int SDL_HapticRumblePlay(SDL_Haptic *haptic, float strength, Uint32 length) {
 
 SDL_Surface *SDL_ConvertSurface(SDL_Surface *src, const SDL_PixelFormat *fmt, Uint32 flags) {
     if (!src || !fmt) return NULL;
+    SDL_FenceSurfaces();
     
     SDL_Surface *new_surf = SDL_CreateRGBSurface(flags, src->w, src->h, fmt->BitsPerPixel, 0, 0, 0, 0);
     if (!new_surf) return NULL;
@@ -1797,7 +2588,11 @@ int SDL_SetSurfaceAlphaMod(SDL_Surface *surface, Uint8 alpha) {
 }
 
 int SDL_LockSurface(SDL_Surface *surface) {
+    SDL_FenceSurfaces();
     rp2350_fixup_onscreen_surface_format(surface, "SDL_LockSurface");
+    // Callers write pixels directly after locking; we cannot know where.
+    SDL_AddDirtyRect(surface, NULL);
+    rp2350_surface_pixels_changed(surface);
     return 0;
 }
 void SDL_UnlockSurface(SDL_Surface *surface) {}
@@ -1998,6 +2793,7 @@ int SDL_BlitScaled(SDL_Surface *src, const SDL_Rect *srcrect, SDL_Surface *dst,
 }
 SDL_Surface *SDL_ConvertSurfaceFormat(SDL_Surface *src, Uint32 pixel_format, Uint32 flags) { 
     if (!src || !src->format) return NULL;
+    SDL_FenceSurfaces();
 
     // SDLPoP primarily uses this for creating an ARGB8888 copy of glyph/sprite
     // surfaces so it can recolor via direct pixel writes.
@@ -70,6 +70,7 @@ typedef struct SDL_Palette {
     SDL_Color *colors;
     int refcount;
     Uint32 flags;
+    Uint32 version;  // Globally unique; changes whenever colors are modified
 } SDL_Palette;
 
 typedef struct SDL_PixelFormat {
@@ -103,6 +104,12 @@ typedef struct SDL_Surface {
     SDL_BlendMode blendMode;
     Uint8 alphaMod;
     SDL_Rect clip_rect;  // Clipping rectangle
+    void *spans;         // RP2350: opaque runs (blit8_spans_t), see SDL_SurfaceBuildSpans
+    Sint16 cache_slot;   // RP2350: SRAM sprite cache slot, -1 if not cached
+    Uint8 cache_heat;    // RP2350: PSRAM blits since the last (re)load, for promotion
+    Uint8 reserved_scan; // RP2350: whether pixels hold HDMI control indices 240..243 (0 = not scanned)
+    Sint8 arena;         // RP2350: PSRAM arena holding the surface, -1 if none
+    struct SDL_Surface *arena_prev, *arena_next;  // RP2350: list of arena surfaces
 } SDL_Surface;
 
 typedef struct SDL_Window SDL_Window;
@@ -488,6 +495,34 @@ SDL_Palette *SDL_CreatePalette(int ncolors);
 void SDL_PaletteAddRef(SDL_Palette *palette);
 void SDL_PaletteRelease(SDL_Palette *palette);
 void SDL_SurfaceAdoptPalette(SDL_Surface *surface, SDL_Palette *palette);
+// RP2350: mark a region of the onscreen surface as modified by a direct pixel write
+// (NULL rect = whole surface). See SDL_UpdateTexture. Other surfaces only forget what
+// was known about their pixels (see SDL_Surface.reserved_scan).
+void SDL_AddDirtyRect(SDL_Surface *surface, const SDL_Rect *rect);
+// RP2350: palette index safe to store in `surface`. For the onscreen surface, HDMI
+// control indices 240..243 are replaced by the nearest displayable entry.
+Uint8 SDL_SurfaceSafeIndex(SDL_Surface *surface, Uint8 index);
+// RP2350: nearest entry to (r,g,b) among palette indices [first, first+count), using a
+// shared inverse colormap rebuilt on SDL_SetPaletteColors. Same result as a linear
+// search (screen palette: 240..243 excluded).
+Uint8 SDL_PaletteNearestIndex(SDL_Palette *palette, int first, int count, Uint8 r, Uint8 g, Uint8 b);
+// RP2350: precompute the opaque runs of a colour-keyed 8bpp sprite so blits skip its
+// transparent pixels. Call once the pixels are final; locking, filling or blitting
+// into the surface drops the runs. Returns 0 if built, 1 if not worthwhile, -1 on OOM.
+int SDL_SurfaceBuildSpans(SDL_Surface *surface);
+// RP2350: SRAM hot-sprite cache counters (blits served from SRAM / from PSRAM,
+// surfaces copied in / evicted). Any pointer may be NULL.
+void SDL_GetSpriteCacheStats(Uint32 *hits, Uint32 *misses, Uint32 *promotions, Uint32 *evictions);
+// RP2350: copy an 8bpp rectangle between raw pixel buffers; large ones go to the DMA
+// rect engine and complete in the background. SDL_BlitSurface and SDL_FillRect use
+// the engine too. Call SDL_FenceSurfaces() before touching surface pixels directly
+// (SDL_LockSurface, SDL_FreeSurface and the shim's own entry points already do).
+void SDL_CopyRect8(Uint8 *dst, int dst_pitch, const Uint8 *src, int src_pitch, int w, int h);
+void SDL_FenceSurfaces(void);
+// RP2350: XOR-blit 8bpp `src` onto 8bpp `dst` in place (SDLPoP's blitters_3_xor):
+// each pixel's colour is XORed with the source colour in RGB and mapped back to the
+// nearest destination index. No temporary surfaces. Returns -1 for other depths.
+int SDL_BlitXor8(SDL_Surface *src, const SDL_Rect *srcrect, SDL_Surface *dst, const SDL_Rect *dstrect);
 int SDL_BlitSurface(SDL_Surface *src, const SDL_Rect *srcrect, SDL_Surface *dst, SDL_Rect *dstrect);
 int SDL_FillRect(SDL_Surface *dst, const SDL_Rect *rect, Uint32 color);
 int SDL_SetColorKey(SDL_Surface *surface, int flag, Uint32 key);
@@ -0,0 +1,216 @@
+#ifndef BLIT8_H
+#define BLIT8_H
+
+// 8bpp blit kernels for SDL_BlitSurface's paletted path. The kernel is picked once
+// per rectangle (opaque copy, remap, colour key, colour key + remap); the colour-key
+// kernels test four pixels per step with a SWAR byte-equality mask, so runs of fully
+// opaque or fully transparent pixels cost one compare per word. Sprites can also carry
+// precomputed opaque runs (blit8_spans_t) so transparent pixels are never read.
+//
+// Plain C, no Pico SDK: tools/blit8_bench.c builds it on the host.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#define BLIT8_NO_KEY (-1)
+
+static inline uint32_t blit8_load32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);  // Unaligned-safe; a single LDR on Cortex-M33
+    return v;
+}
+
+static inline void blit8_store32(uint8_t *p, uint32_t v) {
+    memcpy(p, &v, 4);
+}
+
+// 0x80 in every byte of `v` equal to the matching byte of `key4`, 0 elsewhere.
+// Exact per byte (no borrow propagation, unlike the classic haszero() trick).
+static inline uint32_t blit8_match_mask(uint32_t v, uint32_t key4) {
+    const uint32_t x = v ^ key4;
+    const uint32_t t = (x & 0x7F7F7F7Fu) + 0x7F7F7F7Fu;
+    return ~(t | x | 0x7F7F7F7Fu);
+}
+
+static inline void blit8_row_remap(uint8_t *d, const uint8_t *s, int w, const uint8_t *map) {
+    int x = 0;
+    for (; x + 4 <= w; x += 4) {
+        const uint8_t p0 = map[s[x]], p1 = map[s[x + 1]], p2 = map[s[x + 2]], p3 = map[s[x + 3]];
+        d[x] = p0;
+        d[x + 1] = p1;
+        d[x + 2] = p2;
+        d[x + 3] = p3;
+    }
+    for (; x < w; ++x) d[x] = map[s[x]];
+}
+
+static inline void blit8_row_key(uint8_t *d, const uint8_t *s, int w, uint8_t key) {
+    const uint32_t key4 = key * 0x01010101u;
+    int x = 0;
+    for (; x + 4 <= w; x += 4) {
+        const uint32_t v = blit8_load32(s + x);
+        const uint32_t m = blit8_match_mask(v, key4);
+        if (m == 0) {
+            blit8_store32(d + x, v);                      // All opaque
+        } else if (m != 0x80808080u) {
+            const uint32_t keep = (m >> 7) * 0xFFu;       // 0xFF where transparent
+            blit8_store32(d + x, (blit8_load32(d + x) & keep) | (v & ~keep));
+        }
+    }
+    for (; x < w; ++x) {
+        if (s[x] != key) d[x] = s[x];
+    }
+}
+
+static inline void blit8_row_key_remap(uint8_t *d, const uint8_t *s, int w, uint8_t key, const uint8_t *map) {
+    const uint32_t key4 = key * 0x01010101u;
+    int x = 0;
+    for (; x + 4 <= w; x += 4) {
+        const uint32_t m = blit8_match_mask(blit8_load32(s + x), key4);
+        if (m == 0x80808080u) continue;                   // All transparent
+        if (m == 0) {
+            const uint8_t p0 = map[s[x]], p1 = map[s[x + 1]], p2 = map[s[x + 2]], p3 = map[s[x + 3]];
+            d[x] = p0;
+            d[x + 1] = p1;
+            d[x + 2] = p2;
+            d[x + 3] = p3;
+            continue;
+        }
+        if (!(m & 0x00000080u)) d[x] = map[s[x]];
+        if (!(m & 0x00008000u)) d[x + 1] = map[s[x + 1]];
+        if (!(m & 0x00800000u)) d[x + 2] = map[s[x + 2]];
+        if (!(m & 0x80000000u)) d[x + 3] = map[s[x + 3]];
+    }
+    for (; x < w; ++x) {
+        if (s[x] != key) d[x] = map[s[x]];
+    }
+}
+
+// Blit a w x h rectangle of 8bpp pixels. `key` is the transparent source index or
+// BLIT8_NO_KEY; `map` remaps source indices (NULL = copy as-is).
+// Little-endian byte order is assumed for the mask tests (RP2350 and x86/ARM hosts).
+static inline void blit8_rect(uint8_t *dst, int dst_pitch, const uint8_t *src, int src_pitch, int w, int h,
+                              int key, const uint8_t *map) {
+    if (w <= 0 || h <= 0) return;
+    if (key == BLIT8_NO_KEY) {
+        if (map) {
+            for (int y = 0; y < h; ++y) blit8_row_remap(dst + y * dst_pitch, src + y * src_pitch, w, map);
+        } else {
+            for (int y = 0; y < h; ++y) memcpy(dst + y * dst_pitch, src + y * src_pitch, (size_t)w);
+        }
+    } else if (map) {
+        for (int y = 0; y < h; ++y) {
+            blit8_row_key_remap(dst + y * dst_pitch, src + y * src_pitch, w, (uint8_t)key, map);
+        }
+    } else {
+        for (int y = 0; y < h; ++y) blit8_row_key(dst + y * dst_pitch, src + y * src_pitch, w, (uint8_t)key);
+    }
+}
+
+// --- Transparent-span sprites ---
+// A sprite's opaque pixels as runs per row, built once at load time. The span blitter
+// copies only the runs and never reads or tests the transparent pixels between them.
+// One allocation: header, (h + 1) row starts into the run array, then the runs.
+
+typedef struct {
+    uint16_t x;
+    uint16_t len;
+} blit8_run_t;
+
+typedef struct {
+    uint16_t w;
+    uint16_t h;
+    uint8_t key;            // Colour key the runs were built for
+    uint32_t n_runs;
+    uint32_t opaque;        // Pixels covered by runs
+    const uint16_t *row;    // row[y]..row[y + 1] index the runs of row y
+    const blit8_run_t *runs;
+} blit8_spans_t;
+
+// Opaque pixel count in *opaque_out (optional); returns the number of runs.
+static inline uint32_t blit8_spans_count(const uint8_t *src, int pitch, int w, int h, uint8_t key,
+                                         uint32_t *opaque_out) {
+    uint32_t n = 0, opaque = 0;
+    for (int y = 0; y < h; ++y) {
+        const uint8_t *s = src + y * pitch;
+        bool in_run = false;
+        for (int x = 0; x < w; ++x) {
+            const bool solid = (s[x] != key);
+            if (solid && !in_run) n++;
+            opaque += solid;
+            in_run = solid;
+        }
+    }
+    if (opaque_out) *opaque_out = opaque;
+    return n;
+}
+
+static inline size_t blit8_spans_bytes(int h, uint32_t n_runs) {
+    const size_t rows = ((size_t)(h + 1) * sizeof(uint16_t) + 3u) & ~(size_t)3u;
+    return sizeof(blit8_spans_t) + rows + (size_t)n_runs * sizeof(blit8_run_t);
+}
+
+// `mem` holds blit8_spans_bytes(h, n_runs) bytes; n_runs comes from blit8_spans_count().
+// Run indices are 16-bit, so n_runs must stay below 65536 (a 320x200 sprite has < 32000).
+static inline blit8_spans_t *blit8_spans_build(void *mem, const uint8_t *src, int pitch, int w, int h,
+                                               uint8_t key, uint32_t n_runs) {
+    blit8_spans_t *sp = (blit8_spans_t *)mem;
+    uint16_t *row = (uint16_t *)(sp + 1);
+    blit8_run_t *runs = (blit8_run_t *)((uint8_t *)row + (((size_t)(h + 1) * sizeof(uint16_t) + 3u) & ~(size_t)3u));
+    uint32_t n = 0, opaque = 0;
+    for (int y = 0; y < h; ++y) {
+        const uint8_t *s = src + y * pitch;
+        row[y] = (uint16_t)n;
+        int x = 0;
+        while (x < w) {
+            while (x < w && s[x] == key) x++;
+            const int start = x;
+            while (x < w && s[x] != key) x++;
+            if (x > start) {
+                runs[n].x = (uint16_t)start;
+                runs[n].len = (uint16_t)(x - start);
+                opaque += (uint32_t)(x - start);
+                n++;
+            }
+        }
+    }
+    row[h] = (uint16_t)n;
+    sp->w = (uint16_t)w;
+    sp->h = (uint16_t)h;
+    sp->key = key;
+    sp->n_runs = n_runs;
+    sp->opaque = opaque;
+    sp->row = row;
+    sp->runs = runs;
+    return sp;
+}
+
+// Blit the w x h source rectangle at (sx, sy) of the sprite whose pixels are `src`
+// (the whole surface, not the rectangle) to `dst`. Equivalent to blit8_rect() with
+// the spans' colour key.
+static inline void blit8_spans_blit(const blit8_spans_t *sp, uint8_t *dst, int dst_pitch, const uint8_t *src,
+                                    int src_pitch, int sx, int sy, int w, int h, const uint8_t *map) {
+    const int x_end = sx + w;
+    for (int y = 0; y < h; ++y) {
+        const int yy = sy + y;
+        const uint8_t *s = src + yy * src_pitch;
+        uint8_t *d = dst + y * dst_pitch;
+        for (uint32_t k = sp->row[yy]; k < sp->row[yy + 1]; ++k) {
+            int x0 = sp->runs[k].x;
+            int x1 = x0 + sp->runs[k].len;
+            if (x1 <= sx) continue;
+            if (x0 >= x_end) break;
+            if (x0 < sx) x0 = sx;
+            if (x1 > x_end) x1 = x_end;
+            if (map) {
+                blit8_row_remap(d + (x0 - sx), s + x0, x1 - x0, map);
+            } else {
+                memcpy(d + (x0 - sx), s + x0, (size_t)(x1 - x0));
+            }
+        }
+    }
+}
+
+#endif // BLIT8_H
@@ -0,0 +1,202 @@
+/*
+ * DMA rectangle engine
+ *
+ * Control-block chaining: the control channel writes one 4-word block into the
+ * data channel's alias-1 registers (CTRL, READ_ADDR, WRITE_ADDR, TRANS_COUNT_TRIG),
+ * the last write starts the row, and the data channel chains back to the control
+ * channel when the row is done. An all-zero block is a null trigger and ends the list.
+ * Both channels run at normal priority so HDMI scanout DMA keeps precedence.
+ */
+
+#include "dma_rect.h"
+
+#include <stddef.h>
+#include <stdalign.h>
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/sync.h"
+
+// One block per row (contiguous rectangles need one block in total).
+#define DMA_RECT_MAX_ROWS 240
+
+typedef struct {
+    uint32_t ctrl;
+    uint32_t read_addr;
+    uint32_t write_addr;
+    uint32_t count;
+} dma_rect_block_t;
+
+static alignas(16) dma_rect_block_t dma_rect_blocks[DMA_RECT_MAX_ROWS + 1];
+static uint32_t dma_rect_fill_word;
+static int dma_rect_ctrl_chan = -1;
+static int dma_rect_data_chan = -1;
+static bool dma_rect_pending = false;
+static const dma_rect_block_t *dma_rect_end = NULL;
+static dma_rect_stats_t dma_rect_stats;
+
+// Bytes a queued rectangle covers: [lo, hi), `width` of every `pitch`. width == 0: none.
+typedef struct {
+    uintptr_t lo;
+    uintptr_t hi;
+    uint32_t pitch;
+    uint32_t width;
+} dma_rect_extent_t;
+
+static dma_rect_extent_t dma_rect_dst;
+static dma_rect_extent_t dma_rect_src;
+
+bool dma_rect_init(void) {
+    if (dma_rect_ctrl_chan >= 0) return true;
+    const int ctrl = dma_claim_unused_channel(false);
+    if (ctrl < 0) return false;
+    const int data = dma_claim_unused_channel(false);
+    if (data < 0) {
+        dma_channel_unclaim((uint)ctrl);
+        return false;
+    }
+
+    // Control channel: 4 words per trigger into the data channel's alias 1, write
+    // address wrapping on a 16-byte ring so each block lands on the same registers.
+    dma_channel_config c = dma_channel_get_default_config((uint)ctrl);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, 4);
+    channel_config_set_high_priority(&c, false);
+    dma_channel_configure((uint)ctrl, &c, &dma_hw->ch[data].al1_ctrl, NULL, 4, false);
+
+    dma_rect_ctrl_chan = ctrl;
+    dma_rect_data_chan = data;
+    return true;
+}
+
+static inline bool dma_rect_hw_busy(void) {
+    if (!dma_rect_pending) return false;
+    if (dma_channel_is_busy((uint)dma_rect_ctrl_chan) || dma_channel_is_busy((uint)dma_rect_data_chan)) return true;
+    // Between a row finishing and the chained control transfer starting, both channels
+    // can read idle; the list is only done once the null block has been fetched.
+    if (dma_hw->ch[dma_rect_ctrl_chan].read_addr != (uintptr_t)dma_rect_end) return true;
+    dma_rect_pending = false;
+    return false;
+}
+
+bool dma_rect_busy(void) {
+    return dma_rect_hw_busy();
+}
+
+void dma_rect_fence(void) {
+    if (!dma_rect_hw_busy()) return;
+    const uint32_t t0 = time_us_32();
+    while (dma_rect_hw_busy()) tight_loop_contents();
+    dma_rect_stats.fence_waits++;
+    dma_rect_stats.fence_us += time_us_32() - t0;
+}
+
+static dma_rect_extent_t dma_rect_extent(const uint8_t *p, int pitch, int width, int height) {
+    if (!p || width <= 0 || height <= 0) return (dma_rect_extent_t){ 0, 0, 0, 0 };
+    if (pitch == width) {
+        width *= height;
+        pitch = width;
+        height = 1;
+    }
+    const uintptr_t lo = (uintptr_t)p;
+    return (dma_rect_extent_t){ lo, lo + (uintptr_t)(height - 1) * (uintptr_t)pitch + (uintptr_t)width,
+                                (uint32_t)pitch, (uint32_t)width };
+}
+
+// Rows of the same pitch overlap only where their columns (address mod pitch) do;
+// anything else with intersecting byte ranges is treated as overlapping.
+static bool dma_rect_overlaps(const dma_rect_extent_t *a, const dma_rect_extent_t *b) {
+    if (!a->width || !b->width || a->hi <= b->lo || b->hi <= a->lo) return false;
+    if (a->pitch != b->pitch || a->width >= a->pitch || b->width >= b->pitch) return true;
+    const uint32_t pitch = a->pitch;
+    const uint32_t ax = (uint32_t)(a->lo % pitch);
+    const uint32_t bx = (uint32_t)(b->lo % pitch);
+    return (bx + pitch - ax) % pitch < a->width || (ax + pitch - bx) % pitch < b->width;
+}
+
+void dma_rect_fence_rect(const uint8_t *p, int pitch, int width, int height, bool write) {
+    if (!dma_rect_hw_busy()) return;
+    const dma_rect_extent_t e = dma_rect_extent(p, pitch, width, height);
+    if (!dma_rect_overlaps(&e, &dma_rect_dst) && !(write && dma_rect_overlaps(&e, &dma_rect_src))) {
+        dma_rect_stats.fence_skips++;
+        return;
+    }
+    dma_rect_fence();
+}
+
+static uint32_t dma_rect_data_ctrl(bool word, bool read_incr) {
+    dma_channel_config c = dma_channel_get_default_config((uint)dma_rect_data_chan);
+    channel_config_set_transfer_data_size(&c, word ? DMA_SIZE_32 : DMA_SIZE_8);
+    channel_config_set_read_increment(&c, read_incr);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_chain_to(&c, (uint)dma_rect_ctrl_chan);
+    channel_config_set_irq_quiet(&c, true);
+    channel_config_set_high_priority(&c, false);
+    return channel_config_get_ctrl_value(&c);
+}
+
+// src == NULL: fill from dma_rect_fill_word.
+static bool dma_rect_start(uint8_t *dst, int dst_pitch, const uint8_t *src, int src_pitch, int width, int height) {
+    if (dma_rect_ctrl_chan < 0 || width <= 0 || height <= 0) {
+        dma_rect_stats.fallbacks++;
+        return false;
+    }
+    const bool fill = (src == NULL);
+    const bool contiguous = (dst_pitch == width) && (fill || src_pitch == width);
+    if (!contiguous && height > DMA_RECT_MAX_ROWS) {
+        dma_rect_stats.fallbacks++;
+        return false;
+    }
+
+    dma_rect_fence();
+
+    uintptr_t align = (uintptr_t)dst | (uintptr_t)width | (uintptr_t)dst_pitch;
+    if (!fill) align |= (uintptr_t)src | (uintptr_t)src_pitch;
+    const bool word = (align & 3u) == 0;
+    const uint32_t ctrl = dma_rect_data_ctrl(word, !fill);
+    const uint32_t read_fill = (uint32_t)(uintptr_t)&dma_rect_fill_word;
+
+    int n = 0;
+    if (contiguous) {
+        const uint32_t bytes = (uint32_t)width * (uint32_t)height;
+        dma_rect_blocks[n++] = (dma_rect_block_t){ ctrl, fill ? read_fill : (uint32_t)(uintptr_t)src,
+                                                   (uint32_t)(uintptr_t)dst, word ? bytes / 4u : bytes };
+    } else {
+        const uint32_t count = word ? (uint32_t)width / 4u : (uint32_t)width;
+        for (int y = 0; y < height; ++y) {
+            dma_rect_blocks[n++] = (dma_rect_block_t){ ctrl,
+                fill ? read_fill : (uint32_t)(uintptr_t)(src + y * src_pitch),
+                (uint32_t)(uintptr_t)(dst + y * dst_pitch), count };
+        }
+    }
+    dma_rect_blocks[n++] = (dma_rect_block_t){ 0, 0, 0, 0 };
+    dma_rect_end = &dma_rect_blocks[n];
+    dma_rect_dst = dma_rect_extent(dst, dst_pitch, width, height);
+    dma_rect_src = dma_rect_extent(src, src_pitch, width, height);
+
+    // Blocks are written by the CPU and read by DMA: complete the stores first.
+    __dsb();
+    dma_rect_pending = true;
+    dma_channel_set_read_addr((uint)dma_rect_ctrl_chan, dma_rect_blocks, true);
+
+    dma_rect_stats.rects++;
+    dma_rect_stats.bytes += (uint32_t)width * (uint32_t)height;
+    return true;
+}
+
+bool dma_rect_copy(uint8_t *dst, int dst_pitch, const uint8_t *src, int src_pitch, int width, int height) {
+    if (!src) return false;
+    return dma_rect_start(dst, dst_pitch, src, src_pitch, width, height);
+}
+
+bool dma_rect_fill(uint8_t *dst, int dst_pitch, uint8_t value, int width, int height) {
+    // The previous fill may still be reading the fill word.
+    dma_rect_fence();
+    dma_rect_fill_word = value * 0x01010101u;
+    return dma_rect_start(dst, dst_pitch, NULL, 0, width, height);
+}
+
+void dma_rect_get_stats(dma_rect_stats_t *out) {
+    if (out) *out = dma_rect_stats;
+}
@@ -0,0 +1,57 @@
+/*
+ * DMA rectangle engine - Header
+ *
+ * Copies or fills 8bpp rectangles with a spare DMA channel pair while the CPU
+ * carries on. One row per DMA control block: a control channel feeds the blocks
+ * to a data channel, so a whole rectangle runs without CPU or IRQ involvement.
+ *
+ * One rectangle is in flight at a time; starting another waits for the first.
+ * Before the CPU reads or writes pixels a queued transfer may cover, callers call
+ * dma_rect_fence_rect() for those pixels (it waits only on an overlap), or
+ * dma_rect_fence() when the extent is unknown and before a frame is presented.
+ */
+
+#ifndef DMA_RECT_H
+#define DMA_RECT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Claim the DMA channels. Returns false (and every call falls back) if none are free.
+bool dma_rect_init(void);
+
+// Queue a width x height byte copy / fill. Returns false if the caller should do it
+// with the CPU instead (engine not initialised, too many rows).
+bool dma_rect_copy(uint8_t *dst, int dst_pitch, const uint8_t *src, int src_pitch, int width, int height);
+bool dma_rect_fill(uint8_t *dst, int dst_pitch, uint8_t value, int width, int height);
+
+// True while a queued rectangle is still being transferred.
+bool dma_rect_busy(void);
+
+// Wait for the queued rectangle (if any) to complete.
+void dma_rect_fence(void);
+
+// Wait for the queued rectangle only if it touches the width x height byte rectangle
+// at p: any overlap with its destination, or with its source when `write` is set.
+void dma_rect_fence_rect(const uint8_t *p, int pitch, int width, int height, bool write);
+
+typedef struct {
+    uint32_t rects;       // Rectangles queued
+    uint32_t bytes;       // Bytes moved by DMA
+    uint32_t fallbacks;   // Requests handed back to the CPU
+    uint32_t fence_waits; // Fences that found the engine still busy
+    uint32_t fence_us;    // Total time spent waiting in those fences
+    uint32_t fence_skips; // Rect fences that did not overlap the busy transfer
+} dma_rect_stats_t;
+
+void dma_rect_get_stats(dma_rect_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DMA_RECT_H
@@ -0,0 +1,161 @@
+#ifndef INVERSE_CMAP_H
+#define INVERSE_CMAP_H
+
+// Inverse colormap: RGB -> nearest palette index without a 256-entry scan per pixel.
+//
+// RGB space is split into 16x16x16 cells. The first lookup in a cell builds the list
+// of palette entries that can be nearest to any colour inside it (an entry whose
+// minimum distance to the cell exceeds the smallest maximum distance of any entry can
+// never win). Lookups then scan only that short list, in palette order with a strict
+// '<', so the result - ties included - is identical to the linear search it replaces.
+// A 32x32x32 single-index table would be smaller per lookup but merges VGA shades
+// that are 4 apart, so it cannot match the linear search.
+//
+// Plain C, no Pico SDK: tools/invcmap_bench.c builds it on the host.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+
+#define INVCMAP_CELL_BITS 4
+#define INVCMAP_CELLS (1 << (3 * INVCMAP_CELL_BITS))
+#define INVCMAP_POOL_SIZE 4096
+#define INVCMAP_UNBUILT 0xFFFFu
+#define INVCMAP_SNAPSHOT_MAX 16
+
+typedef struct {
+    // What the map was built for; the owner compares these before each use.
+    const void *key;
+    uint32_t version;
+    int first;
+    int count;
+    bool skip_reserved;     // Exclude HDMI control indices 240..243
+    uint8_t snapshot[INVCMAP_SNAPSHOT_MAX * 4];  // The range's colours, if count <= INVCMAP_SNAPSHOT_MAX
+
+    uint16_t cell[INVCMAP_CELLS];  // Offset of the cell's list in pool, or INVCMAP_UNBUILT
+    uint8_t pool[INVCMAP_POOL_SIZE];  // Per list: (n - 1), then n palette indices
+    uint16_t pool_used;
+
+    uint32_t cells_built;
+    uint32_t resets;
+    uint32_t rebinds;
+} invcmap_t;
+
+static inline void invcmap_reset(invcmap_t *m, const void *key, uint32_t version, int first, int count,
+                                 bool skip_reserved) {
+    memset(m->cell, 0xFF, sizeof(m->cell));
+    m->pool_used = 0;
+    m->key = key;
+    m->version = version;
+    m->first = first;
+    m->count = count;
+    m->skip_reserved = skip_reserved;
+    m->resets++;
+}
+
+static inline bool invcmap_matches(const invcmap_t *m, const void *key, uint32_t version, int first, int count,
+                                   bool skip_reserved) {
+    return m->key == key && m->version == version && m->first == first && m->count == count &&
+           m->skip_reserved == skip_reserved;
+}
+
+// Makes the map serve (key, version, first, count) for `colors`. A small range whose
+// colours equal the ones the map was built from keeps its cells and only takes the new
+// key: load_image() gives every sprite its own copy of the chtab palette, which would
+// otherwise reset the map for each image.
+static inline void invcmap_bind(invcmap_t *m, const void *key, uint32_t version, const uint8_t *colors, int first,
+                                int count, bool skip_reserved) {
+    if (invcmap_matches(m, key, version, first, count, skip_reserved)) return;
+    const size_t bytes = (size_t)count * 4;
+    if (count <= INVCMAP_SNAPSHOT_MAX && m->count == count && m->first == first &&
+        m->skip_reserved == skip_reserved && memcmp(m->snapshot, &colors[first * 4], bytes) == 0) {
+        m->key = key;
+        m->version = version;
+        m->rebinds++;
+        return;
+    }
+    invcmap_reset(m, key, version, first, count, skip_reserved);
+    if (count <= INVCMAP_SNAPSHOT_MAX) memcpy(m->snapshot, &colors[first * 4], bytes);
+}
+
+static inline bool invcmap_skip(const invcmap_t *m, int i) {
+    return m->skip_reserved && i >= 240 && i <= 243;
+}
+
+static inline int invcmap_axis_min(int v, int lo, int hi) {
+    const int d = (v < lo) ? (lo - v) : (v > hi) ? (v - hi) : 0;
+    return d * d;
+}
+
+static inline int invcmap_axis_max(int v, int lo, int hi) {
+    const int a = v - lo, b = hi - v;
+    const int d = (a > b) ? a : b;
+    return d * d;
+}
+
+// `colors`: palette entries as r,g,b,a bytes (SDL_Color layout).
+static uint16_t invcmap_build_cell(invcmap_t *m, const uint8_t *colors, unsigned cell) {
+    const int span = 256 >> INVCMAP_CELL_BITS;
+    const int r0 = (int)(cell >> (2 * INVCMAP_CELL_BITS)) * span;
+    const int g0 = (int)((cell >> INVCMAP_CELL_BITS) & ((1u << INVCMAP_CELL_BITS) - 1)) * span;
+    const int b0 = (int)(cell & ((1u << INVCMAP_CELL_BITS) - 1)) * span;
+    const int end = m->first + m->count;
+
+    int bound = INT_MAX;
+    for (int i = m->first; i < end; ++i) {
+        if (invcmap_skip(m, i)) continue;
+        const uint8_t *c = &colors[i * 4];
+        const int d = invcmap_axis_max(c[0], r0, r0 + span - 1) + invcmap_axis_max(c[1], g0, g0 + span - 1) +
+                      invcmap_axis_max(c[2], b0, b0 + span - 1);
+        if (d < bound) bound = d;
+    }
+
+    if (m->pool_used + 1 + m->count > INVCMAP_POOL_SIZE) {
+        invcmap_reset(m, m->key, m->version, m->first, m->count, m->skip_reserved);
+    }
+    const uint16_t off = m->pool_used;
+    uint8_t *list = &m->pool[off + 1];
+    int n = 0;
+    for (int i = m->first; i < end; ++i) {
+        if (invcmap_skip(m, i)) continue;
+        const uint8_t *c = &colors[i * 4];
+        const int d = invcmap_axis_min(c[0], r0, r0 + span - 1) + invcmap_axis_min(c[1], g0, g0 + span - 1) +
+                      invcmap_axis_min(c[2], b0, b0 + span - 1);
+        if (d <= bound) list[n++] = (uint8_t)i;
+    }
+    m->pool[off] = (uint8_t)(n - 1);
+    m->pool_used = (uint16_t)(off + 1 + n);
+    m->cell[cell] = off;
+    m->cells_built++;
+    return off;
+}
+
+// Nearest entry to (r, g, b); the map must have at least one selectable entry.
+static inline uint8_t invcmap_lookup(invcmap_t *m, const uint8_t *colors, uint8_t r, uint8_t g, uint8_t b) {
+    const unsigned shift = 8 - INVCMAP_CELL_BITS;
+    const unsigned cell = ((unsigned)(r >> shift) << (2 * INVCMAP_CELL_BITS)) |
+                          ((unsigned)(g >> shift) << INVCMAP_CELL_BITS) | (unsigned)(b >> shift);
+    uint16_t off = m->cell[cell];
+    if (off == INVCMAP_UNBUILT) off = invcmap_build_cell(m, colors, cell);
+
+    const uint8_t *list = &m->pool[off];
+    const int n = list[0] + 1;
+    uint8_t best_index = list[1];
+    int best_distance = INT_MAX;
+    for (int k = 1; k <= n; ++k) {
+        const uint8_t *c = &colors[list[k] * 4];
+        const int dr = (int)r - (int)c[0];
+        const int dg = (int)g - (int)c[1];
+        const int db = (int)b - (int)c[2];
+        const int distance = dr * dr + dg * dg + db * db;
+        if (distance < best_distance) {
+            best_distance = distance;
+            best_index = list[k];
+            if (distance == 0) break;
+        }
+    }
+    return best_index;
+}
+
+#endif // INVERSE_CMAP_H
@@ -12,6 +12,7 @@
 #endif
 #include <stdio.h>
 #include <string.h>
+#include <stdalign.h>
 
 #include "board_config.h"
 #include "HDMI.h"
@@ -47,9 +48,11 @@
 
 // HDMI scanout reads this buffer in a tight per-line ISR.
 // Keep it in SRAM for reliable, fast reads (PSRAM can cause visible artifacts).
-static uint8_t graphics_buffer_storage[FRAME_W * FRAME_H];
+// With RP2350_ZERO_COPY_SCANOUT it only backs the boot/start screens; SDLPoP frames
+// are scanned out from the onscreen surface instead.
+static alignas(4) uint8_t graphics_buffer_storage[FRAME_W * FRAME_H];
 
-// SDLPoP SDL shim writes frames here.
+// SDLPoP SDL shim writes frames here (copy scanout only).
 uint8_t *graphics_buffer = graphics_buffer_storage;
 
 // SDLPoP entrypoint (renamed from main via build defines)
@@ -167,6 +170,13 @@ int main(void) {
 
     setup_basic_palette();
 
+#if HDMI_TELEMETRY
+    DBG_PRINTF("HDMI telemetry: send 't' (dump) or 'T' (dump + reset) over serial during gameplay\n");
+#endif
+#if MEM_TELEMETRY
+    DBG_PRINTF("Memory telemetry: send 'm' (dump) or 'M' (dump + reset high water) over serial during gameplay\n");
+#endif
+
 #if RP2350_BOOT_TEST_PATTERN
     if (RP2350_BOOT_TEST_PATTERN_MODE == 1) {
         DBG_PRINTF("BOOT TEST PATTERN: displaying 0..239 ramp + grayscale palette\n");
@@ -194,6 +204,9 @@ int main(void) {
 
     // Main loop: show start screen, run game, repeat on quit
     while (true) {
+        // The previous session may have left scanout on the SDLPoP onscreen surface.
+        graphics_set_scanout(graphics_buffer, FRAME_W, FRAME_H, 0);
+
         // Check SD card and data directory
         DBG_PRINTF("Checking SD card and game data...\n");
         start_error_t err = start_screen_check_requirements();
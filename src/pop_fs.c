@@ -6,16 +6,57 @@
 
 #include "diskio.h"
 #include "pico/stdlib.h"  // For sleep_us
-
-// Chunk size for yielding file reads (512 bytes = 1 SD sector)
-// This allows HDMI DMA to access memory between SD reads
-#define POP_FS_READ_CHUNK_SIZE 512
+#include "HDMI.h"         // graphics_note_io (underrun correlation)
+#include "pop_fs_cache.h"
+#include "psram_allocator.h"
+#include "sdcard.h"       // Negotiated SD clock for the pacing budget
+
+// Large reads: the unaligned head and tail go through FatFS's sector buffer, the whole
+// sectors in between are read in bursts straight into the destination, which FatFS
+// issues as one multi-block (CMD18) read per burst (split only at cluster ends).
+#ifndef POP_FS_BURST_SECTORS
+#define POP_FS_BURST_SECTORS 32
+#endif
+
+// HDMI-safe pacing. Reads run unpaced until the scanout reports an underrun during a
+// burst; from then on the rest of that read uses half-size bursts and, with
+// POP_FS_PACE_AFTER_UNDERRUN, rests after each chunk as long as the chunk took.
+// POP_FS_PACE_HDMI_SHARE > 0 additionally caps every read at (100 - share) percent of
+// clk/8 at the negotiated clock (disk_get_clock_info); off by default, since it
+// stretches every level load and HDMI does not use the SPI bus.
+#ifndef POP_FS_PACE_AFTER_UNDERRUN
+#define POP_FS_PACE_AFTER_UNDERRUN 1
+#endif
+#ifndef POP_FS_PACE_HDMI_SHARE
+#define POP_FS_PACE_HDMI_SHARE 0
+#endif
+
+// Path cache (pop_fs_cache.h): slots in PSRAM, 40 bytes each; 0 disables it. The data
+// tree has about 1100 names, the table stops taking entries at 3/4 full.
+#ifndef POP_FS_PATH_CACHE_SLOTS
+#define POP_FS_PATH_CACHE_SLOTS 4096
+#endif
 
 static FATFS g_fs;
 static bool g_mounted = false;
+static pop_fs_stats_t g_stats;
+static pop_fs_cache_t g_cache;
+
+static void pop_fs_cache_setup(void) {
+#if POP_FS_PATH_CACHE_SLOTS
+    if (g_cache.slots) {
+        pop_fs_cache_flush(&g_cache);
+        return;
+    }
+    pop_fs_cache_entry_t* slots = (pop_fs_cache_entry_t*)psram_malloc_cat(
+        sizeof(pop_fs_cache_entry_t) * POP_FS_PATH_CACHE_SLOTS, MEM_CAT_OTHER);
+    if (slots) pop_fs_cache_init(&g_cache, slots, POP_FS_PATH_CACHE_SLOTS);
+#endif
+}
 
 // Reset mounted state (call before start screen check on re-entry)
 void pop_fs_reset(void) {
+    pop_fs_cache_flush(&g_cache);
     g_mounted = false;
 }
 
@@ -37,6 +78,9 @@ bool pop_fs_init(void) {
     
     // Set current directory to root (required for relative paths to work)
     f_chdir("/");
+
+    // Cached locations are only valid for this mount.
+    pop_fs_cache_setup();
     
     g_mounted = true;
     return true;
@@ -96,55 +140,139 @@ FIL* pop_fs_open(const char* pop_path, const char* mode) {
     char full[256];
     pop_fs_make_path(full, sizeof(full), pop_path);
 
+    const BYTE fmode = fatfs_mode_from_stdio(mode);
+    pop_fs_cache_entry_t* entry = NULL;
+    if (fmode & FA_WRITE) {
+        pop_fs_cache_flush(&g_cache);
+    } else {
+        const pop_fs_cache_result_t found = pop_fs_cache_lookup(&g_cache, full, &entry);
+        if (found == POP_FS_CACHE_MISSING || (entry && (entry->attr & AM_DIR))) {
+            g_cache.misses++;
+            return NULL;
+        }
+    }
+
     FIL* fil = (FIL*)calloc(1, sizeof(FIL));
     if (!fil) return NULL;
 
-    FRESULT fr = f_open(fil, full, fatfs_mode_from_stdio(mode));
+    if (entry && entry->kind == POP_FS_CACHE_RESOLVED) {
+        pop_fs_cache_open(entry, &g_fs, fil);
+        g_cache.hits++;
+        return fil;
+    }
+    g_cache.walks++;
+    FRESULT fr = f_open(fil, full, fmode);
     if (fr != FR_OK) {
         free(fil);
         return NULL;
     }
+    if (entry) pop_fs_cache_resolve(entry, fil);
     return fil;
 }
 
+// Read budget in bytes per millisecond at the current SD clock, 0 = unpaced.
+static uint32_t pop_fs_pace_rate(void) {
+#if POP_FS_PACE_HDMI_SHARE > 0 && POP_FS_PACE_HDMI_SHARE < 100
+    sd_clock_info_t sd;
+    disk_get_clock_info(&sd);
+    return (uint32_t)((uint64_t)sd.clk_hz * (100u - POP_FS_PACE_HDMI_SHARE) / (8u * 1000u * 100u));
+#else
+    return 0;
+#endif
+}
+
+static void pop_fs_pace(UINT bytes, uint32_t elapsed_us, uint32_t bytes_per_ms, bool after_underrun) {
+    uint32_t budget_us = bytes_per_ms ? (uint32_t)(((uint64_t)bytes * 1000u) / bytes_per_ms) : 0;
+#if POP_FS_PACE_AFTER_UNDERRUN
+    if (after_underrun && budget_us < 2u * elapsed_us) budget_us = 2u * elapsed_us;
+#else
+    (void)after_underrun;
+#endif
+    if (elapsed_us >= budget_us) return;
+    sleep_us(budget_us - elapsed_us);
+    g_stats.pace_us += budget_us - elapsed_us;
+    g_stats.paced++;
+}
+
 size_t pop_fs_read(void* ptr, size_t size, size_t nmemb, FIL* fil) {
     if (!fil || !ptr) return 0;
     UINT total_bytes = (UINT)(size * nmemb);
     if (total_bytes == 0) return 0;
 
-    // Read in chunks to allow HDMI DMA access to memory between SD operations.
-    // This prevents HDMI signal dropouts during heavy file loading.
     uint8_t* dst = (uint8_t*)ptr;
     UINT total_read = 0;
-    
+    UINT burst = POP_FS_BURST_SECTORS * FF_MIN_SS;
+    const uint32_t pace_rate = pop_fs_pace_rate();  // The clock only changes on read errors
+    g_stats.pace_kbps = pace_rate * 1000u / 1024u;
+    bool underrun_seen = false;
+    const uint32_t t_start = time_us_32();
+    g_stats.reads++;
+    graphics_note_io(true);
+
     while (total_bytes > 0) {
-        UINT chunk = (total_bytes > POP_FS_READ_CHUNK_SIZE) ? POP_FS_READ_CHUNK_SIZE : total_bytes;
+        // Up to the next sector boundary first, so the bursts after it are aligned.
+        const UINT head = (UINT)((FF_MIN_SS - f_tell(fil) % FF_MIN_SS) % FF_MIN_SS);
+        UINT chunk;
+        if (head) {
+            chunk = (head < total_bytes) ? head : total_bytes;
+        } else if (total_bytes >= FF_MIN_SS) {
+            const UINT whole = total_bytes - total_bytes % FF_MIN_SS;
+            chunk = (whole < burst) ? whole : burst;
+        } else {
+            chunk = total_bytes;
+        }
+
+        const uint32_t underruns = graphics_get_hdmi_underrun_count();
+        const uint32_t t0 = time_us_32();
         UINT br = 0;
-        
         FRESULT fr = f_read(fil, dst, chunk, &br);
         if (fr != FR_OK) break;
-        
+        const uint32_t elapsed_us = time_us_32() - t0;
+
         total_read += br;
         dst += br;
         total_bytes -= br;
-        
+        if (br >= FF_MIN_SS) {
+            g_stats.bursts++;
+            g_stats.sectors += br / FF_MIN_SS;
+            if (elapsed_us) {
+                const uint32_t kbps = (uint32_t)(((uint64_t)br * 1000000u) / ((uint64_t)elapsed_us * 1024u));
+                if (kbps > g_stats.peak_kbps) g_stats.peak_kbps = kbps;
+            }
+            if (graphics_get_hdmi_underrun_count() != underruns) {
+                g_stats.underruns++;
+                underrun_seen = true;
+                if (burst > FF_MIN_SS) burst /= 2;
+            }
+        }
+
         // If we read less than requested, we hit EOF
-        if (br < chunk) break;
-        
-        // Yield between chunks: memory barrier + brief pause for HDMI DMA
-        __asm volatile ("dsb" ::: "memory");
-        __asm volatile ("isb");
-        sleep_us(10);  // 10us pause allows ~3-4 HDMI scanlines worth of DMA
+        if (br < chunk || total_bytes == 0) break;
+        pop_fs_pace(br, elapsed_us, pace_rate, underrun_seen);
     }
-    
+    graphics_note_io(false);
+    g_stats.bytes += total_read;
+    g_stats.busy_us += time_us_32() - t_start;
+
     return (size > 0) ? (total_read / (UINT)size) : 0;
 }
 
+void pop_fs_get_stats(pop_fs_stats_t* out) {
+    if (!out) return;
+    *out = g_stats;
+    out->open_hits = g_cache.hits;
+    out->open_misses = g_cache.misses;
+    out->open_walks = g_cache.walks;
+    out->dir_lists = g_cache.lists;
+    out->cache_flushes = g_cache.flushes;
+}
+
 size_t pop_fs_write(const void* ptr, size_t size, size_t nmemb, FIL* fil) {
     if (!fil || !ptr) return 0;
     UINT bw = 0;
     UINT to_write = (UINT)(size * nmemb);
     if (to_write == 0) return 0;
+    pop_fs_cache_flush(&g_cache);
 
     FRESULT fr = f_write(fil, ptr, to_write, &bw);
     if (fr != FR_OK) return 0;
@@ -177,7 +305,12 @@ long pop_fs_tell(FIL* fil) {
 
 int pop_fs_close(FIL* fil) {
     if (!fil) return 0;
+#if FF_FS_LOCK
+    // Reopened from the path cache: never entered in FatFS's lock table, nothing to flush.
+    if (fil->obj.lockid != 0) (void)f_close(fil);
+#else
     (void)f_close(fil);
+#endif
     free(fil);
     return 0;
 }
@@ -188,6 +321,12 @@ bool pop_fs_exists(const char* pop_path) {
     char full[256];
     pop_fs_make_path(full, sizeof(full), pop_path);
 
+    pop_fs_cache_entry_t* entry;
+    switch (pop_fs_cache_lookup(&g_cache, full, &entry)) {
+        case POP_FS_CACHE_FOUND: return true;
+        case POP_FS_CACHE_MISSING: g_cache.misses++; return false;
+        default: break;
+    }
     FILINFO fno;
     FRESULT fr = f_stat(full, &fno);
     return fr == FR_OK;
@@ -198,6 +337,7 @@ bool pop_fs_mkdir(const char* pop_path) {
     char full[256];
     pop_fs_make_path(full, sizeof(full), pop_path);
 
+    pop_fs_cache_flush(&g_cache);
     FRESULT fr = f_mkdir(full);
     // FR_OK = created, FR_EXIST = already exists (both are success)
     return fr == FR_OK || fr == FR_EXIST;
@@ -209,6 +349,7 @@ bool pop_fs_delete(const char* pop_path) {
     char full[256];
     pop_fs_make_path(full, sizeof(full), pop_path);
 
+    pop_fs_cache_flush(&g_cache);
     FRESULT fr = f_unlink(full);
     return fr == FR_OK;
 }
\ No newline at end of file
@@ -13,13 +13,15 @@ extern "C" {
 // Returns true on success.
 bool pop_fs_init(void);
 
-// Reset mounted state (for re-entry after quit)
+// Reset mounted state (for re-entry after quit); also drops the path cache.
 void pop_fs_reset(void);
 
 // Convert a SDLPoP relative path (e.g. "data/PRINCE.DAT") to a FatFS path ("0:/data/PRINCE.DAT").
 // dst must be large enough (POP_MAX_PATH in SDLPoP is typically 4096, but we keep it simple here).
 const char* pop_fs_make_path(char* dst, size_t dst_size, const char* pop_path);
 
+// Read-only opens go through a path cache (pop_fs_cache.h) that is filled once per
+// mount and dropped by every write, mkdir or delete.
 FIL* pop_fs_open(const char* pop_path, const char* mode);
 size_t pop_fs_read(void* ptr, size_t size, size_t nmemb, FIL* fil);
 size_t pop_fs_write(const void* ptr, size_t size, size_t nmemb, FIL* fil);
@@ -27,6 +29,27 @@ int pop_fs_seek(FIL* fil, long offset, int whence);
 long pop_fs_tell(FIL* fil);
 int pop_fs_close(FIL* fil);
 
+// pop_fs_read throughput and pop_fs_open path cache use since boot.
+typedef struct {
+    uint32_t reads;       // pop_fs_read calls
+    uint64_t bytes;
+    uint32_t sectors;     // Whole sectors read straight into the destination
+    uint32_t bursts;      // Multi-sector f_read calls
+    uint32_t busy_us;     // Time spent in pop_fs_read, pacing included
+    uint32_t pace_us;     // ... of which waiting out the bandwidth budget
+    uint32_t paced;       // Chunks that waited (after an underrun, or under the share cap)
+    uint32_t pace_kbps;   // POP_FS_PACE_HDMI_SHARE cap at the current SD clock, 0 = none
+    uint32_t peak_kbps;   // Fastest burst
+    uint32_t underruns;   // Bursts during which HDMI reported an underrun
+    uint32_t open_hits;   // Opens served from a cached location, no directory walk
+    uint32_t open_misses; // Opens/exists answered "no such file" from the cache
+    uint32_t open_walks;  // Opens that walked the directories (f_open)
+    uint32_t dir_lists;   // Directories listed into the cache
+    uint32_t cache_flushes; // Writes that dropped the cache
+} pop_fs_stats_t;
+
+void pop_fs_get_stats(pop_fs_stats_t* out);
+
 bool pop_fs_exists(const char* pop_path);
 bool pop_fs_mkdir(const char* pop_path);
 bool pop_fs_delete(const char* pop_path);
@@ -0,0 +1,282 @@
+#ifndef POP_FS_CACHE_H
+#define POP_FS_CACHE_H
+
+// Path cache for pop_fs_open(). SDLPoP looks every DAT up in the root before data/ and
+// every resource in each open DAT's directory in chain order, so most opens are misses,
+// and each open walks the directory clusters with LFN matching. Here the first lookup in
+// a directory lists it once (long and 8.3 names); after that a name that is not in the
+// listing fails without touching the card, and a file opened once is reopened from its
+// cached first cluster and size without a directory walk.
+//
+// The cache belongs to one mount: the owner flushes it on mount and on every write
+// (open for writing, write, mkdir, delete). Files reopened from it are not entered in
+// FatFS's lock table, which only matters for writers, and writers flush the cache.
+//
+// Plain C on FatFS, no Pico SDK: pop_fs.c owns the cache of the mounted volume,
+// tools/pop_fs_cache_sim.c runs it against FatFS on a RAM disk.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "ff.h"
+
+#define POP_FS_CACHE_MAX_PATH 256
+
+typedef enum {
+    POP_FS_CACHE_EMPTY = 0,
+    POP_FS_CACHE_LISTED,    // Name seen in its directory's listing, not opened yet
+    POP_FS_CACHE_RESOLVED,  // Opened once: first cluster, size and chain state known
+    POP_FS_CACHE_DIR,       // Directory listed completely: absent names do not exist
+    POP_FS_CACHE_NO_DIR,    // Not an existing directory: nothing below it exists
+} pop_fs_cache_kind_t;
+
+// A path as the cache matches it: two independent hashes of the upper-cased path and its
+// length, so two names must collide in all three to be confused.
+typedef struct {
+    uint64_t hash;          // FNV-1a, 0 = empty slot
+    uint32_t check;         // Multiply-rotate hash of the same bytes
+    uint16_t len;
+} pop_fs_cache_key_t;
+
+typedef struct {
+    uint64_t key;           // pop_fs_cache_key_t of the full path
+    FSIZE_t objsize;
+    DWORD sclust;
+#if FF_FS_EXFAT
+    DWORD n_cont;
+#endif
+    uint32_t check;
+    uint16_t len;
+    BYTE attr;
+    BYTE stat;
+    BYTE kind;
+} pop_fs_cache_entry_t;
+
+typedef struct {
+    pop_fs_cache_entry_t *slots;
+    uint32_t mask;          // Slot count - 1 (power of two)
+    uint32_t used;
+    uint32_t hits;          // Opens served from a resolved entry
+    uint32_t misses;        // Lookups answered "does not exist" without the card
+    uint32_t walks;         // Opens left to f_open()
+    uint32_t lists;         // Directories listed
+    uint32_t flushes;
+} pop_fs_cache_t;
+
+typedef enum {
+    POP_FS_CACHE_UNKNOWN = 0,   // Not cacheable or not listed: ask FatFS
+    POP_FS_CACHE_MISSING,
+    POP_FS_CACHE_FOUND,
+} pop_fs_cache_result_t;
+
+// `slots` holds `count` entries, a power of two.
+static inline void pop_fs_cache_init(pop_fs_cache_t *c, pop_fs_cache_entry_t *slots, uint32_t count) {
+    memset(c, 0, sizeof(*c));
+    c->slots = slots;
+    c->mask = count - 1;
+    memset(slots, 0, sizeof(*slots) * count);
+}
+
+static inline void pop_fs_cache_flush(pop_fs_cache_t *c) {
+    if (!c->slots || c->used == 0) return;
+    memset(c->slots, 0, sizeof(*c->slots) * (c->mask + 1));
+    c->used = 0;
+    c->flushes++;
+}
+
+#define POP_FS_CACHE_KEY_INIT { 14695981039346656037ull, 0x9E3779B9u, 0 }
+
+// Hashes the upper-cased path into `key`, continuing from it (POP_FS_CACHE_KEY_INIT to
+// start). False for what FatFS would not match byte for byte: non-ASCII (Unicode case
+// folding), "." and ".." segments, empty segments and names with leading spaces or
+// trailing dots or spaces, which FatFS strips.
+static inline bool pop_fs_cache_key(const char *path, size_t len, pop_fs_cache_key_t *key) {
+    if (len > 0xFFFFu - key->len) return false;
+    uint64_t h = key->hash;
+    uint32_t h2 = key->check;
+    size_t seg = 0;
+    for (size_t i = 0; i <= len; ++i) {
+        const char ch = (i < len) ? path[i] : '/';
+        if ((unsigned char)ch >= 0x80) return false;
+        if (ch == '/' || ch == '\\') {
+            const size_t n = i - seg;
+            if (i > 0 && path[i - 1] != ':') {
+                if (n == 0 || path[seg] == ' ' || path[i - 1] == '.' || path[i - 1] == ' ') return false;
+            }
+            seg = i + 1;
+            if (i == len) break;
+        }
+        const char u = (ch >= 'a' && ch <= 'z') ? (char)(ch - 'a' + 'A') : (ch == '\\' ? '/' : ch);
+        h ^= (uint8_t)u;
+        h *= 1099511628211ull;
+        h2 = (h2 ^ (uint8_t)u) * 0x85EBCA6Bu;
+        h2 = (h2 << 13) | (h2 >> 19);
+    }
+    key->hash = h ? h : 1;
+    key->check = h2;
+    key->len = (uint16_t)(key->len + len);
+    return true;
+}
+
+static inline bool pop_fs_cache_match(const pop_fs_cache_entry_t *e, const pop_fs_cache_key_t *key) {
+    return e->key == key->hash && e->check == key->check && e->len == key->len;
+}
+
+static inline pop_fs_cache_entry_t *pop_fs_cache_find(pop_fs_cache_t *c, const pop_fs_cache_key_t *key) {
+    if (!c->slots) return NULL;
+    for (uint32_t i = (uint32_t)key->hash & c->mask;; i = (i + 1) & c->mask) {
+        pop_fs_cache_entry_t *e = &c->slots[i];
+        if (pop_fs_cache_match(e, key)) return e;
+        if (e->key == 0) return NULL;
+    }
+}
+
+// The entry for `key`, new (kind EMPTY) or existing; NULL once the table is 3/4 full.
+static inline pop_fs_cache_entry_t *pop_fs_cache_insert(pop_fs_cache_t *c, const pop_fs_cache_key_t *key) {
+    if (!c->slots) return NULL;
+    for (uint32_t i = (uint32_t)key->hash & c->mask;; i = (i + 1) & c->mask) {
+        pop_fs_cache_entry_t *e = &c->slots[i];
+        if (pop_fs_cache_match(e, key)) return e;
+        if (e->key == 0) {
+            if ((c->used + 1) * 4 > (c->mask + 1) * 3) return NULL;
+            c->used++;
+            e->key = key->hash;
+            e->check = key->check;
+            e->len = key->len;
+            return e;
+        }
+    }
+}
+
+static inline void pop_fs_cache_add_name(pop_fs_cache_t *c, const pop_fs_cache_key_t *dir_key, const char *name,
+                                         BYTE attr, bool *complete) {
+    char seg[sizeof(((FILINFO *)0)->fname) + 1];
+    const size_t n = strlen(name);
+    if (n + 1 >= sizeof(seg)) return;
+    seg[0] = '/';
+    memcpy(seg + 1, name, n + 1);
+    pop_fs_cache_key_t key = *dir_key;
+    if (!pop_fs_cache_key(seg, n + 1, &key)) return;    // Never matched by a lookup either
+    pop_fs_cache_entry_t *e = pop_fs_cache_insert(c, &key);
+    if (!e) {
+        *complete = false;
+        return;
+    }
+    if (e->kind == POP_FS_CACHE_EMPTY) {
+        e->kind = POP_FS_CACHE_LISTED;
+        e->attr = attr;
+    }
+}
+
+// Lists directory `dir` (`len` bytes of a path, no trailing slash) into the cache.
+static inline void pop_fs_cache_list(pop_fs_cache_t *c, const char *dir, size_t len,
+                                     const pop_fs_cache_key_t *dir_key) {
+    char path[POP_FS_CACHE_MAX_PATH];
+    if (len + 2 > sizeof(path)) return;
+    memcpy(path, dir, len);
+    path[len] = '\0';
+    if (len > 0 && dir[len - 1] == ':') strcat(path, "/");   // Volume root
+
+    DIR d;
+    FRESULT fr = f_opendir(&d, path);
+    if (fr == FR_NO_PATH || fr == FR_NO_FILE || fr == FR_INVALID_NAME) {
+        pop_fs_cache_entry_t *e = pop_fs_cache_insert(c, dir_key);
+        if (e) e->kind = POP_FS_CACHE_NO_DIR;
+        return;
+    }
+    if (fr != FR_OK) return;
+    c->lists++;
+    bool complete = true;
+    FILINFO fno;
+    while ((fr = f_readdir(&d, &fno)) == FR_OK && fno.fname[0] != '\0') {
+        pop_fs_cache_add_name(c, dir_key, fno.fname, fno.fattrib, &complete);
+#if FF_USE_LFN
+        if (fno.altname[0] != '\0') pop_fs_cache_add_name(c, dir_key, fno.altname, fno.fattrib, &complete);
+#endif
+    }
+    f_closedir(&d);
+    if (fr != FR_OK || !complete) return;
+    pop_fs_cache_entry_t *e = pop_fs_cache_insert(c, dir_key);
+    if (e) {
+        e->kind = POP_FS_CACHE_DIR;
+        e->attr |= AM_DIR;
+    }
+}
+
+// Looks `path` ("0:/data/KID.DAT") up, listing its directory on first use. FOUND sets
+// `*out` to the entry (a file or a directory, see attr).
+static inline pop_fs_cache_result_t pop_fs_cache_lookup(pop_fs_cache_t *c, const char *path,
+                                                        pop_fs_cache_entry_t **out) {
+    *out = NULL;
+    if (!c->slots) return POP_FS_CACHE_UNKNOWN;
+    const size_t len = strlen(path);
+    const char *slash = strrchr(path, '/');
+    if (!slash || slash == path + len - 1 || strchr(path, '\\')) return POP_FS_CACHE_UNKNOWN;
+    const size_t dir_len = (size_t)(slash - path);
+
+    pop_fs_cache_key_t dir_key = POP_FS_CACHE_KEY_INIT;
+    if (!pop_fs_cache_key(path, dir_len, &dir_key)) return POP_FS_CACHE_UNKNOWN;
+    pop_fs_cache_key_t key = dir_key;
+    if (!pop_fs_cache_key(slash, len - dir_len, &key)) return POP_FS_CACHE_UNKNOWN;
+
+    pop_fs_cache_entry_t *e = pop_fs_cache_find(c, &key);
+    if (e && e->kind != POP_FS_CACHE_NO_DIR) {
+        *out = e;
+        return POP_FS_CACHE_FOUND;
+    }
+    if (e) return POP_FS_CACHE_MISSING;
+
+    pop_fs_cache_entry_t *d = pop_fs_cache_find(c, &dir_key);
+    if (d && d->kind == POP_FS_CACHE_NO_DIR) return POP_FS_CACHE_MISSING;
+    if (d && d->kind != POP_FS_CACHE_DIR) {
+        if (!(d->attr & AM_DIR)) return POP_FS_CACHE_MISSING;   // A file, not a directory
+    }
+    if (!d || d->kind != POP_FS_CACHE_DIR) {
+        pop_fs_cache_list(c, path, dir_len, &dir_key);
+        d = pop_fs_cache_find(c, &dir_key);
+        if (!d || (d->kind != POP_FS_CACHE_DIR && d->kind != POP_FS_CACHE_NO_DIR)) return POP_FS_CACHE_UNKNOWN;
+        if (d->kind == POP_FS_CACHE_NO_DIR) return POP_FS_CACHE_MISSING;
+        e = pop_fs_cache_find(c, &key);
+        if (e) {
+            *out = e;
+            return POP_FS_CACHE_FOUND;
+        }
+    }
+    return POP_FS_CACHE_MISSING;
+}
+
+// After f_open() of a LISTED file for reading succeeded: remember where the file is.
+static inline void pop_fs_cache_resolve(pop_fs_cache_entry_t *e, const FIL *fil) {
+    e->objsize = fil->obj.objsize;
+    e->sclust = fil->obj.sclust;
+#if FF_FS_EXFAT
+    e->n_cont = fil->obj.n_cont;
+#endif
+    e->stat = fil->obj.stat;
+    e->kind = POP_FS_CACHE_RESOLVED;
+}
+
+// Fills a zeroed `fil` for reading from a RESOLVED entry, in the state f_open() leaves it.
+// Written against f_open() of FatFs R0.15 (FF_DEFINED 80286): it sets obj.fs, obj.id,
+// obj.attr, obj.stat, obj.sclust, obj.objsize, obj.n_cont (exFAT) and flag, and relies on
+// the rest being zero: fptr, clust, sect, err and buf (start of file), cltbl (no fast
+// seek map), obj.n_frag, obj.c_scl / c_size / c_ofs and dir_sect / dir_ptr (only used
+// when writing) and obj.lockid (no lock entry). Re-check them when FatFs is updated.
+#if FF_DEFINED != 80286
+#error "pop_fs_cache_open() builds a FIL by hand for FatFs R0.15: check it against the new f_open()"
+#endif
+static inline void pop_fs_cache_open(const pop_fs_cache_entry_t *e, FATFS *fs, FIL *fil) {
+    fil->obj.fs = fs;
+    fil->obj.id = fs->id;
+    fil->obj.attr = e->attr;
+    fil->obj.stat = e->stat;
+    fil->obj.sclust = e->sclust;
+    fil->obj.objsize = e->objsize;
+#if FF_FS_EXFAT
+    fil->obj.n_cont = e->n_cont;
+#endif
+    fil->flag = FA_READ;
+}
+
+#endif // POP_FS_CACHE_H
@@ -271,8 +271,8 @@ sd_async_stream_t* sd_async_stream_open(const char* path) {
     printf("[SD_ASYNC] Opened: %s (%u bytes)\n", path, (unsigned)s->file_size);
     
     // Allocate buffers from PSRAM
-    s->buffer_a = (uint8_t*)psram_malloc(SD_ASYNC_STREAM_BUFFER_BYTES);
-    s->buffer_b = (uint8_t*)psram_malloc(SD_ASYNC_STREAM_BUFFER_BYTES);
+    s->buffer_a = (uint8_t*)psram_malloc_cat(SD_ASYNC_STREAM_BUFFER_BYTES, MEM_CAT_SOUND);
+    s->buffer_b = (uint8_t*)psram_malloc_cat(SD_ASYNC_STREAM_BUFFER_BYTES, MEM_CAT_SOUND);
     
     if (!s->buffer_a || !s->buffer_b) {
         printf("[SD_ASYNC] Failed to allocate buffers\n");
@@ -50,7 +50,7 @@ SDL_Surface *IMG_Load_RW(SDL_RWops *src, int freesrc) {
     }
 
     const size_t size = (size_t)size64;
-    unsigned char *png = (unsigned char *)psram_malloc(size);
+    unsigned char *png = (unsigned char *)psram_malloc_cat(size, MEM_CAT_FILEBUF);
     if (!png) {
         g_img_error = "IMG_Load_RW: OOM";
         if (freesrc) SDL_RWclose(src);
@@ -0,0 +1,153 @@
+#ifndef SPRITE_PACK_H
+#define SPRITE_PACK_H
+
+// Prepacked sprite archive (data/SPRITES.PAK): the PNGs of the data directories already
+// converted to 8bpp palette indices the way load_image() converts them, so a sprite is
+// one read and a run-length expansion into its surface instead of a PNG decode to RGBA
+// followed by a nearest-colour match per pixel.
+//
+// Layout (little-endian):
+//   sprite_pack_header_t
+//   sprite_pack_entry_t[count]     sorted by (dir, id, pal_hash)
+//   padding up to data_offset      sector-aligned
+//   pixel data                     per entry, `size` bytes at `offset`
+//
+// Pixel data is width * height indices, rows unpadded, either raw (SPRITE_PACK_RAW) or
+// PackBits-style RLE: a control byte c < 128 is followed by c + 1 literal bytes, c >= 128
+// by one byte repeated c - 126 times. Sprites are mostly transparent runs, so this keeps
+// the archive about the size of the PNGs it replaces.
+//
+// The indices depend on the palette an image is loaded with, so every entry records a
+// hash of its palette. A PNG used with several palettes (the guard sprites) gets one
+// entry per palette; a palette the packer never saw misses and the PNG is loaded.
+//
+// Plain C, no Pico SDK: tools/sprite_pack.c writes the archive.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define SPRITE_PACK_PATH "data/SPRITES.PAK"
+#define SPRITE_PACK_MAGIC "SPK8"
+#define SPRITE_PACK_VERSION 1
+#define SPRITE_PACK_DIR_LEN 12      // DAT name without ".DAT", upper case, NUL-padded
+#define SPRITE_PACK_ALIGN 512
+
+#define SPRITE_PACK_FONT 0x01       // Converted with the monochrome font rule
+#define SPRITE_PACK_RAW 0x02        // Stored without RLE
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t entry_size;            // sizeof(sprite_pack_entry_t)
+    uint32_t count;
+    uint32_t data_offset;
+    uint8_t unpremultiply;          // RP_SDL_STBI_UNPREMULTIPLY_ALPHA_MODE used
+    uint8_t reserved[15];
+} sprite_pack_header_t;
+
+typedef struct {
+    char dir[SPRITE_PACK_DIR_LEN];
+    uint16_t id;
+    uint16_t width;
+    uint16_t height;
+    uint8_t flags;
+    uint8_t reserved;
+    uint32_t pal_hash;              // sprite_pack_pal_hash() of the palette used
+    uint32_t offset;                // Pixel data, from the start of the file
+    uint32_t size;                  // Pixel data bytes
+} sprite_pack_entry_t;
+
+_Static_assert(sizeof(sprite_pack_header_t) == 32, "sprite_pack_header_t layout");
+_Static_assert(sizeof(sprite_pack_entry_t) == 32, "sprite_pack_entry_t layout");
+
+// `vga` is the 16 6-bit RGB triplets of dat_pal_type; fonts (n_colors == 0) ignore it.
+static inline uint32_t sprite_pack_pal_hash(const uint8_t vga[48], bool font) {
+    uint32_t h = 2166136261u;       // FNV-1a
+    if (font) return h ^ 0x464F4E54u;
+    for (int i = 0; i < 48; ++i) {
+        h ^= vga[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Upper-cases `name` into a NUL-padded key; false if it does not fit.
+static inline bool sprite_pack_dir_key(char key[SPRITE_PACK_DIR_LEN], const char *name) {
+    memset(key, 0, SPRITE_PACK_DIR_LEN);
+    for (int i = 0; name[i] != '\0'; ++i) {
+        if (i >= SPRITE_PACK_DIR_LEN - 1) return false;
+        const char c = name[i];
+        key[i] = (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+    }
+    return true;
+}
+
+static inline int sprite_pack_compare(const char *dir_a, uint16_t id_a, const char *dir_b, uint16_t id_b) {
+    const int d = memcmp(dir_a, dir_b, SPRITE_PACK_DIR_LEN);
+    if (d != 0) return d;
+    return (int)id_a - (int)id_b;
+}
+
+static inline bool sprite_pack_header_valid(const sprite_pack_header_t *h, uint32_t file_size) {
+    if (memcmp(h->magic, SPRITE_PACK_MAGIC, 4) != 0) return false;
+    if (h->version != SPRITE_PACK_VERSION || h->entry_size != sizeof(sprite_pack_entry_t)) return false;
+    const uint64_t index_end = sizeof(*h) + (uint64_t)h->count * sizeof(sprite_pack_entry_t);
+    return h->data_offset >= index_end && h->data_offset <= file_size;
+}
+
+// Index of the first entry for (dir, id), or -1. Binary search over the sorted index.
+static inline int sprite_pack_find(const sprite_pack_entry_t *index, uint32_t count, const char dir[SPRITE_PACK_DIR_LEN],
+                                   uint16_t id) {
+    uint32_t lo = 0, hi = count;
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        if (sprite_pack_compare(index[mid].dir, index[mid].id, dir, id) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < count && sprite_pack_compare(index[lo].dir, index[lo].id, dir, id) == 0) return (int)lo;
+    return -1;
+}
+
+// The entry for (dir, id) converted with `pal_hash`, starting from sprite_pack_find().
+static inline const sprite_pack_entry_t *sprite_pack_match(const sprite_pack_entry_t *index, uint32_t count, int first,
+                                                           uint32_t pal_hash) {
+    for (uint32_t i = (uint32_t)first; i < count; ++i) {
+        if (sprite_pack_compare(index[i].dir, index[i].id, index[first].dir, index[first].id) != 0) break;
+        if (index[i].pal_hash == pal_hash) return &index[i];
+    }
+    return NULL;
+}
+
+// Expands `src` (an entry's pixel data) into exactly `dst_len` bytes; false if the data
+// is malformed.
+static inline bool sprite_pack_unpack(uint8_t *dst, uint32_t dst_len, const uint8_t *src, uint32_t src_len,
+                                      uint8_t flags) {
+    if (flags & SPRITE_PACK_RAW) {
+        if (src_len != dst_len) return false;
+        memcpy(dst, src, dst_len);
+        return true;
+    }
+    uint32_t out = 0, in = 0;
+    while (in < src_len) {
+        const uint8_t c = src[in++];
+        if (c < 128) {
+            const uint32_t n = (uint32_t)c + 1;
+            if (in + n > src_len || out + n > dst_len) return false;
+            memcpy(dst + out, src + in, n);
+            in += n;
+            out += n;
+        } else {
+            const uint32_t n = (uint32_t)c - 126;
+            if (in >= src_len || out + n > dst_len) return false;
+            memset(dst + out, src[in++], n);
+            out += n;
+        }
+    }
+    return out == dst_len;
+}
+
+#endif // SPRITE_PACK_H
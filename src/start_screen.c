@@ -8,6 +8,7 @@
 #include "board_config.h"
 #include "HDMI.h"
 #include "pop_fs.h"
+#include "psram_allocator.h"
 #include "ps2kbd/ps2kbd_wrapper.h"
 #include "hardware/clocks.h"
 #include "pico/stdlib.h"
@@ -16,6 +17,7 @@
 #include <string.h>
 
 #include "ff.h"  // Direct FatFS access
+#include "sdcard.h" // Negotiated SD clock / error counters
 
 #ifdef USB_HID_ENABLED
 #include "usbhid/usbhid_sdl_wrapper.h"
@@ -29,7 +31,13 @@
 extern uint8_t *graphics_buffer;
 
 // Local back buffer to avoid flicker (draw here, then copy to graphics_buffer)
+#if RP2350_ZERO_COPY_SCANOUT
+// Zero-copy builds have no other user of a 320x240 SRAM copy, so draw in PSRAM
+// scratch (free while the start screen runs) and keep only graphics_buffer in SRAM.
+static uint8_t *back_buffer = NULL;
+#else
 static uint8_t back_buffer[SCREEN_W * SCREEN_H];
+#endif
 
 // Version from build system
 #ifndef MURMPRINCE_VERSION
@@ -430,6 +438,10 @@ start_error_t start_screen_check_requirements(void) {
 }
 
 void start_screen_show(start_error_t error, const char* error_msg) {
+#if RP2350_ZERO_COPY_SCANOUT
+    back_buffer = (uint8_t *)psram_get_scratch_1(SCREEN_W * SCREEN_H);
+#endif
+
     // Setup palette (same as murmdoom)
     graphics_set_palette(0, 0x000000);  // Black background
     graphics_set_palette(1, 0xFFFFFF);  // White text
@@ -517,6 +529,19 @@ void start_screen_show(start_error_t error, const char* error_msg) {
              (unsigned long)psram_cs);
     
     const char *status3 = "github.com/rh1tech/murmprince";
+
+    // SD bus clock picked by the driver and its error counters so far
+    char sd_clock[64];
+    char sd_errors[64];
+    {
+        sd_clock_info_t sd;
+        disk_get_clock_info(&sd);
+        const uint32_t khz = (sd.clk_hz + 50000) / 1000;
+        snprintf(sd_clock, sizeof(sd_clock), "SD clock: %lu.%lu MHz%s", (unsigned long)(khz / 1000),
+                 (unsigned long)((khz % 1000) / 100), sd.high_speed ? " (high speed)" : "");
+        snprintf(sd_errors, sizeof(sd_errors), "CRC errors: %lu, read errors: %lu, fallbacks: %lu",
+                 (unsigned long)sd.crc_errors, (unsigned long)sd.read_errors, (unsigned long)sd.fallbacks);
+    }
     
     // Error messages
     const char *err_line = NULL;
@@ -570,6 +595,10 @@ void start_screen_show(start_error_t error, const char* error_msg) {
             const char *ok_msg = "SD card OK";
             int ok_w = text_width_5x7(ok_msg);
             draw_text_5x7((SCREEN_W - ok_w) / 2, panel_y + 60, ok_msg, 1);
+            int sd_clock_w = text_width_5x7(sd_clock);
+            draw_text_5x7((SCREEN_W - sd_clock_w) / 2, panel_y + 74, sd_clock, 1);
+            int sd_errors_w = text_width_5x7(sd_errors);
+            draw_text_5x7((SCREEN_W - sd_errors_w) / 2, panel_y + 84, sd_errors, 1);
         }
 
         // Status lines at bottom (centered)
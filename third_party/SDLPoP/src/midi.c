@@ -708,7 +708,13 @@ void init_midi() {
 	instruments = &hardcoded_instrument; // unused if instruments can be loaded normally.
 	int size;
 	dat_type* dathandle = open_dat("PRINCE.DAT", 0);
+#ifdef POP_RP2350
+	const mem_cat_t prev_cat = psram_set_category(MEM_CAT_SOUND);
+	instruments_data = load_from_opendats_alloc(1, "bin", NULL, &size);
+	psram_set_category(prev_cat);
+#else
 	instruments_data = load_from_opendats_alloc(1, "bin", NULL, &size);
+#endif
 	if (!instruments_data) {
 		printf("Missing MIDI instruments data (resource 1)\n");
 	} else {
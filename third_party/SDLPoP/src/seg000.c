@@ -26,6 +26,15 @@ The authors of this program may be contacted at https://forum.princed.org
 #include "psram_allocator.h"
 #include "pico/stdlib.h"  // for sleep_ms
 extern uint32_t graphics_get_hdmi_irq_count(void);
+
+// Soft limit for the sprites of one level; exceeding it only logs and counts.
+#ifndef POP_LEVEL_ARENA_BUDGET
+#define POP_LEVEL_ARENA_BUDGET (3 * 1024 * 1024)
+#endif
+// PSRAM arenas for surfaces: game-lifetime sprites, and the current level's sprites
+// (reset when the next level is loaded).
+static int pop_arena_game = -1;
+static int pop_arena_level = -1;
 #endif
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -179,10 +188,17 @@ byte* level_var_palettes;
 // seg000:024F
 void init_game_main() {
 	DBG_PRINTF("[init_game_main] enter\n");
+	#ifdef POP_RP2350
+	pop_arena_game = psram_arena_create("game", 0);
+	psram_arena_push(pop_arena_game);
+	#endif
 	doorlink1_ad = /*&*/level.doorlinks1;
 	doorlink2_ad = /*&*/level.doorlinks2;
 	prandom(1);
 	if (graphics_mode == gmMcgaVga) {
+		#ifdef POP_RP2350
+		const mem_cat_t prev_cat = psram_set_category(MEM_CAT_LEVEL);
+		#endif
 		// Guard palettes
 		guard_palettes = (byte*) load_from_opendats_alloc(10, "bin", NULL, NULL);
 		// (blood, hurt flash) #E00030 = red
@@ -192,6 +208,9 @@ void init_game_main() {
 
 		// Level color variations (1.3)
 		level_var_palettes = load_from_opendats_alloc(20, "bin", NULL, NULL);
+		#ifdef POP_RP2350
+		psram_set_category(prev_cat);
+		#endif
 	}
 	// PRINCE.DAT: sword
 	DBG_PRINTF("[init_game_main] load sword chtab\n");
@@ -208,8 +227,7 @@ void init_game_main() {
 	hof_read();
 	show_splash(); // added
 	#ifdef POP_RP2350
-	// Mark PSRAM session after initial load - this allows restore on restart
-	psram_mark_session();
+	psram_arena_pop(pop_arena_game);
 	#endif
 	start_game();
 }
@@ -234,8 +252,10 @@ void start_game() {
 		setjmp(/*&*/setjmp_buf);
 	} else {
 		#ifdef POP_RP2350
-		// Restore PSRAM to session mark to reclaim memory from freed chtabs
-		psram_restore_session();
+		// Free the level's sprites now rather than after the quotes screen. The chtab
+		// pointers are cleared here, so the free_optsnd_chtab() below is a no-op.
+		free_optsnd_chtab();
+		psram_arena_reset(pop_arena_level);
 		// Give HDMI DMA time to stabilize after PSRAM memory operation
 		sleep_ms(5);
 		#endif
@@ -1154,6 +1174,12 @@ void load_lev_spr(int level) {
 	current_level = next_level = level;
 	draw_rect(&screen_rect, color_0_black);
 	free_optsnd_chtab();
+#ifdef POP_RP2350
+	// Anything of the previous level that was not freed with its chtab goes here.
+	if (pop_arena_level < 0) pop_arena_level = psram_arena_create("level", POP_LEVEL_ARENA_BUDGET);
+	psram_arena_reset(pop_arena_level);
+	psram_arena_push(pop_arena_level);
+#endif
 	snprintf(filename, sizeof(filename), "%s%s.DAT",
 		tbl_envir_gr[graphics_mode],
 		tbl_envir_ki[custom->tbl_level_type[current_level]]
@@ -1199,6 +1225,7 @@ void load_lev_spr(int level) {
 		load_opt_sounds(48, 49); // something spiked, spikes
 	}
 #ifdef POP_RP2350
+	psram_arena_pop(pop_arena_level);
 	// Disable HDMI loading mode after heavy file I/O is complete
 	graphics_set_loading_mode(false);
 #endif
@@ -1004,6 +1004,7 @@ SDL_Surface* hflip(SDL_Surface* input) {
 	}
 	
 	// Direct pixel flip - much faster than per-column blits
+	SDL_FenceSurfaces();
 	uint8_t* src_pixels = (uint8_t*)input->pixels;
 	uint8_t* dst_pixels = (uint8_t*)output->pixels;
 	int src_pitch = input->pitch;
@@ -34,6 +34,8 @@ int pop_quit_requested = 0;
 #ifdef POP_RP2350
 #include "pop_fs.h"
 #include "ff.h"
+#include "rp_sdl_config.h"
+#include "sprite_pack.h"
 #endif
 
 #ifdef _WIN32
@@ -58,8 +60,8 @@ static inline int pop_close(pop_file_t* fp) { return pop_fs_close(fp); }
 static inline long pop_size(pop_file_t* fp) { return (long)f_size(fp); }
 
 #define IS_PSRAM(ptr) ((uintptr_t)(ptr) >= 0x11000000 && (uintptr_t)(ptr) < 0x12000000)
-static inline void* pop_heap_alloc(size_t size) {
-	void* p = psram_malloc(size);
+static inline void* pop_heap_alloc(size_t size, mem_cat_t cat) {
+	void* p = psram_malloc_cat(size, cat);
 	if (!p) {
 		printf("pop_heap_alloc: OOM (psram_malloc failed) size=%d\n", (int)size);
 		fflush(stdout);
@@ -656,7 +658,21 @@ void set_loaded_palette(dat_pal_type* palette_ptr) {
 word chtab_palette_bits = 1;
 
 // seg009:104E
+#ifdef POP_RP2350
+static chtab_type* load_sprites_from_file_body(int resource,int palette_bits, int quit_on_error);
+
+// Everything a sprite table loads (palette, file contents, surfaces) counts as chtab memory.
+chtab_type* load_sprites_from_file(int resource,int palette_bits, int quit_on_error) {
+	const mem_cat_t prev_cat = psram_set_category(MEM_CAT_CHTAB);
+	chtab_type* chtab = load_sprites_from_file_body(resource, palette_bits, quit_on_error);
+	psram_set_category(prev_cat);
+	return chtab;
+}
+
+static chtab_type* load_sprites_from_file_body(int resource,int palette_bits, int quit_on_error) {
+#else
 chtab_type* load_sprites_from_file(int resource,int palette_bits, int quit_on_error) {
+#endif
 	//int has_palette_bits = 1;
 	dat_shpl_type* shpl = (dat_shpl_type*) load_from_opendats_alloc(resource, "pal", NULL, NULL);
 	if (shpl == NULL) {
@@ -691,7 +707,7 @@ chtab_type* load_sprites_from_file(int resource,int palette_bits, int quit_on_er
 	int n_images = shpl->n_images;
 	size_t alloc_size = sizeof(chtab_type) + sizeof(void *) * n_images;
 	#ifdef POP_RP2350
-	chtab_type* chtab = (chtab_type*) psram_malloc(alloc_size);
+	chtab_type* chtab = (chtab_type*) psram_malloc_cat(alloc_size, MEM_CAT_CHTAB);
 	#else
 	chtab_type* chtab = (chtab_type*) malloc(alloc_size);
 	#endif
@@ -1078,10 +1094,137 @@ static const char* get_sprite_name(int res_id) {
 	return "?";
 }
 
+#ifdef POP_RP2350
+// Palette of a directory image converted to 8bpp, shared by the PNG and sprite pack paths.
+static void set_indexed_image_palette(SDL_Surface* image, const dat_pal_type* palette) {
+	SDL_Color colors[16];
+	if (palette->n_colors == 0) {
+		// Font images: monochrome, index 0 = transparent black, index 1 = white
+		// The actual color is applied at render time by method_3_blit_mono
+		colors[0].r = 0;   colors[0].g = 0;   colors[0].b = 0;   colors[0].a = SDL_ALPHA_TRANSPARENT;
+		colors[1].r = 255; colors[1].g = 255; colors[1].b = 255; colors[1].a = SDL_ALPHA_OPAQUE;
+		for (int i = 2; i < 16; ++i) {
+			colors[i] = colors[1]; // Fill rest with white
+		}
+	} else {
+		// Normal sprites: use DAT palette
+		for (int i = 0; i < 16; ++i) {
+			colors[i].r = palette->vga[i].r << 2;
+			colors[i].g = palette->vga[i].g << 2;
+			colors[i].b = palette->vga[i].b << 2;
+			colors[i].a = (i == 0) ? SDL_ALPHA_TRANSPARENT : SDL_ALPHA_OPAQUE;
+		}
+	}
+	SDL_SetPaletteColors(image->format->palette, colors, 0, 16);
+}
+
+// data/SPRITES.PAK (sprite_pack.h, built by tools/sprite_pack.c): the directory PNGs
+// already converted to 8bpp. Opened on first use and kept open like a DAT file.
+static FIL* sprite_pack_fp = NULL;
+static sprite_pack_entry_t* sprite_pack_index = NULL;
+static uint32_t sprite_pack_count = 0;
+static bool sprite_pack_tried = false;
+
+static void sprite_pack_open(void) {
+	sprite_pack_tried = true;
+	FIL* fp = pop_fs_open(SPRITE_PACK_PATH, "rb");
+	if (fp == NULL) return;
+	sprite_pack_header_t header;
+	if (pop_fs_read(&header, sizeof(header), 1, fp) != 1 ||
+	    !sprite_pack_header_valid(&header, (uint32_t)f_size(fp))) {
+		printf("%s: not a sprite pack, using PNGs\n", SPRITE_PACK_PATH);
+		pop_fs_close(fp);
+		return;
+	}
+	if (header.unpremultiply != RP_SDL_STBI_UNPREMULTIPLY_ALPHA_MODE) {
+		printf("%s: packed with unpremultiply mode %d (build uses %d), using PNGs\n",
+			SPRITE_PACK_PATH, header.unpremultiply, RP_SDL_STBI_UNPREMULTIPLY_ALPHA_MODE);
+		pop_fs_close(fp);
+		return;
+	}
+	size_t index_size = (size_t)header.count * sizeof(sprite_pack_entry_t);
+	sprite_pack_entry_t* index = (sprite_pack_entry_t*) psram_malloc_cat(index_size, MEM_CAT_OTHER);
+	if (index == NULL || (index_size > 0 && pop_fs_read(index, index_size, 1, fp) != 1)) {
+		printf("%s: cannot read the index, using PNGs\n", SPRITE_PACK_PATH);
+		if (index) psram_free(index);
+		pop_fs_close(fp);
+		return;
+	}
+	sprite_pack_fp = fp;
+	sprite_pack_index = index;
+	sprite_pack_count = header.count;
+	printf("%s: %u images\n", SPRITE_PACK_PATH, (unsigned)header.count);
+}
+
+static image_type* sprite_pack_read(const sprite_pack_entry_t* entry, const dat_pal_type* palette) {
+	if (entry->offset > f_size(sprite_pack_fp) || entry->size > f_size(sprite_pack_fp) - entry->offset) return NULL;
+	SDL_Surface* image = SDL_CreateRGBSurface(0, entry->width, entry->height, 8, 0, 0, 0, 0);
+	if (image == NULL) return NULL;
+	uint8_t* data = (uint8_t*) psram_get_file_buffer(entry->size);
+	if (image->pitch != image->w || data == NULL ||
+	    pop_fs_seek(sprite_pack_fp, (long)entry->offset, SEEK_SET) ||
+	    (entry->size > 0 && pop_fs_read(data, entry->size, 1, sprite_pack_fp) != 1) ||
+	    !sprite_pack_unpack((uint8_t*)image->pixels, (uint32_t)entry->width * entry->height, data, entry->size, entry->flags)) {
+		printf("%s: cannot load %.12s/res%u, using the PNG\n", SPRITE_PACK_PATH, entry->dir, entry->id);
+		SDL_FreeSurface(image);
+		return NULL;
+	}
+	set_indexed_image_palette(image, palette);
+	return image;
+}
+
+// Finds the image where load_from_opendats_metadata() would find it: a DAT that has the
+// resource wins, otherwise the pack stands in for each DAT's directory in chain order.
+// NULL sends load_image() down the PNG path: no pack, mods active (their files override
+// data/), or the pack was made for other palettes only.
+static image_type* load_from_opendats_packed(int resource_id, const dat_pal_type* palette) {
+	if (!sprite_pack_tried) sprite_pack_open();
+	if (sprite_pack_index == NULL || palette == NULL || use_custom_levelset) return NULL;
+	const bool is_font = (palette->n_colors == 0);
+	const uint32_t pal_hash = sprite_pack_pal_hash((const uint8_t*)palette->vga, is_font);
+	for (dat_type* pointer = dat_chain_ptr; pointer != NULL; pointer = pointer->next_dat) {
+		if (pointer->handle != NULL) {
+			dat_table_type* dat_table = pointer->dat_table;
+			for (int i = 0; i < SDL_SwapLE16(dat_table->res_count); ++i) {
+				// Empty images in DATs fall back to directories, as in load_from_opendats_metadata().
+				if (SDL_SwapLE16(dat_table->entries[i].id) == resource_id &&
+				    SDL_SwapLE16(dat_table->entries[i].size) > 2) {
+					return NULL;
+				}
+			}
+		}
+		char filename_no_ext[POP_MAX_PATH];
+		snprintf_check(filename_no_ext, sizeof(filename_no_ext), "%s", pointer->filename);
+		size_t len = strlen(filename_no_ext);
+		if (len >= 5 && filename_no_ext[len-4] == '.') {
+			filename_no_ext[len-4] = '\0';
+		}
+		char dir[SPRITE_PACK_DIR_LEN];
+		if (!sprite_pack_dir_key(dir, filename_no_ext)) continue;
+		int first = sprite_pack_find(sprite_pack_index, sprite_pack_count, dir, (uint16_t)resource_id);
+		if (first < 0) continue; // No such PNG in this directory when the pack was built
+		const sprite_pack_entry_t* entry = sprite_pack_match(sprite_pack_index, sprite_pack_count, first, pal_hash);
+		if (entry == NULL) return NULL;
+		DBG_PRINTF("[load_image] res=%d from %s (%.12s)\n", resource_id, SPRITE_PACK_PATH, entry->dir);
+		return sprite_pack_read(entry, palette);
+	}
+	return NULL;
+}
+#endif
+
 image_type* load_image(int resource_id, dat_pal_type* palette) {
 	// stub
 	DBG_PRINTF("[load_image] res=%d (%s)\n", resource_id, get_sprite_name(resource_id));
 	
+#ifdef POP_RP2350
+	image_type* packed = load_from_opendats_packed(resource_id, palette);
+	if (packed != NULL) {
+		SDL_SetColorKey(packed, SDL_TRUE, 0);
+		SDL_SurfaceBuildSpans(packed);
+		return packed;
+	}
+#endif
+
 	data_location result;
 	int size;
 	void* image_data = load_from_opendats_alloc(resource_id, "png", &result, &size);
@@ -1125,27 +1268,8 @@ image_type* load_image(int resource_id, dat_pal_type* palette) {
 				SDL_Surface* indexed = SDL_CreateRGBSurface(0, w, h, 8, 0, 0, 0, 0);
 				if (indexed != NULL) {
 					// Set palette from DAT palette
-					SDL_Color colors[16];
 					int is_font = (palette->n_colors == 0);
-					
-					if (is_font) {
-						// Font images: monochrome, index 0 = transparent black, index 1 = white
-						// The actual color is applied at render time by method_3_blit_mono
-						colors[0].r = 0;   colors[0].g = 0;   colors[0].b = 0;   colors[0].a = SDL_ALPHA_TRANSPARENT;
-						colors[1].r = 255; colors[1].g = 255; colors[1].b = 255; colors[1].a = SDL_ALPHA_OPAQUE;
-						for (int i = 2; i < 16; ++i) {
-							colors[i] = colors[1]; // Fill rest with white
-						}
-					} else {
-						// Normal sprites: use DAT palette
-						for (int i = 0; i < 16; ++i) {
-							colors[i].r = palette->vga[i].r << 2;
-							colors[i].g = palette->vga[i].g << 2;
-							colors[i].b = palette->vga[i].b << 2;
-							colors[i].a = (i == 0) ? SDL_ALPHA_TRANSPARENT : SDL_ALPHA_OPAQUE;
-						}
-					}
-					SDL_SetPaletteColors(indexed->format->palette, colors, 0, 16);
+					set_indexed_image_palette(indexed, palette);
 					
 					// Convert each pixel: find closest palette match or use alpha for transparency
 					uint32_t* src = (uint32_t*)image->pixels;
@@ -1183,20 +1307,8 @@ image_type* load_image(int resource_id, dat_pal_type* palette) {
 								int brightness = (int)r + (int)g + (int)b;
 								dst[y * dst_pitch + x] = (brightness > 384) ? 1 : 0; // threshold ~50% gray
 							} else {
-								// Find closest palette color (simple brute force)
-								int best_idx = 1; // Skip 0 (transparent)
-								int best_dist = 999999;
-								for (int i = 1; i < 16; ++i) {
-									int dr = (int)colors[i].r - (int)r;
-									int dg = (int)colors[i].g - (int)g;
-									int db = (int)colors[i].b - (int)b;
-									int dist = dr*dr + dg*dg + db*db;
-									if (dist < best_dist) {
-										best_dist = dist;
-										best_idx = i;
-									}
-								}
-								dst[y * dst_pitch + x] = (uint8_t)best_idx;
+								// Closest palette color, skipping 0 (transparent)
+								dst[y * dst_pitch + x] = SDL_PaletteNearestIndex(indexed->format->palette, 1, 15, r, g, b);
 							}
 						}
 					}
@@ -1242,6 +1354,10 @@ image_type* load_image(int resource_id, dat_pal_type* palette) {
 		if (SDL_SetColorKey(image, SDL_TRUE, 0) != 0) {
 			// Ignore errors - not all surfaces support colorkey
 		}
+		#ifdef POP_RP2350
+		// Pixels are final here: precompute opaque runs so blits skip transparent pixels.
+		SDL_SurfaceBuildSpans(image);
+		#endif
 /*
 		if (SDL_SetSurfaceAlphaMod(image, 0) != 0) { //sdl 1.2: SDL_SetAlpha removed
 			sdlperror("load_image: SDL_SetAlpha");
@@ -1334,7 +1450,100 @@ void free_surface(surface_type* surface) {
 }
 
 // seg009:17EA
+#ifdef POP_RP2350
+// Peel pool: peels live for about one frame (read before sprites are drawn, restored
+// LIFO by restore_peels() on the next one), so they are bump-allocated from a fixed
+// SRAM pool with preallocated peel/surface headers instead of malloc'ing a peel, a
+// surface, a pixel format and pixels each time. Freeing the most recent peel pops the
+// pool; once every peel is gone it is empty again. Long-lived peels (dialogs) only pin
+// what is below them. Peels that do not fit fall back to the heap.
+#ifndef RP2350_PEEL_POOL_BYTES
+#define RP2350_PEEL_POOL_BYTES (24 * 1024)
+#endif
+#define RP2350_PEEL_POOL_SLOTS 64
+
+typedef struct {
+	peel_type peel;
+	SDL_Surface surface;
+	SDL_PixelFormat format;
+	uint32_t offset;
+	bool live;
+} rp2350_peel_slot_t;
+
+static rp2350_peel_slot_t rp2350_peel_slots[RP2350_PEEL_POOL_SLOTS];
+static uint8_t rp2350_peel_free_list[RP2350_PEEL_POOL_SLOTS];
+static int rp2350_peel_free_count = -1;  // -1: not initialised
+static uint8_t rp2350_peel_stack[RP2350_PEEL_POOL_SLOTS];  // Slots in allocation order
+static int rp2350_peel_stack_top = 0;
+static uint32_t rp2350_peel_pixels_words[RP2350_PEEL_POOL_BYTES / 4];
+static uint32_t rp2350_peel_used = 0;
+static uint32_t rp2350_peel_high_water = 0;
+static uint32_t rp2350_peel_fallbacks = 0;
+
+static peel_type* rp2350_peel_alloc(int w, int h) {
+	if (rp2350_peel_free_count < 0) {
+		for (int i = 0; i < RP2350_PEEL_POOL_SLOTS; ++i) rp2350_peel_free_list[i] = (uint8_t)(RP2350_PEEL_POOL_SLOTS - 1 - i);
+		rp2350_peel_free_count = RP2350_PEEL_POOL_SLOTS;
+	}
+	const uint32_t size = ((uint32_t)w * (uint32_t)h + 3u) & ~3u;
+	if (rp2350_peel_free_count == 0 || rp2350_peel_used + size > RP2350_PEEL_POOL_BYTES) {
+		if (rp2350_peel_fallbacks++ < 8) {
+			DBG_PRINTF("[peel pool] %dx%d does not fit (used %lu, high water %lu), using heap\n", w, h,
+				(unsigned long)rp2350_peel_used, (unsigned long)rp2350_peel_high_water);
+		}
+		return NULL;
+	}
+	rp2350_peel_slot_t* slot = &rp2350_peel_slots[rp2350_peel_free_list[--rp2350_peel_free_count]];
+	rp2350_peel_stack[rp2350_peel_stack_top++] = (uint8_t)(slot - rp2350_peel_slots);
+	slot->offset = rp2350_peel_used;
+	slot->live = true;
+	rp2350_peel_used += size;
+	if (rp2350_peel_used > rp2350_peel_high_water) rp2350_peel_high_water = rp2350_peel_used;
+
+	memset(&slot->format, 0, sizeof(slot->format));
+	slot->format.format = SDL_PIXELFORMAT_INDEX8;
+	slot->format.BitsPerPixel = 8;
+	slot->format.BytesPerPixel = 1;
+	slot->format.palette = current_target_surface->format->palette;  // Borrowed, not ref-counted
+	memset(&slot->surface, 0, sizeof(slot->surface));
+	slot->surface.format = &slot->format;
+	slot->surface.w = w;
+	slot->surface.h = h;
+	slot->surface.pitch = w;
+	slot->surface.pixels = (uint8_t*)rp2350_peel_pixels_words + slot->offset;
+	slot->surface.refcount = 1;
+	slot->surface.clip_rect = (SDL_Rect){0, 0, w, h};
+	slot->surface.cache_slot = -1;
+	slot->surface.arena = -1;  // Not in a PSRAM arena
+	memset(&slot->peel, 0, sizeof(slot->peel));
+	slot->peel.peel = &slot->surface;
+	return &slot->peel;
+}
+
+static bool rp2350_peel_release(peel_type* peel_ptr) {
+	if ((void*)peel_ptr < (void*)rp2350_peel_slots || (void*)peel_ptr >= (void*)(rp2350_peel_slots + RP2350_PEEL_POOL_SLOTS)) {
+		return false;
+	}
+	rp2350_peel_slot_t* slot = (rp2350_peel_slot_t*)peel_ptr;  // peel is the first member
+	// A queued DMA restore may still be reading these pixels.
+	SDL_FenceSurfaces();
+	slot->live = false;
+	// Pop every dead slot on top of the stack; their pixels become free again.
+	while (rp2350_peel_stack_top > 0 && !rp2350_peel_slots[rp2350_peel_stack[rp2350_peel_stack_top - 1]].live) {
+		const uint8_t top = rp2350_peel_stack[--rp2350_peel_stack_top];
+		rp2350_peel_used = rp2350_peel_slots[top].offset;
+		rp2350_peel_free_list[rp2350_peel_free_count++] = top;
+	}
+	if (rp2350_peel_stack_top == 0) rp2350_peel_used = 0;
+	return true;
+}
+
+#endif
+
 void free_peel(peel_type* peel_ptr) {
+#ifdef POP_RP2350
+	if (rp2350_peel_release(peel_ptr)) return;
+#endif
 	SDL_FreeSurface(peel_ptr->peel);
 	free(peel_ptr);
 }
@@ -2212,11 +2421,11 @@ void restore_peel(peel_type* peel_ptr) {
 	int src_pitch = peel->pitch;
 	int dst_pitch = current_target_surface->pitch;
 	
-	for (int y = 0; y < peel_h; ++y) {
-		memcpy(dst_pixels + (dst_y + y) * dst_pitch + dst_x,
-		       src_pixels + y * src_pitch,
-		       peel_w);
-	}
+	// Large restores (room transitions) go to DMA; free_peel() below fences before the
+	// peel's pixels are released.
+	SDL_CopyRect8(dst_pixels + dst_y * dst_pitch + dst_x, dst_pitch, src_pixels, src_pitch, peel_w, peel_h);
+	SDL_Rect dirty_rect = {dst_x, dst_y, peel_w, peel_h};
+	SDL_AddDirtyRect(current_target_surface, &dirty_rect);
 #else
 	method_6_blit_img_to_scr(peel_ptr->peel, peel_ptr->rect.left, peel_ptr->rect.top, /*0x10*/0);
 #endif
@@ -2227,6 +2436,25 @@ void restore_peel(peel_type* peel_ptr) {
 // seg009:3BE9
 peel_type* read_peel_from_screen(const rect_type* rect) {
 #ifdef POP_RP2350
+	{
+		// Pooled peel (see rp2350_peel_alloc); same clipping as the heap path below.
+		const int left = MAX(rect->left, 0);
+		const int top = MAX(rect->top, 0);
+		const int right = MIN(rect->right, current_target_surface->w);
+		const int bottom = MIN(rect->bottom, current_target_surface->h);
+		peel_type* pooled = (right > left && bottom > top) ? rp2350_peel_alloc(right - left, bottom - top) : NULL;
+		if (pooled) {
+			pooled->rect.left = left;
+			pooled->rect.top = top;
+			pooled->rect.right = right;
+			pooled->rect.bottom = bottom;
+			SDL_Surface* s = pooled->peel;
+			SDL_CopyRect8((uint8_t*)s->pixels, s->pitch,
+			              (const uint8_t*)current_target_surface->pixels + top * current_target_surface->pitch + left,
+			              current_target_surface->pitch, s->w, s->h);
+			return pooled;
+		}
+	}
 	// Use SRAM mode so peels can be properly freed later
 	psram_set_sram_mode(1);
 #endif
@@ -2288,11 +2516,7 @@ peel_type* read_peel_from_screen(const rect_type* rect) {
 	int src_pitch = current_target_surface->pitch;
 	int dst_pitch = peel_surface->pitch;
 	
-	for (int y = 0; y < peel_h; ++y) {
-		memcpy(dst_pixels + y * dst_pitch,
-		       src_pixels + (clip_top + y) * src_pitch + clip_left,
-		       peel_w);
-	}
+	SDL_CopyRect8(dst_pixels, dst_pitch, src_pixels + clip_top * src_pitch + clip_left, src_pitch, peel_w, peel_h);
 	
 	result->peel = peel_surface;
 	return result;
@@ -2810,7 +3034,20 @@ char* sound_name(int index) {
 
 sound_buffer_type* convert_digi_sound(sound_buffer_type* digi_buffer);
 
+#ifdef POP_RP2350
+static sound_buffer_type* load_sound_body(int index);
+
+sound_buffer_type* load_sound(int index) {
+	const mem_cat_t prev_cat = psram_set_category(MEM_CAT_SOUND);
+	sound_buffer_type* result = load_sound_body(index);
+	psram_set_category(prev_cat);
+	return result;
+}
+
+static sound_buffer_type* load_sound_body(int index) {
+#else
 sound_buffer_type* load_sound(int index) {
+#endif
 	sound_buffer_type* result = NULL;
 	DBG_PRINTF("[load_sound] index=%d\\n", index);
 	init_digi();
@@ -2967,7 +3204,7 @@ sound_buffer_type* convert_digi_sound(sound_buffer_type* digi_buffer) {
 	int expanded_length = expanded_frames * 2 * sizeof(short);
 	DBG_PRINTF("[convert_digi_sound] expanded_frames=%d expanded_length=%d\\n", expanded_frames, expanded_length);
 #ifdef POP_RP2350
-	sound_buffer_type* converted_buffer = pop_heap_alloc(sizeof(sound_buffer_type) + expanded_length);
+	sound_buffer_type* converted_buffer = pop_heap_alloc(sizeof(sound_buffer_type) + expanded_length, MEM_CAT_SOUND);
 #else
 	sound_buffer_type* converted_buffer = malloc(sizeof(sound_buffer_type) + expanded_length);
 #endif
@@ -2979,7 +3216,7 @@ sound_buffer_type* convert_digi_sound(sound_buffer_type* digi_buffer) {
 	byte* source = waveinfo.samples;
 	//short* dest = converted_buffer->converted.samples;
 #ifdef POP_RP2350
-	short* dest = pop_heap_alloc(sizeof(short) * converted_buffer->converted.length);
+	short* dest = pop_heap_alloc(sizeof(short) * converted_buffer->converted.length, MEM_CAT_SOUND);
 #else
 	short* dest = malloc(sizeof(short) * converted_buffer->converted.length);
 #endif
@@ -3193,6 +3430,10 @@ void init_scaling(void) {
 	}
 }
 
+#ifdef POP_RP2350
+static void rp2350_pal_mark_all(void);
+#endif
+
 // seg009:38ED
 void set_gr_mode(byte grmode) {
 #ifdef SDL_HINT_WINDOWS_DISABLE_THREAD_NAMING
@@ -3322,6 +3563,8 @@ void set_gr_mode(byte grmode) {
 		}
 		SDL_SetPaletteColors(onscreen_surface_->format->palette, colors, 0, 256);
 		DBG_PRINTF("[set_gr_mode] temp palette set\n");
+		// The hardware no longer matches palette[]; the next set_pal* must push every entry.
+		rp2350_pal_mark_all();
 	}
 	// RP2350 scanout uses our SDL_UpdateTexture shim; no need for overlay/scaling textures.
 	DBG_PRINTF("[set_gr_mode] done (RP2350)\n");
@@ -3488,13 +3731,69 @@ void update_screen() {
 	SDL_RenderPresent(renderer_);
 }
 
+rgb_type palette[256];
+
 #ifdef POP_RP2350
-static inline void rp2350_apply_palette_256(void);
+// Entries of palette[] that differ from what the onscreen surface was last given.
+// Only these are pushed (and TMDS re-encoded by the HDMI driver) on the next flush.
+static uint32_t rp2350_pal_dirty[256 / 32];
+static SDL_Palette* rp2350_pal_target = NULL; // Palette the last flush went to
+static bool rp2350_pal_batch = false;         // set_pal() only marks while set
+
+static void rp2350_pal_mark_all(void) {
+	memset(rp2350_pal_dirty, 0xFF, sizeof(rp2350_pal_dirty));
+}
+
+static inline void rp2350_pal_set_entry(int index, int red, int green, int blue) {
+	rgb_type* p = &palette[index];
+	if (p->r == red && p->g == green && p->b == blue) return;
+	p->r = red;
+	p->g = green;
+	p->b = blue;
+	rp2350_pal_dirty[index >> 5] |= 1u << (index & 31);
+}
+
+// Push dirty entries to the onscreen palette, one SDL_SetPaletteColors() per contiguous run.
+static void rp2350_pal_flush(void) {
+	if (onscreen_surface_ == NULL || onscreen_surface_->format == NULL || onscreen_surface_->format->palette == NULL) return;
+	SDL_Palette* target = onscreen_surface_->format->palette;
+	if (target != rp2350_pal_target) {
+		rp2350_pal_target = target;
+		rp2350_pal_mark_all();
+	}
+	SDL_Color scolors[256];
+	int run_start = -1;
+	for (int i = 0; i <= 256; ++i) {
+		bool dirty = false;
+		if (i < 256) {
+			if ((i & 31) == 0 && rp2350_pal_dirty[i >> 5] == 0 && run_start < 0) {
+				i += 31; // Whole word clean
+				continue;
+			}
+			dirty = (rp2350_pal_dirty[i >> 5] >> (i & 31)) & 1;
+		}
+		if (dirty) {
+			if (run_start < 0) run_start = i;
+			scolors[i].r = (Uint8)(palette[i].r << 2);
+			scolors[i].g = (Uint8)(palette[i].g << 2);
+			scolors[i].b = (Uint8)(palette[i].b << 2);
+			scolors[i].a = SDL_ALPHA_OPAQUE;
+		} else if (run_start >= 0) {
+			SDL_SetPaletteColors(target, &scolors[run_start], run_start, i - run_start);
+			run_start = -1;
+		}
+	}
+	memset(rp2350_pal_dirty, 0, sizeof(rp2350_pal_dirty));
+}
 #endif
 
 // seg009:9289
 void set_pal_arr(int start,int count,const rgb_type* array) {
 	// stub
+	#ifdef POP_RP2350
+	// Batch the row: set_pal() only marks changed entries, then one flush pushes them.
+	rp2350_pal_batch = true;
+	#endif
 	for (int i = 0; i < count; ++i) {
 		if (array) {
 			set_pal(start + i, array[i].r, array[i].g, array[i].b);
@@ -3503,47 +3802,23 @@ void set_pal_arr(int start,int count,const rgb_type* array) {
 		}
 	}
 	#ifdef POP_RP2350
-	// set_pal() pushes per-entry; bulk push keeps things consistent for large updates.
-	rp2350_apply_palette_256();
+	rp2350_pal_batch = false;
+	rp2350_pal_flush();
 	#endif
 }
 
-rgb_type palette[256];
-
-#ifdef POP_RP2350
-static inline void rp2350_apply_palette_entry(int index, int red, int green, int blue) {
-	if (index < 0 || index > 255) return;
-	if (onscreen_surface_ == NULL || onscreen_surface_->format == NULL || onscreen_surface_->format->palette == NULL) return;
-	SDL_Color c;
-	c.r = (Uint8)(red << 2);
-	c.g = (Uint8)(green << 2);
-	c.b = (Uint8)(blue << 2);
-	c.a = SDL_ALPHA_OPAQUE;
-	SDL_SetPaletteColors(onscreen_surface_->format->palette, &c, index, 1);
-}
-
-static inline void rp2350_apply_palette_256(void) {
-	if (onscreen_surface_ == NULL || onscreen_surface_->format == NULL || onscreen_surface_->format->palette == NULL) return;
-	SDL_Color scolors[256];
-	for (int i = 0; i < 256; ++i) {
-		scolors[i].r = (Uint8)(palette[i].r << 2);
-		scolors[i].g = (Uint8)(palette[i].g << 2);
-		scolors[i].b = (Uint8)(palette[i].b << 2);
-		scolors[i].a = SDL_ALPHA_OPAQUE;
-	}
-	SDL_SetPaletteColors(onscreen_surface_->format->palette, scolors, 0, 256);
-}
-#endif
-
 // seg009:92DF
 void set_pal(int index,int red,int green,int blue) {
 	// stub
 	//palette[index] = ((red&0x3F)<<2)|((green&0x3F)<<2<<8)|((blue&0x3F)<<2<<16);
+	#ifdef POP_RP2350
+	if (index < 0 || index > 255) return;
+	rp2350_pal_set_entry(index, red, green, blue);
+	if (!rp2350_pal_batch) rp2350_pal_flush();
+	#else
 	palette[index].r = red;
 	palette[index].g = green;
 	palette[index].b = blue;
-	#ifdef POP_RP2350
-	rp2350_apply_palette_entry(index, red, green, blue);
 	#endif
 }
 
@@ -3709,18 +3984,17 @@ void *load_from_opendats_alloc(int resource, const char* extension, data_locatio
 	if (result == data_none) return NULL;
 	void* area = NULL;
 	#ifdef POP_RP2350
-	// IMPORTANT: psram_malloc is a bump allocator (psram_free is a no-op), so using it for
-	// per-image file contents will leak PSRAM quickly. For PNG resources (which are consumed
-	// immediately by IMG_Load_RW/decode_image) we can use the dedicated reusable PSRAM file buffer.
+	// PNG resources are consumed immediately by IMG_Load_RW/decode_image, so they go to the
+	// dedicated reusable PSRAM file buffer instead of a heap block that is freed right after.
 	if (extension && strcmp(extension, "png") == 0) {
 		area = psram_get_file_buffer((size_t)size);
 		if (area == NULL) {
-			// Fallback: try general heap (PSRAM bump, then SRAM malloc). This may still OOM,
+			// Fallback: try the general PSRAM heap. This may still OOM,
 			// but keeps behavior consistent for oversized resources.
-			area = pop_heap_alloc((size_t)size);
+			area = pop_heap_alloc((size_t)size, MEM_CAT_FILEBUF);
 		}
 	} else {
-		area = pop_heap_alloc((size_t)size);
+		area = pop_heap_alloc((size_t)size, MEM_CAT_FILEBUF);
 	}
 	#else
 	area = malloc(size);
@@ -3832,6 +4106,7 @@ image_type* method_3_blit_mono(image_type* image,int xpos,int ypos,int blitter,b
 	// Font pixels: 0 = transparent (skip), 1 = foreground (write 'color' index).
 	if (image->format->BytesPerPixel == 1 && current_target_surface->format->BytesPerPixel == 1) {
 		// Direct 8bpp→8bpp mono blit: write destination index 'color' for foreground pixels
+		SDL_FenceSurfaces();
 		uint8_t* src_pixels = (uint8_t*)image->pixels;
 		uint8_t* dst_pixels = (uint8_t*)current_target_surface->pixels;
 		int src_pitch = image->pitch;
@@ -3863,6 +4138,8 @@ image_type* method_3_blit_mono(image_type* image,int xpos,int ypos,int blitter,b
 			DBG_PRINTF("[method_3_blit_mono] src total: fg=%d bg=%d (of %d)\n", fg_total, bg_total, w*h);
 		}
 		
+		// Onscreen is scanned out unfiltered: never store HDMI control indices.
+		color = SDL_SurfaceSafeIndex(current_target_surface, color);
 		for (int y = 0; y < h; ++y) {
 			int dy = ypos + y;
 			if (dy < clip_top || dy >= clip_bottom) continue;
@@ -3875,6 +4152,8 @@ image_type* method_3_blit_mono(image_type* image,int xpos,int ypos,int blitter,b
 				dst_pixels[dy * dst_pitch + dx] = color;
 			}
 		}
+		SDL_Rect dirty_rect = {xpos, ypos, w, h};
+		SDL_AddDirtyRect(current_target_surface, &dirty_rect);
 		if (rp2350_m3_calls < 16) {
 			DBG_PRINTF("[method_3_blit_mono] 8bpp direct blit ok (color_idx=%u)\n", (unsigned)color);
 		}
@@ -4045,6 +4324,13 @@ void blit_xor(SDL_Surface* target_surface, SDL_Rect* dest_rect, SDL_Surface* ima
 		printf("blit_xor: dest_rect and src_rect have different sizes\n");
 		quit(1);
 	}
+#ifdef POP_RP2350
+	// 8bpp in place: the 24bpp helper and converted image below came from the PSRAM bump
+	// allocator on every call (never reclaimed), and 8->24bpp conversion is not supported.
+	if (SDL_BlitXor8(image, src_rect, target_surface, dest_rect) == 0) {
+		return;
+	}
+#endif
 	SDL_Surface* helper_surface = SDL_CreateRGBSurface(0, dest_rect->w, dest_rect->h, 24, Rmsk, Gmsk, Bmsk, 0);
 	if (helper_surface == NULL) {
 		sdlperror("blit_xor: SDL_CreateRGBSurface");
@@ -4223,6 +4509,7 @@ image_type* method_6_blit_img_to_scr(image_type* image,int xpos,int ypos,int bli
 	if (is_rgba_to_indexed) {
 		// Manual RGBA→indexed blit
 		const int respect_alpha = (blit != blitters_0_no_transp);
+		SDL_FenceSurfaces();
 		uint8_t* src_pixels = (uint8_t*)image->pixels;
 		uint8_t* dst_pixels = (uint8_t*)current_target_surface->pixels;
 		int src_pitch = image->pitch;
@@ -4314,6 +4601,11 @@ image_type* method_6_blit_img_to_scr(image_type* image,int xpos,int ypos,int bli
 						uint8_t g = (pixel & gmask) >> gshift;
 						uint8_t b = (pixel & bmask) >> bshift;
 						
+						#ifdef POP_RP2350
+						// Nearest palette color via the shared inverse colormap
+						int best_idx = SDL_PaletteNearestIndex(pal, 0, pal->ncolors, r, g, b);
+						best_idx = SDL_SurfaceSafeIndex(current_target_surface, (Uint8)best_idx);
+						#else
 						// Find nearest palette color (simple brute force)
 						int best_dist = 0x7FFFFFFF;
 						int best_idx = 0;
@@ -4327,6 +4619,7 @@ image_type* method_6_blit_img_to_scr(image_type* image,int xpos,int ypos,int bli
 								best_idx = i;
 							}
 						}
+						#endif
 						dst_row[x] = (uint8_t)best_idx;
 						#ifdef POP_RP2350
 						pixels_written++;
@@ -4348,6 +4641,10 @@ image_type* method_6_blit_img_to_scr(image_type* image,int xpos,int ypos,int bli
 				blit_stats_count++;
 			}
 			#endif
+			#ifdef POP_RP2350
+			SDL_Rect dirty_rect = {dst_x, dst_y, copy_w, copy_h};
+			SDL_AddDirtyRect(current_target_surface, &dirty_rect);
+			#endif
 		}
 		
 		return image;
@@ -5276,11 +5573,15 @@ void read_palette_256(rgb_type* target) {
 
 // seg009:1F5E
 void set_pal_256(rgb_type* source) {
+	#ifdef POP_RP2350
+	for (int i = 0; i < 256; ++i) {
+		rp2350_pal_set_entry(i, source[i].r, source[i].g, source[i].b);
+	}
+	rp2350_pal_flush();
+	#else
 	for (int i = 0; i < 256; ++i) {
 		palette[i] = source[i];
 	}
-	#ifdef POP_RP2350
-	rp2350_apply_palette_256();
 	#endif
 }
 #endif // USE_FADE
@@ -0,0 +1,139 @@
+/*
+ * hdmi_line_bench - host microbenchmark for the HDMI scanline preparation.
+ *
+ * Times hdmi_line_pixels() from drivers/hdmi_line.h (the visible part of every line
+ * the DMA ISR prepares) against the loop the ISR used before scanout buffers were
+ * kept free of control indices, which clamped 240..243 to 255 pixel by pixel. Three
+ * placements are measured: the 320x200 game frame unshifted (zero-copy gameplay, the
+ * word-copy fast path), the same frame shifted right by 4 pixels (general path) and a
+ * raw text-mode row. For a control-index-free frame both must produce identical lines.
+ *
+ * Host nanoseconds are not RP2350 cycles; compare the ratio between the two loops.
+ *
+ * Build:
+ *   cc -O2 -Idrivers -o hdmi_line_bench tools/hdmi_line_bench.c
+ *
+ * Usage:
+ *   hdmi_line_bench [frames]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hdmi_line.h"
+
+#define FRAME_W 320
+#define FRAME_H 200
+#define RASTER_H 240
+
+static uint8_t g_frame[FRAME_W * FRAME_H] __attribute__((aligned(4)));
+static uint8_t g_line_old[HDMI_LINE_PIXELS] __attribute__((aligned(4)));
+static uint8_t g_line_new[HDMI_LINE_PIXELS] __attribute__((aligned(4)));
+
+static double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// The ISR's GRAPHICSMODE_DEFAULT / raw loops before the filter was dropped.
+static void old_line_pixels(uint8_t *output_buffer, const hdmi_line_src_t *src, int y) {
+    const int row = y - src->shift_y;
+    if (!src->buffer || row < 0 || row >= src->height || src->shift_x >= HDMI_LINE_PIXELS ||
+        (src->shift_x + src->width) < 0) {
+        memset(output_buffer, 255, HDMI_LINE_PIXELS);
+        return;
+    }
+    const uint8_t *input_buffer = src->buffer + row * src->width;
+    if (src->raw) {
+        for (int i = HDMI_LINE_PIXELS; i--;) {
+            uint8_t i_color = *input_buffer++;
+            if (i_color >= BASE_HDMI_CTRL_INX && i_color < (BASE_HDMI_CTRL_INX + HDMI_CTRL_COUNT)) i_color = 255;
+            *output_buffer++ = i_color;
+        }
+        return;
+    }
+    uint8_t *activ_buf_end = output_buffer + HDMI_LINE_PIXELS;
+    for (int i = src->shift_x; i-- > 0;) {
+        *output_buffer++ = 255;
+    }
+    const uint8_t *input_buffer_end = input_buffer + src->width;
+    if (src->shift_x < 0) input_buffer -= src->shift_x;
+    size_t x = 0;
+    while (activ_buf_end > output_buffer) {
+        if (input_buffer + x < input_buffer_end) {
+            uint8_t c = input_buffer[x++];
+            *output_buffer++ = (c >= BASE_HDMI_CTRL_INX && c < (BASE_HDMI_CTRL_INX + HDMI_CTRL_COUNT)) ? 255 : c;
+        } else {
+            *output_buffer++ = 255;
+        }
+    }
+}
+
+typedef void (*line_fn_t)(uint8_t *, const hdmi_line_src_t *, int);
+
+static void new_line_pixels(uint8_t *output_buffer, const hdmi_line_src_t *src, int y) {
+    hdmi_line_pixels(output_buffer, src, y);
+}
+
+// ns per visible line over `frames` frames of the 240-line raster.
+static double time_lines(line_fn_t fn, uint8_t *line, const hdmi_line_src_t *src, int frames, unsigned *sink) {
+    const double t0 = bench_now_ns();
+    for (int f = 0; f < frames; ++f) {
+        for (int y = 0; y < RASTER_H; ++y) {
+            fn(line, src, y);
+            *sink += line[(unsigned)y % HDMI_LINE_PIXELS];
+        }
+    }
+    return (bench_now_ns() - t0) / ((double)frames * RASTER_H);
+}
+
+int main(int argc, char *argv[]) {
+    const int frames = argc > 1 ? atoi(argv[1]) : 2000;
+    if (frames <= 0) {
+        fprintf(stderr, "usage: hdmi_line_bench [frames]\n");
+        return 2;
+    }
+
+    // Game-like frame: runs of a few colours, no control indices.
+    uint32_t rng = 12345;
+    for (int i = 0; i < FRAME_W * FRAME_H;) {
+        rng = rng * 1664525u + 1013904223u;
+        const int run = 1 + (int)((rng >> 8) % 24);
+        uint8_t c = (uint8_t)(rng >> 24);
+        if (c >= BASE_HDMI_CTRL_INX && c < BASE_HDMI_CTRL_INX + HDMI_CTRL_COUNT) c = 255;
+        for (int k = 0; k < run && i < FRAME_W * FRAME_H; ++k) g_frame[i++] = c;
+    }
+
+    const struct {
+        const char *name;
+        hdmi_line_src_t src;
+    } cases[] = {
+        {"game frame, unshifted", {g_frame, FRAME_W, FRAME_H, 0, (RASTER_H - FRAME_H) / 2, false}},
+        {"game frame, shift_x 4", {g_frame, FRAME_W, FRAME_H, 4, (RASTER_H - FRAME_H) / 2, false}},
+        {"raw rows", {g_frame, FRAME_W, FRAME_H, 0, (RASTER_H - FRAME_H) / 2, true}},
+    };
+
+    int errors = 0;
+    unsigned sink = 0;
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+        const hdmi_line_src_t *src = &cases[c].src;
+        for (int y = 0; y < RASTER_H; ++y) {
+            old_line_pixels(g_line_old, src, y);
+            hdmi_line_pixels(g_line_new, src, y);
+            if (memcmp(g_line_old, g_line_new, HDMI_LINE_PIXELS) != 0) {
+                fprintf(stderr, "%s: line %d differs\n", cases[c].name, y);
+                errors++;
+                break;
+            }
+        }
+        const double old_ns = time_lines(old_line_pixels, g_line_old, src, frames, &sink);
+        const double new_ns = time_lines(new_line_pixels, g_line_new, src, frames, &sink);
+        printf("%-22s filtered %6.1f ns/line, unfiltered %6.1f ns/line (%.1fx)\n", cases[c].name, old_ns, new_ns,
+               new_ns > 0 ? old_ns / new_ns : 0.0);
+    }
+    printf("%s: %d error(s) (checksum %u)\n", errors ? "FAIL" : "OK", errors, sink);
+    return errors ? 1 : 0;
+}
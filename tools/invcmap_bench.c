@@ -0,0 +1,153 @@
+/*
+ * invcmap_bench - host benchmark for the inverse colormap (src/inverse_cmap.h).
+ *
+ * Converts real sprite PNGs to 8bpp the way load_image() does (alpha < 128 -> index
+ * 0, otherwise the nearest of palette entries 1..15), once with the old linear search
+ * and once with the inverse colormap, checks that both give identical pixels, and
+ * reports the time per pixel. As on the device each sprite brings its own palette (a
+ * new version here), which the map absorbs with invcmap_bind() instead of a reset.
+ * The same pixels are then matched against a 256-entry palette (the sprite colours
+ * plus the 6-bit VGA cube spread over the rest), which is the find_best_palette_index()
+ * case for the screen palette.
+ *
+ * Build:
+ *   cc -O2 -Isrc -Isrc/third_party/stb -o invcmap_bench tools/invcmap_bench.c -lm
+ *
+ * Usage:
+ *   invcmap_bench data/VDUNGEON/res200.pal data/VDUNGEON/res*.png
+ */
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "inverse_cmap.h"
+
+static invcmap_t g_sprite_map;
+static invcmap_t g_screen_map;
+
+static double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// The brute-force search the call sites used before.
+static uint8_t linear_nearest(const uint8_t *colors, int first, int count, uint8_t r, uint8_t g, uint8_t b) {
+    int best_distance = INT_MAX;
+    uint8_t best_index = (uint8_t)first;
+    for (int i = first; i < first + count; ++i) {
+        const uint8_t *c = &colors[i * 4];
+        const int dr = (int)r - (int)c[0];
+        const int dg = (int)g - (int)c[1];
+        const int db = (int)b - (int)c[2];
+        const int distance = dr * dr + dg * dg + db * db;
+        if (distance < best_distance) {
+            best_distance = distance;
+            best_index = (uint8_t)i;
+            if (distance == 0) break;
+        }
+    }
+    return best_index;
+}
+
+typedef struct {
+    double linear_ns;
+    double invcmap_ns;
+    long pixels;
+    long mismatches;
+} bench_result_t;
+
+// The map is bound the way rp2350_palette_nearest() does it, so `version` changing per
+// image stands for a new palette with the same colours.
+static void bench_convert(invcmap_t *map, uint32_t version, const uint8_t *rgba, int n, const uint8_t *colors,
+                          int first, int count, uint8_t *out_linear, uint8_t *out_map, bench_result_t *res) {
+    double t0 = bench_now_ns();
+    for (int i = 0; i < n; ++i) {
+        const uint8_t *p = &rgba[i * 4];
+        out_linear[i] = (p[3] < 128) ? 0 : linear_nearest(colors, first, count, p[0], p[1], p[2]);
+    }
+    double t1 = bench_now_ns();
+    invcmap_bind(map, colors, version, colors, first, count, false);
+    for (int i = 0; i < n; ++i) {
+        const uint8_t *p = &rgba[i * 4];
+        out_map[i] = (p[3] < 128) ? 0 : invcmap_lookup(map, colors, p[0], p[1], p[2]);
+    }
+    double t2 = bench_now_ns();
+
+    res->linear_ns += t1 - t0;
+    res->invcmap_ns += t2 - t1;
+    res->pixels += n;
+    for (int i = 0; i < n; ++i) res->mismatches += (out_linear[i] != out_map[i]);
+}
+
+static void bench_report(const char *name, const bench_result_t *res) {
+    if (res->pixels == 0) return;
+    printf("%-22s %8ld px  linear %7.1f ns/px  invcmap %6.1f ns/px  x%.1f  mismatches %ld\n", name,
+        res->pixels, res->linear_ns / res->pixels, res->invcmap_ns / res->pixels,
+        res->invcmap_ns > 0 ? res->linear_ns / res->invcmap_ns : 0.0, res->mismatches);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: invcmap_bench palette.pal image.png...\n");
+        return 2;
+    }
+
+    // dat_shpl_type: n_images, row_bits (2), n_colors, vga[16] (6-bit RGB).
+    FILE *f = fopen(argv[1], "rb");
+    uint8_t shpl[100];
+    if (!f || fread(shpl, 1, sizeof(shpl), f) < 4 + 48) {
+        fprintf(stderr, "%s: not a SDLPoP palette\n", argv[1]);
+        return 2;
+    }
+    fclose(f);
+
+    static uint8_t colors16[16 * 4];
+    static uint8_t colors256[256 * 4];
+    for (int i = 0; i < 16; ++i) {
+        colors16[i * 4 + 0] = (uint8_t)(shpl[4 + i * 3 + 0] << 2);
+        colors16[i * 4 + 1] = (uint8_t)(shpl[4 + i * 3 + 1] << 2);
+        colors16[i * 4 + 2] = (uint8_t)(shpl[4 + i * 3 + 2] << 2);
+        colors16[i * 4 + 3] = 255;
+    }
+    memcpy(colors256, colors16, sizeof(colors16));
+    for (int i = 16; i < 256; ++i) {
+        const int k = (i - 16) * 262143 / 239;  // Spread over the 18-bit VGA colour cube
+        colors256[i * 4 + 0] = (uint8_t)(((k >> 12) & 63) << 2);
+        colors256[i * 4 + 1] = (uint8_t)(((k >> 6) & 63) << 2);
+        colors256[i * 4 + 2] = (uint8_t)((k & 63) << 2);
+        colors256[i * 4 + 3] = 255;
+    }
+
+    bench_result_t sprite = {0}, screen = {0};
+    int images = 0;
+    for (int a = 2; a < argc; ++a) {
+        int w = 0, h = 0, comp = 0;
+        uint8_t *rgba = stbi_load(argv[a], &w, &h, &comp, 4);
+        if (!rgba) {
+            fprintf(stderr, "%s: %s\n", argv[a], stbi_failure_reason());
+            continue;
+        }
+        const int n = w * h;
+        uint8_t *out_linear = malloc((size_t)n);
+        uint8_t *out_map = malloc((size_t)n);
+        bench_convert(&g_sprite_map, (uint32_t)images, rgba, n, colors16, 1, 15, out_linear, out_map, &sprite);
+        bench_convert(&g_screen_map, 0, rgba, n, colors256, 0, 256, out_linear, out_map, &screen);
+        free(out_linear);
+        free(out_map);
+        stbi_image_free(rgba);
+        images++;
+    }
+
+    printf("%d image(s)\n", images);
+    bench_report("sprite (1..15 of 16)", &sprite);
+    bench_report("screen (256 entries)", &screen);
+    printf("cells built: sprite %lu, screen %lu; sprite map resets %lu, rebinds %lu\n",
+        (unsigned long)g_sprite_map.cells_built, (unsigned long)g_screen_map.cells_built,
+        (unsigned long)g_sprite_map.resets, (unsigned long)g_sprite_map.rebinds);
+    return (sprite.mismatches || screen.mismatches) ? 1 : 0;
+}
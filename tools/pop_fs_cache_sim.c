@@ -0,0 +1,434 @@
+/*
+ * pop_fs_cache_sim - host test for the pop_fs_open() path cache (src/pop_fs_cache.h).
+ *
+ * Formats a RAM disk with the FatFS the firmware uses (src/fatfs, same ffconf.h), builds
+ * a tree shaped like the game's SD card (DATs and sprite directories under data/, some
+ * clutter in the root, long names with 8.3 aliases, fragmented files) and opens files
+ * through the same glue pop_fs.c uses, once on FAT32 and once on exFAT.
+ *
+ *  - game load: the lookups SDLPoP makes (each DAT in the root, then in data/; each
+ *    sprite in every directory of the DAT chain until one has it) are run without and
+ *    with the cache. Every open must give the same result and the same file contents;
+ *    sectors read from the card are reported for both.
+ *  - random paths: existing and missing files, other letter case, 8.3 aliases, missing
+ *    directories, files used as directories, directories opened as files, "..", trailing
+ *    dots and backslashes, each checked against plain f_open() and f_stat(), with a
+ *    table large enough for the tree and with one that fills up.
+ *  - writes: files created, rewritten and deleted and directories made through the
+ *    writing calls must be seen by the next cached lookup.
+ *
+ * Build:
+ *   cc -O2 -Isrc -Isrc/fatfs -o pop_fs_cache_sim tools/pop_fs_cache_sim.c \
+ *      src/fatfs/ff.c src/fatfs/ffunicode.c src/fatfs/ffsystem.c
+ *
+ * Usage:
+ *   pop_fs_cache_sim [lookups] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ff.h"
+#include "diskio.h"
+#include "pop_fs_cache.h"
+
+#define DISK_SECTORS (64u * 1024u * 1024u / 512u)
+#define CACHE_SLOTS 4096
+#define SMALL_SLOTS 64
+
+static const char *const g_dirs[] = {
+    "KID", "PRINCE", "GUARD", "GUARD1", "GUARD2", "FAT", "SHADOW", "SKEL",
+    "VIZIER", "VDUNGEON", "VPALACE", "TITLE", "PV", "LEVELS",
+};
+#define DIR_COUNT (int)(sizeof(g_dirs) / sizeof(g_dirs[0]))
+#define MAX_ID 1000
+
+static uint8_t *g_disk;
+static uint64_t g_sectors_read;
+static uint64_t g_rng = 0x9E3779B97F4A7C15ull;
+static bool g_has[DIR_COUNT][MAX_ID];
+
+static uint32_t rnd(void) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return (uint32_t)(g_rng >> 32);
+}
+
+// RAM disk behind FatFS
+
+DSTATUS disk_initialize(BYTE pdrv) { return pdrv ? STA_NOINIT : 0; }
+DSTATUS disk_status(BYTE pdrv) { return pdrv ? STA_NOINIT : 0; }
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count) {
+    if (pdrv || sector + count > DISK_SECTORS) return RES_PARERR;
+    memcpy(buff, g_disk + (size_t)sector * 512, (size_t)count * 512);
+    g_sectors_read += count;
+    return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count) {
+    if (pdrv || sector + count > DISK_SECTORS) return RES_PARERR;
+    memcpy(g_disk + (size_t)sector * 512, buff, (size_t)count * 512);
+    return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff) {
+    if (pdrv) return RES_PARERR;
+    switch (cmd) {
+        case CTRL_SYNC: return RES_OK;
+        case GET_SECTOR_COUNT: *(LBA_t *)buff = DISK_SECTORS; return RES_OK;
+        case GET_SECTOR_SIZE: *(WORD *)buff = 512; return RES_OK;
+        case GET_BLOCK_SIZE: *(DWORD *)buff = 1; return RES_OK;
+        default: return RES_PARERR;
+    }
+}
+
+DWORD get_fattime(void) {
+    return ((DWORD)(2024 - 1980) << 25) | (1u << 21) | (1u << 16);
+}
+
+// The pop_fs.c glue, minus the Pico SDK
+
+static FATFS g_fs;
+static pop_fs_cache_t g_cache;
+static pop_fs_cache_entry_t g_slots[CACHE_SLOTS];
+static bool g_use_cache;
+static uint32_t g_f_opens;
+
+static FIL *sim_open(const char *full, BYTE mode) {
+    pop_fs_cache_entry_t *entry = NULL;
+    if (mode & FA_WRITE) {
+        pop_fs_cache_flush(&g_cache);
+    } else if (g_use_cache) {
+        const pop_fs_cache_result_t found = pop_fs_cache_lookup(&g_cache, full, &entry);
+        if (found == POP_FS_CACHE_MISSING || (entry && (entry->attr & AM_DIR))) {
+            g_cache.misses++;
+            return NULL;
+        }
+    }
+    FIL *fil = (FIL *)calloc(1, sizeof(FIL));
+    if (!fil) return NULL;
+    if (entry && entry->kind == POP_FS_CACHE_RESOLVED) {
+        pop_fs_cache_open(entry, &g_fs, fil);
+        g_cache.hits++;
+        return fil;
+    }
+    g_cache.walks++;
+    g_f_opens++;
+    if (f_open(fil, full, mode) != FR_OK) {
+        free(fil);
+        return NULL;
+    }
+    if (entry) pop_fs_cache_resolve(entry, fil);
+    return fil;
+}
+
+static void sim_close(FIL *fil) {
+#if FF_FS_LOCK
+    if (fil->obj.lockid != 0) f_close(fil);
+#else
+    f_close(fil);
+#endif
+    free(fil);
+}
+
+static bool sim_exists(const char *full) {
+    if (g_use_cache) {
+        pop_fs_cache_entry_t *entry;
+        switch (pop_fs_cache_lookup(&g_cache, full, &entry)) {
+            case POP_FS_CACHE_FOUND: return true;
+            case POP_FS_CACHE_MISSING: g_cache.misses++; return false;
+            default: break;
+        }
+    }
+    FILINFO fno;
+    return f_stat(full, &fno) == FR_OK;
+}
+
+static int fail(const char *what, const char *path) {
+    fprintf(stderr, "FAIL: %s (%s)\n", what, path);
+    return 1;
+}
+
+// FNV-1a of the whole file, read in odd-sized pieces with a seek, or 0 if it fails.
+static uint64_t read_hash(FIL *fil) {
+    uint64_t h = 14695981039346656037ull;
+    uint8_t buf[700];
+    const FSIZE_t size = f_size(fil);
+    if (size > 1000 && (f_lseek(fil, size / 2) != FR_OK || f_lseek(fil, 0) != FR_OK)) return 0;
+    for (FSIZE_t done = 0; done < size;) {
+        UINT br;
+        if (f_read(fil, buf, sizeof(buf), &br) != FR_OK || br == 0) return 0;
+        for (UINT i = 0; i < br; ++i) {
+            h ^= buf[i];
+            h *= 1099511628211ull;
+        }
+        done += br;
+    }
+    return h ^ size;
+}
+
+// Tree
+
+static int write_file(const char *full, uint32_t size, uint32_t salt) {
+    FIL fil;
+    if (f_open(&fil, full, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) return fail("create", full);
+    uint8_t buf[512];
+    for (uint32_t done = 0; done < size;) {
+        const uint32_t n = size - done < sizeof(buf) ? size - done : (uint32_t)sizeof(buf);
+        for (uint32_t i = 0; i < n; ++i) buf[i] = (uint8_t)((done + i) * 31u + salt);
+        UINT bw;
+        if (f_write(&fil, buf, n, &bw) != FR_OK || bw != n) return fail("write", full);
+        done += n;
+    }
+    return f_close(&fil) == FR_OK ? 0 : fail("close", full);
+}
+
+static int build_tree(void) {
+    char path[POP_FS_CACHE_MAX_PATH];
+    if (f_mkdir("0:/data") != FR_OK || f_mkdir("0:/saves") != FR_OK) return fail("mkdir", "0:/data");
+    for (int i = 0; i < 40; ++i) {   // Whatever else is on the card
+        snprintf(path, sizeof(path), "0:/Some other file number %d.txt", i);
+        if (write_file(path, 100 + rnd() % 3000, (uint32_t)i)) return 1;
+    }
+    if (write_file("0:/SDLPoP.ini", 2000, 7)) return 1;
+    memset(g_has, 0, sizeof(g_has));
+    for (int d = 0; d < DIR_COUNT; ++d) {
+        snprintf(path, sizeof(path), "0:/data/%s", g_dirs[d]);
+        if (f_mkdir(path) != FR_OK) return fail("mkdir", path);
+        if (d % 3 == 0) {
+            snprintf(path, sizeof(path), "0:/data/%s.DAT", g_dirs[d]);
+            if (write_file(path, 5000 + rnd() % 60000, (uint32_t)d)) return 1;
+        }
+        const int count = 20 + (int)(rnd() % 100);
+        for (int k = 0; k < count; ++k) {
+            const int id = (int)(rnd() % MAX_ID);
+            if (g_has[d][id]) continue;
+            g_has[d][id] = true;
+            snprintf(path, sizeof(path), "0:/data/%s/res%d.png", g_dirs[d], id);
+            if (write_file(path, 50 + rnd() % 6000, (uint32_t)(d * MAX_ID + id))) return 1;
+        }
+        snprintf(path, sizeof(path), "0:/data/%s/a long name for %s.bin", g_dirs[d], g_dirs[d]);
+        if (write_file(path, 1000, (uint32_t)d)) return 1;
+    }
+    // Two files written a cluster at a time in turns end up fragmented.
+    FIL a, b;
+    if (f_open(&a, "0:/data/music.ogg", FA_WRITE | FA_CREATE_ALWAYS) != FR_OK ||
+        f_open(&b, "0:/data/digisnd.bin", FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+        return fail("create", "0:/data/music.ogg");
+    }
+    uint8_t chunk[4096];
+    for (int i = 0; i < 40; ++i) {
+        UINT bw;
+        memset(chunk, i, sizeof(chunk));
+        if (f_write(&a, chunk, sizeof(chunk), &bw) != FR_OK || f_write(&b, chunk, 777, &bw) != FR_OK) {
+            return fail("write", "0:/data/music.ogg");
+        }
+    }
+    f_close(&a);
+    f_close(&b);
+    return 0;
+}
+
+// Checks
+
+typedef struct {
+    bool ok;
+    uint64_t hash;
+} outcome_t;
+
+static outcome_t open_read(const char *full) {
+    outcome_t o = {false, 0};
+    FIL *fil = sim_open(full, FA_READ);
+    if (!fil) return o;
+    o.ok = true;
+    o.hash = read_hash(fil);
+    sim_close(fil);
+    return o;
+}
+
+static outcome_t plain_open_read(const char *full) {
+    const bool saved = g_use_cache;
+    g_use_cache = false;
+    const outcome_t o = open_read(full);
+    g_use_cache = saved;
+    return o;
+}
+
+static int check_path(const char *full) {
+    const outcome_t want = plain_open_read(full);
+    const outcome_t got = open_read(full);
+    if (got.ok != want.ok) return fail(want.ok ? "cache lost a file" : "cache opened a missing file", full);
+    if (got.ok && got.hash != want.hash) return fail("contents differ", full);
+    FILINFO fno;
+    if (sim_exists(full) != (f_stat(full, &fno) == FR_OK)) return fail("exists differs from f_stat", full);
+    return 0;
+}
+
+// SDLPoP's lookups for a game session: returns the number of opens that found a file.
+static int game_load(int lookups, uint64_t seed, uint64_t *hash) {
+    char path[POP_FS_CACHE_MAX_PATH];
+    int found = 0;
+    g_rng = seed;
+    *hash = 0;
+    for (int d = 0; d < DIR_COUNT; ++d) {
+        snprintf(path, sizeof(path), "0:/%s.DAT", g_dirs[d]);
+        if (!sim_exists(path)) snprintf(path, sizeof(path), "0:/data/%s.DAT", g_dirs[d]);
+        outcome_t o = open_read(path);
+        found += o.ok;
+        *hash = *hash * 31 + o.hash;
+    }
+    for (int i = 0; i < lookups; ++i) {
+        int chain[4];
+        for (int k = 0; k < 4; ++k) chain[k] = (int)(rnd() % DIR_COUNT);
+        const int id = (int)(rnd() % MAX_ID);
+        for (int k = 0; k < 4; ++k) {
+            snprintf(path, sizeof(path), "0:/data/%s/res%d.png", g_dirs[chain[k]], id);
+            const outcome_t o = open_read(path);
+            *hash = *hash * 31 + o.hash;
+            if (o.ok) {
+                found++;
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+static void random_path(char *path, size_t size) {
+    const int d = (int)(rnd() % DIR_COUNT);
+    int id = (int)(rnd() % MAX_ID);
+    for (int tries = 0; tries < 20 && !g_has[d][id] && rnd() % 2; ++tries) id = (int)(rnd() % MAX_ID);
+    switch (rnd() % 16) {
+        case 0: snprintf(path, size, "0:/data/%s/RES%d.PNG", g_dirs[d], id); break;
+        case 1: snprintf(path, size, "0:/data/nope/res%d.png", id); break;
+        case 2: snprintf(path, size, "0:/data/%s.DAT/res%d.png", g_dirs[d], id); break;
+        case 3: snprintf(path, size, "0:/data/%s", g_dirs[d]); break;
+        case 4: snprintf(path, size, "0:/data/%s/../%s/res%d.png", g_dirs[d], g_dirs[d], id); break;
+        case 5: snprintf(path, size, "0:/data/%s/res%d.png.", g_dirs[d], id); break;
+        case 6: snprintf(path, size, "0:\\data\\%s\\res%d.png", g_dirs[d], id); break;
+        case 7: snprintf(path, size, "0:/data/%s/A LONG NAME FOR %s.BIN", g_dirs[d], g_dirs[d]); break;
+        case 8: snprintf(path, size, "0:/data/%s/ALONGN~1.BIN", g_dirs[d]); break;
+        case 9: snprintf(path, size, "0:/%s.DAT", g_dirs[d]); break;
+        case 10: snprintf(path, size, "0:/data/%s.dat", g_dirs[d]); break;
+        case 11: snprintf(path, size, "0:/data/music.ogg"); break;
+        case 12: snprintf(path, size, "0:/Some other file number %d.txt", id % 50); break;
+        case 13: snprintf(path, size, "0:/nope/%s/res%d.png", g_dirs[d], id); break;
+        default: snprintf(path, size, "0:/data/%s/res%d.png", g_dirs[d], id); break;
+    }
+}
+
+static int random_paths(int lookups, uint32_t slots) {
+    char path[POP_FS_CACHE_MAX_PATH];
+    pop_fs_cache_init(&g_cache, g_slots, slots);
+    for (int i = 0; i < lookups; ++i) {
+        random_path(path, sizeof(path));
+        if (check_path(path)) return 1;
+    }
+    return 0;
+}
+
+static int writes(void) {
+    char path[POP_FS_CACHE_MAX_PATH];
+    pop_fs_cache_init(&g_cache, g_slots, CACHE_SLOTS);
+    for (int i = 0; i < 200; ++i) {
+        const int d = (int)(rnd() % DIR_COUNT);
+        const int id = (int)(rnd() % MAX_ID);
+        snprintf(path, sizeof(path), "0:/data/%s/res%d.png", g_dirs[d], id);
+        if (check_path(path)) return 1;         // Fill the cache first
+        switch (rnd() % 4) {
+            case 0: {                           // Create or rewrite, as pop_fs_open("w") + pop_fs_write
+                FIL *fil = sim_open(path, FA_WRITE | FA_CREATE_ALWAYS);
+                if (!fil) return fail("create", path);
+                const uint32_t size = 1 + rnd() % 9000;
+                uint8_t buf[512];
+                for (uint32_t done = 0; done < size; done += sizeof(buf)) {
+                    UINT bw;
+                    memset(buf, (int)rnd(), sizeof(buf));
+                    pop_fs_cache_flush(&g_cache);
+                    f_write(fil, buf, size - done < sizeof(buf) ? size - done : (UINT)sizeof(buf), &bw);
+                }
+                sim_close(fil);
+                g_has[d][id] = true;
+                break;
+            }
+            case 1:                             // pop_fs_delete
+                pop_fs_cache_flush(&g_cache);
+                f_unlink(path);
+                g_has[d][id] = false;
+                break;
+            case 2:                             // pop_fs_mkdir, then a file in it
+                snprintf(path, sizeof(path), "0:/data/%s/new%d", g_dirs[d], id);
+                if (check_path(path)) return 1;
+                pop_fs_cache_flush(&g_cache);
+                f_mkdir(path);
+                strcat(path, "/file.bin");
+                if (check_path(path)) return 1;
+                pop_fs_cache_flush(&g_cache);
+                if (write_file(path, 100, 1)) return 1;
+                break;
+            default:
+                break;
+        }
+        if (check_path(path)) return 1;
+    }
+    return 0;
+}
+
+static int run_volume(const char *name, BYTE fmt, UINT au, int lookups, uint64_t seed) {
+    uint8_t work[FF_MAX_SS * 4];
+    const MKFS_PARM opt = {fmt, 0, 0, 0, au};
+    memset(g_disk, 0, (size_t)DISK_SECTORS * 512);
+    if (f_mkfs("0:", &opt, work, sizeof(work)) != FR_OK) return fail("f_mkfs", name);
+    if (f_mount(&g_fs, "0:", 1) != FR_OK) return fail("f_mount", name);
+    g_rng = seed;
+    if (build_tree()) return 1;
+
+    // Game load, plain and cached; remount in between so both start cold.
+    uint64_t plain_hash, cached_hash;
+    f_mount(NULL, "0:", 0);
+    f_mount(&g_fs, "0:", 1);
+    g_use_cache = false;
+    g_sectors_read = 0;
+    g_f_opens = 0;
+    const int plain_found = game_load(lookups, seed, &plain_hash);
+    const uint64_t plain_sectors = g_sectors_read;
+    const uint32_t plain_opens = g_f_opens;
+
+    f_mount(NULL, "0:", 0);
+    f_mount(&g_fs, "0:", 1);
+    pop_fs_cache_init(&g_cache, g_slots, CACHE_SLOTS);
+    g_use_cache = true;
+    g_sectors_read = 0;
+    g_f_opens = 0;
+    const int cached_found = game_load(lookups, seed, &cached_hash);
+    if (cached_found != plain_found || cached_hash != plain_hash) return fail("game load differs", name);
+
+    printf("%s: %d lookups, %d files found\n", name, lookups + DIR_COUNT, plain_found);
+    printf("  f_open: %llu sectors read, %u directory walks\n", (unsigned long long)plain_sectors, plain_opens);
+    printf("  cached: %llu sectors read, %u directory walks, %u reopened, %u answered missing, %u dirs listed\n",
+           (unsigned long long)g_sectors_read, g_f_opens, g_cache.hits, g_cache.misses, g_cache.lists);
+
+    if (random_paths(lookups, CACHE_SLOTS)) return 1;
+    if (random_paths(lookups, SMALL_SLOTS)) return 1;
+    printf("  random paths: %d with %d slots, %d with %d slots: same as f_open/f_stat\n", lookups, CACHE_SLOTS,
+           lookups, SMALL_SLOTS);
+    if (writes()) return 1;
+    printf("  writes: 200 creates/rewrites/deletes/mkdirs seen by the next lookup (%u flushes)\n", g_cache.flushes);
+    f_mount(NULL, "0:", 0);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const int lookups = argc > 1 ? atoi(argv[1]) : 4000;
+    const uint64_t seed = argc > 2 ? strtoull(argv[2], NULL, 0) : 1;
+    g_disk = (uint8_t *)malloc((size_t)DISK_SECTORS * 512);
+    if (!g_disk) return fail("host alloc", "");
+    if (run_volume("FAT32", FM_FAT32, 512, lookups, seed ? seed : 1)) return 1;
+    if (run_volume("exFAT", FM_EXFAT, 4096, lookups, seed ? seed : 1)) return 1;
+    free(g_disk);
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,294 @@
+/*
+ * psram_stress - host stress test for the PSRAM heap (drivers/psram_tlsf.h).
+ *
+ * Runs the TLSF heap over a malloc'd buffer the size of the device heap (8 MB PSRAM
+ * minus the scratch and temp areas) and checks that memory really comes back:
+ *
+ *  - level cycles: the game-lifetime allocations are made first, then every "level"
+ *    allocates sprite-sized surfaces (some freed and reallocated mid-level, some grown
+ *    with realloc the way stb_image does) under the session tag; restoring the session
+ *    must bring usage back to the baseline with the free space in one block again.
+ *    What the old bump allocator would have used per level is reported alongside,
+ *    followed by the per-category report ('m' on the device serial console) for the run.
+ *  - random churn: random malloc/free/realloc against a shadow table, run until the
+ *    heap is close to full; every block is filled with a per-block pattern that is
+ *    verified before it is freed, so any overlap between live blocks is caught. Heap
+ *    consistency is walked periodically and everything must coalesce back at the end.
+ *
+ * Build:
+ *   cc -O2 -Idrivers -o psram_stress tools/psram_stress.c
+ *
+ * Usage:
+ *   psram_stress [cycles] [churn_ops] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// The report needs the accounting the device build leaves off by default.
+#define MEM_TELEMETRY 1
+
+#include "psram_tlsf.h"
+#include "mem_telemetry.h"
+
+#define HEAP_SIZE (8u * 1024 * 1024 - 512u * 1024 - 512u * 1024)
+#define MAX_LIVE 4096
+
+static tlsf_t g_heap;
+static mem_tel_pool_t g_tel;
+static uint64_t g_rng = 0x9E3779B97F4A7C15ull;
+
+static uint32_t rnd(void) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return (uint32_t)g_rng;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Surface-like sizes: mostly small sprites, some full-screen buffers. The category is
+// what the device would tag such an allocation with.
+static size_t sprite_size_cat(mem_cat_t *cat) {
+    const uint32_t r = rnd() % 100;
+    mem_cat_t c;
+    size_t size;
+    if (r < 30) {
+        c = MEM_CAT_PALETTE, size = 16 + rnd() % 64;            // SDL_PixelFormat / palettes
+    } else if (r < 85) {
+        c = MEM_CAT_CHTAB, size = 256 + rnd() % 8192;           // Sprite pixels
+    } else if (r < 97) {
+        c = MEM_CAT_SURFACE, size = 8192 + rnd() % 65536;       // Large sprites, span tables
+    } else {
+        c = MEM_CAT_FILEBUF, size = 64000 + rnd() % 200000;     // Full-screen / RGBA decode
+    }
+    if (cat) *cat = c;
+    return size;
+}
+
+static size_t sprite_size(void) {
+    return sprite_size_cat(NULL);
+}
+
+typedef struct {
+    uint8_t *p;
+    size_t size;
+    uint8_t fill;
+    mem_cat_t cat;
+} live_t;
+
+// Heap bytes of a block, header included (what the device telemetry counts).
+static uint32_t block_bytes(const void *p) {
+    return tlsf_block_size(&g_heap, p) + TLSF_HDR;
+}
+
+static live_t g_live[MAX_LIVE];
+static int g_n_live;
+
+static void fill_block(live_t *b) {
+    memset(b->p, b->fill, b->size);
+}
+
+static bool check_block(const live_t *b) {
+    for (size_t i = 0; i < b->size; ++i) {
+        if (b->p[i] != b->fill) return false;
+    }
+    return true;
+}
+
+static int fail(const char *what) {
+    fprintf(stderr, "FAIL: %s\n", what);
+    return 1;
+}
+
+static void stress_tagged_freed(void *ctx, void *payload) {
+    (void)ctx;
+    for (int i = 0; i < g_n_live; ++i) {
+        if (g_live[i].p == payload) {
+            mem_tel_on_free(&g_tel, g_live[i].cat, block_bytes(payload));
+            g_live[i] = g_live[--g_n_live];
+            return;
+        }
+    }
+}
+
+static int run_level_cycles(int cycles) {
+    // Game-lifetime allocations before the session mark (fonts, palettes, tables).
+    for (int i = 0; i < 40; ++i) {
+        const mem_cat_t cat = (i < 30) ? MEM_CAT_SOUND : MEM_CAT_LEVEL;
+        void *p = tlsf_malloc(&g_heap, sprite_size(), false);
+        if (!p) return fail("perm alloc");
+        mem_tel_on_alloc(&g_tel, cat, block_bytes(p));
+    }
+    const uint32_t baseline = g_heap.used;
+    const tlsf_walk_t before = tlsf_walk(&g_heap);
+
+    uint64_t bump_max = 0;
+    int bump_oom_levels = 0;
+    uint32_t peak = 0;
+    for (int c = 0; c < cycles; ++c) {
+        uint64_t level_bytes = 0;
+        g_n_live = 0;
+        const int n = 150 + (int)(rnd() % 200);
+        for (int i = 0; i < n && g_n_live < MAX_LIVE; ++i) {
+            mem_cat_t cat;
+            const size_t size = sprite_size_cat(&cat);
+            uint8_t *p = tlsf_malloc(&g_heap, size, true);
+            if (!p) {
+                fprintf(stderr, "level %d: %u KB used, %zu requested\n", c, g_heap.used / 1024, size);
+                return fail("level alloc");
+            }
+            mem_tel_on_alloc(&g_tel, cat, block_bytes(p));
+            level_bytes += size + 4;
+            g_live[g_n_live++] = (live_t){ p, size, (uint8_t)(rnd() | 1), cat };
+            fill_block(&g_live[g_n_live - 1]);
+
+            // Peels, temporary decode buffers: freed and replaced within the level.
+            if (g_n_live > 8 && rnd() % 4 == 0) {
+                const int k = (int)(rnd() % (uint32_t)g_n_live);
+                if (!check_block(&g_live[k])) return fail("pattern overwritten");
+                mem_tel_on_free(&g_tel, g_live[k].cat, block_bytes(g_live[k].p));
+                tlsf_free(&g_heap, g_live[k].p);
+                g_live[k] = g_live[--g_n_live];
+            }
+            // stb_image-style growth.
+            if (rnd() % 16 == 0) {
+                live_t *b = &g_live[g_n_live - 1];
+                const size_t grow = b->size * 2;
+                const uint32_t old_bytes = block_bytes(b->p);
+                if (tlsf_grow_in_place(&g_heap, b->p, grow)) {
+                    mem_tel_on_resize(&g_tel, b->cat, old_bytes, block_bytes(b->p));
+                } else {
+                    uint8_t *q = tlsf_malloc(&g_heap, grow, true);
+                    if (!q) return fail("realloc");
+                    mem_tel_on_alloc(&g_tel, b->cat, block_bytes(q));
+                    memcpy(q, b->p, b->size);
+                    mem_tel_on_free(&g_tel, b->cat, old_bytes);
+                    tlsf_free(&g_heap, b->p);
+                    b->p = q;
+                }
+                memset(b->p + b->size, b->fill, grow - b->size);
+                b->size = grow;
+                level_bytes += grow + 4;
+            }
+        }
+        for (int i = 0; i < g_n_live; ++i) {
+            if (!check_block(&g_live[i])) return fail("pattern overwritten");
+        }
+        if (g_heap.used > peak) peak = g_heap.used;
+        if (g_tel.live != g_heap.used) return fail("category totals do not match heap usage");
+
+        // The session restore: the telemetry is told about each block it frees.
+        tlsf_free_tagged(&g_heap, stress_tagged_freed, NULL);
+        const tlsf_walk_t w = tlsf_walk(&g_heap);
+        if (!w.ok) return fail("heap walk after session restore");
+        if (g_heap.used != baseline) return fail("usage did not return to baseline");
+        if (w.free_blocks != before.free_blocks || w.largest_free != before.largest_free) {
+            return fail("free space not coalesced after session restore");
+        }
+
+        // The bump allocator only reclaimed on session restore, never within a level.
+        if (level_bytes > bump_max) bump_max = level_bytes;
+        bump_oom_levels += (level_bytes + baseline > HEAP_SIZE);
+    }
+
+    printf("level cycles: %d, baseline %u KB, peak %u KB, after restore %u KB, largest free %u KB\n", cycles,
+        baseline / 1024, peak / 1024, g_heap.used / 1024, before.largest_free / 1024);
+    printf("  bump allocator: up to %.1f MB per level, %d of %d levels would not have fit\n",
+        bump_max / (1024.0 * 1024.0), bump_oom_levels, cycles);
+    if (g_tel.live != g_heap.used) return fail("category totals do not match heap usage");
+    mem_tel_print_pool(&g_tel, "PSRAM heap", HEAP_SIZE, printf);
+    return 0;
+}
+
+static int run_churn(long ops) {
+    g_n_live = 0;
+    long mallocs = 0, frees = 0, reallocs = 0, in_place = 0, oom = 0;
+    uint32_t max_free_blocks = 0;
+    double t_alloc = 0, t_free = 0;
+    for (long i = 0; i < ops; ++i) {
+        const uint32_t r = rnd() % 100;
+        if ((r < 50 || g_n_live == 0) && g_n_live < MAX_LIVE) {
+            const size_t size = sprite_size();
+            const double t0 = now_ns();
+            uint8_t *p = tlsf_malloc(&g_heap, size, false);
+            t_alloc += now_ns() - t0;
+            if (!p) {
+                oom++;
+                continue;
+            }
+            mallocs++;
+            g_live[g_n_live] = (live_t){ p, size, (uint8_t)(rnd() | 1), MEM_CAT_OTHER };
+            fill_block(&g_live[g_n_live++]);
+        } else if (r < 90) {
+            const int k = (int)(rnd() % (uint32_t)g_n_live);
+            if (!check_block(&g_live[k])) return fail("pattern overwritten");
+            const double t0 = now_ns();
+            tlsf_free(&g_heap, g_live[k].p);
+            t_free += now_ns() - t0;
+            frees++;
+            g_live[k] = g_live[--g_n_live];
+        } else {
+            live_t *b = &g_live[rnd() % (uint32_t)g_n_live];
+            const size_t grow = b->size + 1 + rnd() % 4096;
+            reallocs++;
+            if (tlsf_grow_in_place(&g_heap, b->p, grow)) {
+                in_place++;
+            } else {
+                uint8_t *q = tlsf_malloc(&g_heap, grow, false);
+                if (!q) {
+                    oom++;
+                    continue;
+                }
+                memcpy(q, b->p, b->size);
+                tlsf_free(&g_heap, b->p);
+                b->p = q;
+            }
+            memset(b->p + b->size, b->fill, grow - b->size);
+            b->size = grow;
+        }
+        if ((i & 4095) == 0) {
+            const tlsf_walk_t w = tlsf_walk(&g_heap);
+            if (!w.ok) return fail("heap walk during churn");
+            if (w.free_blocks > max_free_blocks) max_free_blocks = w.free_blocks;
+        }
+    }
+    for (int i = 0; i < g_n_live; ++i) {
+        if (!check_block(&g_live[i])) return fail("pattern overwritten");
+        tlsf_free(&g_heap, g_live[i].p);
+    }
+    g_n_live = 0;
+    const tlsf_walk_t w = tlsf_walk(&g_heap);
+    if (!w.ok || g_heap.used != 0 || w.free_blocks != 1) return fail("heap not whole after freeing everything");
+
+    printf("churn: %ld ops, %ld malloc (%.0f ns avg), %ld free (%.0f ns avg), %ld realloc (%ld in place), "
+        "%ld OOM\n", ops, mallocs, mallocs ? t_alloc / mallocs : 0.0, frees, frees ? t_free / frees : 0.0,
+        reallocs, in_place, oom);
+    printf("  high water %u KB of %u KB, max free blocks %u, after freeing all: 1 free block of %u KB\n",
+        g_heap.high_water / 1024, HEAP_SIZE / 1024, max_free_blocks, w.largest_free / 1024);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const int cycles = argc > 1 ? atoi(argv[1]) : 200;
+    const long ops = argc > 2 ? atol(argv[2]) : 1000000;
+    if (argc > 3) g_rng = strtoull(argv[3], NULL, 0) | 1;
+
+    void *pool = aligned_alloc(8, HEAP_SIZE);
+    if (!pool) return fail("host alloc");
+
+    tlsf_init(&g_heap, pool, HEAP_SIZE);
+    if (run_level_cycles(cycles)) return 1;
+
+    tlsf_init(&g_heap, pool, HEAP_SIZE);
+    if (run_churn(ops)) return 1;
+
+    free(pool);
+    printf("OK\n");
+    return 0;
+}
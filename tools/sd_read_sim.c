@@ -0,0 +1,346 @@
+/*
+ * sd_read_sim - host test for the SD sector read state machine (drivers/sdcard/sd_read.h).
+ *
+ * Runs the exact CMD17/CMD18 read code sdcard.c uses against a mock card in SPI mode:
+ * the card answers commands, drives a random number of busy bytes before each data
+ * token, then 512 data bytes and a CRC16 trailer. The "DMA" receive completes a random
+ * number of polls after it is started, and the data only lands when it completes.
+ *
+ *  - random reads: single and multi-block reads at random sectors, on block- and
+ *    byte-addressed cards; data, CRC trailers, CMD12 and deselect are checked.
+ *  - faults: error tokens, a card that never sends a token, bit errors in the data
+ *    (caught by the CRC check) and out-of-range commands must end in the matching
+ *    error with the card stopped and deselected.
+ *  - protocol: the CPU must not touch the bus while a block transfer is in flight, and
+ *    no step may exchange more than SD_READ_TOKEN_POLLS bytes plus the CRC trailer and
+ *    a command.
+ *
+ * Reports how many bytes per sector the CPU still exchanges itself.
+ *
+ * Build:
+ *   cc -O2 -Idrivers/sdcard -o sd_read_sim tools/sd_read_sim.c
+ *
+ * Usage:
+ *   sd_read_sim [reads] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sd_read.h"
+
+#define CARD_SECTORS 4096
+
+enum { PH_IDLE, PH_WAIT, PH_DATA, PH_CRC };
+enum { FAULT_NONE, FAULT_ERROR_TOKEN, FAULT_NO_TOKEN, FAULT_BAD_CRC };
+
+typedef struct {
+    uint8_t *data;
+    bool block_addr;
+
+    // Stream state after a read command
+    int phase;
+    uint32_t sector;
+    int pos;
+    int wait;
+    bool multi;
+    int fault;
+    uint32_t fault_block;    // Blocks into the read at which the fault hits
+    uint32_t block;
+
+    // Bus state
+    bool selected;
+    uint8_t *dma_dst;
+    uint32_t dma_len;
+    int dma_polls;
+
+    // Counters
+    uint64_t ticks;          // Bytes exchanged in total (the mock's clock)
+    uint64_t cpu_bytes;
+    uint64_t dma_bytes;
+    uint32_t cmd12;
+    uint32_t deselects;
+    uint32_t violations;
+    uint32_t step_bytes;     // Bytes exchanged in the current step
+} mock_card_t;
+
+static mock_card_t g_card;
+static uint64_t g_rng = 0x2545F4914F6CDD1Dull;
+
+static uint32_t rnd(void) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return (uint32_t)g_rng;
+}
+
+// Bit-serial reference for the card's CRC16 (x^16 + x^12 + x^5 + 1).
+static uint16_t ref_crc16(const uint8_t *p, uint32_t len) {
+    uint16_t crc = 0;
+    for (uint32_t i = 0; i < len; ++i) {
+        for (int b = 7; b >= 0; --b) {
+            const int in = ((p[i] >> b) & 1) ^ (crc >> 15);
+            crc = (uint16_t)(crc << 1);
+            if (in) crc ^= 0x1021;
+        }
+    }
+    return crc;
+}
+
+static void violation(const char *what) {
+    if (g_card.violations++ < 5) fprintf(stderr, "protocol violation: %s\n", what);
+}
+
+// Next byte the card drives on MISO.
+static uint8_t card_byte(mock_card_t *c) {
+    c->ticks++;
+    switch (c->phase) {
+    case PH_WAIT:
+        if (c->wait > 0) {
+            c->wait--;
+            return 0xFF;
+        }
+        if ((c->fault == FAULT_ERROR_TOKEN || c->fault == FAULT_NO_TOKEN) && c->block == c->fault_block) {
+            c->phase = PH_IDLE;
+            return c->fault == FAULT_ERROR_TOKEN ? 0x08 : 0xFF;  // 0x08: out of range
+        }
+        c->phase = PH_DATA;
+        c->pos = 0;
+        return SD_READ_TOKEN_START;
+    case PH_DATA: {
+        uint8_t b = c->data[c->sector * SD_READ_BLOCK + (uint32_t)c->pos++];
+        if (c->fault == FAULT_BAD_CRC && c->block == c->fault_block && c->pos == 100) b ^= 0x10;  // Bit error
+
+        if (c->pos == SD_READ_BLOCK) c->phase = PH_CRC, c->pos = 0;
+        return b;
+    }
+    case PH_CRC: {
+        const uint16_t crc = ref_crc16(&c->data[c->sector * SD_READ_BLOCK], SD_READ_BLOCK);
+        if (c->pos++ == 0) return (uint8_t)(crc >> 8);
+        c->block++;
+        if (!c->multi) {
+            c->phase = PH_IDLE;
+        } else if (c->sector + 1 < CARD_SECTORS) {
+            c->sector++;
+            c->phase = PH_WAIT;
+            c->wait = (int)(rnd() % 40);
+        } else {
+            c->phase = PH_WAIT;                                   // Past the end
+            c->fault = FAULT_ERROR_TOKEN;
+            c->fault_block = c->block;
+        }
+        return (uint8_t)crc;
+    }
+    default:
+        return 0xFF;
+    }
+}
+
+static uint8_t io_send_cmd(void *ctx, uint8_t cmd, uint32_t arg) {
+    mock_card_t *c = ctx;
+    if (c->dma_polls >= 0) violation("command during block transfer");
+    c->step_bytes += 6;
+    c->cpu_bytes += 6;
+    c->ticks += 6;
+    c->selected = true;
+    if (cmd == SD_READ_CMD12) {
+        c->cmd12++;
+        c->phase = PH_IDLE;
+        return 0;
+    }
+    if (cmd != SD_READ_CMD17 && cmd != SD_READ_CMD18) return 0x04;  // Illegal command
+    if (!c->block_addr && (arg % SD_READ_BLOCK)) return 0x40;       // Parameter error
+    const uint32_t sector = c->block_addr ? arg : arg / SD_READ_BLOCK;
+    if (sector >= CARD_SECTORS) return 0x40;
+    c->sector = sector;
+    c->multi = (cmd == SD_READ_CMD18);
+    c->block = 0;
+    c->phase = PH_WAIT;
+    c->wait = (int)(rnd() % 200);
+    return 0;
+}
+
+static uint8_t io_xchg(void *ctx, uint8_t byte) {
+    mock_card_t *c = ctx;
+    (void)byte;
+    if (!c->selected) violation("exchange while deselected");
+    if (c->dma_polls >= 0) violation("CPU exchange during block transfer");
+    c->step_bytes++;
+    c->cpu_bytes++;
+    return card_byte(c);
+}
+
+static void io_rx_start(void *ctx, uint8_t *dst, uint32_t len) {
+    mock_card_t *c = ctx;
+    if (c->phase != PH_DATA || c->pos != 0) violation("block transfer started without a data token");
+    if (c->dma_polls >= 0) violation("block transfer started twice");
+    c->dma_dst = dst;
+    c->dma_len = len;
+    c->dma_polls = (int)(rnd() % 6);
+}
+
+static bool io_rx_busy(void *ctx) {
+    mock_card_t *c = ctx;
+    if (c->dma_polls < 0) {
+        violation("polled with no block transfer");
+        return false;
+    }
+    if (c->dma_polls-- > 0) return true;
+    for (uint32_t i = 0; i < c->dma_len; ++i) c->dma_dst[i] = card_byte(c);
+    c->dma_bytes += c->dma_len;
+    c->dma_polls = -1;
+    return false;
+}
+
+static void io_deselect(void *ctx) {
+    mock_card_t *c = ctx;
+    c->selected = false;
+    c->deselects++;
+}
+
+static uint32_t io_millis(void *ctx) {
+    return (uint32_t)(((mock_card_t *)ctx)->ticks / 64);  // ~512 kB/s at 64 bytes per ms
+}
+
+static const sd_read_io_t g_io = {
+    .ctx = &g_card,
+    .send_cmd = io_send_cmd,
+    .xchg = io_xchg,
+    .rx_start = io_rx_start,
+    .rx_busy = io_rx_busy,
+    .deselect = io_deselect,
+    .millis = io_millis,
+};
+
+static uint8_t g_buf[128 * SD_READ_BLOCK];
+static uint32_t g_max_step_bytes;
+static uint64_t g_steps;
+
+// Runs one read to completion the way disk_read() does.
+static sd_read_t run_read(uint32_t sector, uint32_t count, bool check_crc) {
+    sd_read_t r;
+    const uint32_t addr = g_card.block_addr ? sector : sector * SD_READ_BLOCK;
+    g_card.step_bytes = 0;
+    sd_read_start(&r, &g_io, g_buf, addr, count, check_crc);
+    for (;;) {
+        if (g_card.step_bytes > g_max_step_bytes) g_max_step_bytes = g_card.step_bytes;
+        g_card.step_bytes = 0;
+        if (sd_read_step(&r) != SD_READ_BUSY) break;
+        g_steps++;
+    }
+    if (g_card.step_bytes > g_max_step_bytes) g_max_step_bytes = g_card.step_bytes;
+    return r;
+}
+
+static int fail(const char *what, uint32_t sector, uint32_t count) {
+    fprintf(stderr, "FAIL: %s (sector %u, count %u)\n", what, sector, count);
+    return 1;
+}
+
+static int check_end(uint32_t cmd12_before, uint32_t deselects_before, bool stopped,
+                     uint32_t sector, uint32_t count) {
+    if (g_card.deselects != deselects_before + 1 || g_card.selected) return fail("card not deselected once", sector, count);
+    if (g_card.cmd12 != cmd12_before + (stopped ? 1u : 0u)) return fail("CMD12 mismatch", sector, count);
+    if (g_card.dma_polls >= 0) return fail("block transfer left running", sector, count);
+    return 0;
+}
+
+static int run_reads(int reads, bool block_addr, uint64_t *sectors_read) {
+    g_card.block_addr = block_addr;
+    for (int i = 0; i < reads; ++i) {
+        const uint32_t count = (rnd() % 4 == 0) ? 1 : 1 + rnd() % 128;
+        const uint32_t sector = rnd() % (CARD_SECTORS - count + 1);
+        const uint32_t cmd12 = g_card.cmd12, desel = g_card.deselects;
+        g_card.fault = FAULT_NONE;
+
+        const sd_read_t r = run_read(sector, count, (i & 1) != 0);
+        if (r.status != SD_READ_OK) return fail("read failed", sector, count);
+        if (memcmp(g_buf, &g_card.data[sector * SD_READ_BLOCK], count * SD_READ_BLOCK) != 0) {
+            return fail("data mismatch", sector, count);
+        }
+        const uint8_t *last = &g_buf[(count - 1) * SD_READ_BLOCK];
+        if (r.crc != sd_crc16(last, SD_READ_BLOCK) || r.crc != ref_crc16(last, SD_READ_BLOCK)) {
+            return fail("CRC trailer mismatch", sector, count);
+        }
+        if (check_end(cmd12, desel, count > 1, sector, count)) return 1;
+        *sectors_read += count;
+    }
+    return 0;
+}
+
+static int run_faults(int reads) {
+    g_card.block_addr = true;
+    int tokens = 0, timeouts = 0, cmds = 0, crcs = 0;
+    for (int i = 0; i < reads; ++i) {
+        const int kind = (int)(rnd() % 4);
+        uint32_t count = 1 + rnd() % 16;
+        uint32_t sector = rnd() % (CARD_SECTORS - count + 1);
+        const uint32_t cmd12 = g_card.cmd12, desel = g_card.deselects;
+        sd_read_err_t want;
+        bool stopped = count > 1;
+        if (kind == 0) {
+            g_card.fault = FAULT_ERROR_TOKEN;
+            g_card.fault_block = rnd() % count;
+            want = SD_READ_ERR_TOKEN;
+            tokens++;
+        } else if (kind == 1) {
+            g_card.fault = FAULT_NO_TOKEN;
+            g_card.fault_block = rnd() % count;
+            want = SD_READ_ERR_TIMEOUT;
+            timeouts++;
+        } else if (kind == 2) {
+            g_card.fault = FAULT_BAD_CRC;
+            g_card.fault_block = rnd() % count;
+            want = SD_READ_ERR_CRC;
+            crcs++;
+        } else {
+            g_card.fault = FAULT_NONE;
+            sector = CARD_SECTORS + rnd() % 100;
+            want = SD_READ_ERR_CMD;
+            stopped = false;
+            cmds++;
+        }
+        const sd_read_t r = run_read(sector, count, true);
+        if (r.status != SD_READ_ERROR || r.err != want) return fail("wrong fault outcome", sector, count);
+        if (check_end(cmd12, desel, stopped, sector, count)) return 1;
+    }
+    // A multi-block read running off the end of the card gets the card's error token.
+    g_card.fault = FAULT_NONE;
+    const sd_read_t r = run_read(CARD_SECTORS - 2, 4, true);
+    if (r.status != SD_READ_ERROR || r.err != SD_READ_ERR_TOKEN) return fail("read past end", CARD_SECTORS - 2, 4);
+    if (memcmp(g_buf, &g_card.data[(CARD_SECTORS - 2) * SD_READ_BLOCK], 2 * SD_READ_BLOCK) != 0) {
+        return fail("data before the end", CARD_SECTORS - 2, 4);
+    }
+    printf("faults: %d error tokens, %d token timeouts, %d CRC errors, %d rejected commands: all reported and "
+        "stopped\n", tokens, timeouts, crcs, cmds);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const int reads = argc > 1 ? atoi(argv[1]) : 2000;
+    if (argc > 2) g_rng = strtoull(argv[2], NULL, 0) | 1;
+
+    g_card.data = malloc(CARD_SECTORS * SD_READ_BLOCK);
+    if (!g_card.data) return fail("host alloc", 0, 0);
+    for (uint32_t i = 0; i < CARD_SECTORS * SD_READ_BLOCK; ++i) g_card.data[i] = (uint8_t)rnd();
+    g_card.dma_polls = -1;
+
+    uint64_t sectors = 0;
+    if (run_reads(reads, true, &sectors)) return 1;
+    if (run_reads(reads / 4, false, &sectors)) return 1;
+    const uint64_t cpu = g_card.cpu_bytes, dma = g_card.dma_bytes, steps = g_steps;
+    printf("reads: %d block-addressed, %d byte-addressed, %llu sectors in %llu steps\n", reads, reads / 4,
+        (unsigned long long)sectors, (unsigned long long)steps);
+    printf("  per sector: %.1f bytes exchanged by the CPU (command, token wait, CRC), %.0f by DMA\n",
+        (double)cpu / (double)sectors, (double)dma / (double)sectors);
+
+    if (run_faults(reads / 2)) return 1;
+    printf("  longest step: %u bytes exchanged (limit %d)\n", g_max_step_bytes, SD_READ_TOKEN_POLLS + 2 + 6);
+
+    free(g_card.data);
+    if (g_card.violations) return fail("protocol violations", 0, g_card.violations);
+    if (g_max_step_bytes > SD_READ_TOKEN_POLLS + 2 + 6) return fail("step exchanged too many bytes", 0, 0);
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,397 @@
+/*
+ * sprite_pack - builds the prepacked sprite archive (src/sprite_pack.h) from a data tree.
+ *
+ * Every data/<DIR>/res<N>.png is decoded and converted to 8bpp exactly as load_image()
+ * does on the device: the same stb_image decode, the same premultiplied-alpha fix-up as
+ * IMG_Load_RW (RP_SDL_STBI_UNPREMULTIPLY_ALPHA_MODE), alpha < 128 -> index 0, fonts
+ * (palette n_colors == 0) by brightness, everything else the nearest of entries 1..15
+ * through the same inverse colormap. The palette of an image is the closest res<B>.pal
+ * below it in its own directory; directories without one (GUARD, whose palettes come
+ * from GUARD1.DAT / GUARD2.DAT) are converted once for each closest .pal of the other
+ * directories. Pixels are run-length coded; every entry is then looked up and unpacked
+ * again the way the device does and compared with the conversion.
+ *
+ * Re-run it whenever a PNG or palette in the data tree changes: the device trusts the
+ * archive for every resource it lists.
+ *
+ * Build:
+ *   cc -O2 -iquote src -Isrc/third_party/stb -o sprite_pack tools/sprite_pack.c -lm
+ *
+ * Usage:
+ *   sprite_pack [-u unpremultiply_mode] data data/SPRITES.PAK
+ */
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#include "stb_image.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "inverse_cmap.h"
+#include "sprite_pack.h"
+
+#define MAX_PALS 256
+#define MAX_DIRS 64
+#define MAX_ENTRIES 8192
+#define MAX_PATH 1024
+
+typedef struct {
+    char dir[SPRITE_PACK_DIR_LEN];
+    int base;
+    bool font;
+    uint8_t vga[48];
+    uint32_t hash;
+} pal_t;
+
+typedef struct {
+    sprite_pack_entry_t e;
+    uint8_t *pixels;                // width * height indices
+    uint8_t *data;                  // What goes into the archive
+} item_t;
+
+static pal_t g_pals[MAX_PALS];
+static int g_pal_count;
+static item_t g_items[MAX_ENTRIES];
+static int g_item_count;
+static int g_unpremultiply = 1;
+static invcmap_t g_map;
+
+// Both mirror IMG_Load_RW in src/SDL_port.c.
+static void unpremultiply_rgba(uint8_t *rgba, size_t pixel_count) {
+    for (size_t i = 0; i < pixel_count; ++i) {
+        uint8_t *p = rgba + i * 4u;
+        const unsigned a = p[3];
+        if (a == 0u || a == 255u) continue;
+        for (int c = 0; c < 3; ++c) {
+            unsigned v = ((unsigned)p[c] * 255u + (a / 2u)) / a;
+            p[c] = (uint8_t)(v > 255u ? 255u : v);
+        }
+    }
+}
+
+static bool should_unpremultiply_rgba(const uint8_t *rgba, size_t pixel_count) {
+    const size_t max_samples = 2048u;
+    const size_t step = (pixel_count > max_samples) ? (pixel_count / max_samples) : 1u;
+    unsigned semi = 0, premul_like = 0;
+    for (size_t i = 0; i < pixel_count; i += step) {
+        const uint8_t *p = rgba + i * 4u;
+        const unsigned a = p[3];
+        if (a == 0u || a == 255u) continue;
+        ++semi;
+        if (p[0] <= a && p[1] <= a && p[2] <= a) ++premul_like;
+        if (semi >= 256u) break;
+    }
+    if (semi < 32u) return false;
+    return (premul_like * 100u) >= (semi * 95u);
+}
+
+static bool parse_res_name(const char *name, const char *ext, int *id) {
+    char suffix[8];
+    int n = 0;
+    if (sscanf(name, "res%d.%7s%n", id, suffix, &n) != 2 || name[n] != '\0') return false;
+    return strcmp(suffix, ext) == 0 && *id >= 0 && *id <= 0xFFFF;
+}
+
+static bool is_dir(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static void load_palettes(const char *root, const char *dir) {
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), "%s/%s", root, dir);
+    DIR *d = opendir(path);
+    if (!d) return;
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL) {
+        int id;
+        if (!parse_res_name(de->d_name, "pal", &id)) continue;
+        if (g_pal_count == MAX_PALS) {
+            fprintf(stderr, "too many palettes\n");
+            exit(1);
+        }
+        snprintf(path, sizeof(path), "%s/%s/%s", root, dir, de->d_name);
+        // dat_shpl_type: n_images, row_bits (2), n_colors, vga[16] (6-bit RGB).
+        uint8_t shpl[100];
+        FILE *f = fopen(path, "rb");
+        if (!f || fread(shpl, 1, sizeof(shpl), f) < 4 + 48) {
+            fprintf(stderr, "%s: not a SDLPoP palette, skipped\n", path);
+            if (f) fclose(f);
+            continue;
+        }
+        fclose(f);
+        pal_t *p = &g_pals[g_pal_count++];
+        sprite_pack_dir_key(p->dir, dir);
+        p->base = id;
+        p->font = (shpl[3] == 0);
+        memcpy(p->vga, &shpl[4], 48);
+        p->hash = sprite_pack_pal_hash(p->vga, p->font);
+    }
+    closedir(d);
+}
+
+// The palettes `id` in `dir` can be loaded with (see the header comment); returns the count.
+static int palettes_for(const char *dir, int id, const pal_t **out) {
+    int best = -1;
+    for (int own = 1; own >= 0 && best < 0; --own) {
+        for (int i = 0; i < g_pal_count; ++i) {
+            const bool same = memcmp(g_pals[i].dir, dir, SPRITE_PACK_DIR_LEN) == 0;
+            if (same == (own != 0) && g_pals[i].base < id && g_pals[i].base > best) best = g_pals[i].base;
+        }
+        if (best < 0) continue;
+        int n = 0;
+        for (int i = 0; i < g_pal_count; ++i) {
+            const bool same = memcmp(g_pals[i].dir, dir, SPRITE_PACK_DIR_LEN) == 0;
+            if (same != (own != 0) || g_pals[i].base != best) continue;
+            bool dup = false;
+            for (int k = 0; k < n; ++k) dup |= (out[k]->hash == g_pals[i].hash);
+            if (!dup) out[n++] = &g_pals[i];
+        }
+        return n;
+    }
+    return 0;
+}
+
+static uint8_t *convert(const uint8_t *rgba, int n, const pal_t *pal) {
+    uint8_t colors[16 * 4];
+    for (int i = 0; i < 16; ++i) {
+        colors[i * 4 + 0] = (uint8_t)(pal->vga[i * 3 + 0] << 2);
+        colors[i * 4 + 1] = (uint8_t)(pal->vga[i * 3 + 1] << 2);
+        colors[i * 4 + 2] = (uint8_t)(pal->vga[i * 3 + 2] << 2);
+        colors[i * 4 + 3] = (i == 0) ? 0 : 255;
+    }
+    // The map is bound as on the device.
+    invcmap_bind(&g_map, pal, 0, colors, 1, 15, false);
+
+    uint8_t *out = malloc((size_t)n);
+    if (!out) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (int i = 0; i < n; ++i) {
+        const uint8_t *p = &rgba[i * 4];
+        if (p[3] < 128) {
+            out[i] = 0;
+        } else if (pal->font) {
+            out[i] = ((int)p[0] + (int)p[1] + (int)p[2] > 384) ? 1 : 0;
+        } else {
+            out[i] = invcmap_lookup(&g_map, colors, p[0], p[1], p[2]);
+        }
+    }
+    return out;
+}
+
+// PackBits: runs of 2..129 equal bytes, literals of 1..128 bytes (see sprite_pack.h).
+static uint32_t rle_encode(uint8_t *out, const uint8_t *in, uint32_t n) {
+    uint32_t o = 0, i = 0;
+    while (i < n) {
+        uint32_t run = 1;
+        while (i + run < n && run < 129 && in[i + run] == in[i]) ++run;
+        if (run >= 2) {
+            out[o++] = (uint8_t)(run + 126);
+            out[o++] = in[i];
+            i += run;
+            continue;
+        }
+        uint32_t lit = 1;
+        while (i + lit < n && lit < 128 && !(i + lit + 1 < n && in[i + lit] == in[i + lit + 1])) ++lit;
+        out[o++] = (uint8_t)(lit - 1);
+        memcpy(out + o, in + i, lit);
+        o += lit;
+        i += lit;
+    }
+    return o;
+}
+
+static void encode(item_t *it) {
+    const uint32_t n = (uint32_t)it->e.width * it->e.height;
+    it->data = malloc(2 * (size_t)n + 2);     // Alternating 1-byte literals and 2-byte runs: 4/3
+    if (!it->data) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    it->e.size = rle_encode(it->data, it->pixels, n);
+    if (it->e.size >= n) {
+        memcpy(it->data, it->pixels, n);
+        it->e.size = n;
+        it->e.flags |= SPRITE_PACK_RAW;
+    }
+}
+
+static void pack_dir(const char *root, const char *dir, long *png_bytes) {
+    char key[SPRITE_PACK_DIR_LEN];
+    if (!sprite_pack_dir_key(key, dir)) return;
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), "%s/%s", root, dir);
+    DIR *d = opendir(path);
+    if (!d) return;
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL) {
+        int id;
+        if (!parse_res_name(de->d_name, "png", &id)) continue;
+        snprintf(path, sizeof(path), "%s/%s/%s", root, dir, de->d_name);
+
+        const pal_t *pals[MAX_PALS];
+        const int n_pals = palettes_for(key, id, pals);
+        if (n_pals == 0) {
+            fprintf(stderr, "%s: no palette, left out\n", path);
+            continue;
+        }
+        int w = 0, h = 0, comp = 0;
+        uint8_t *rgba = stbi_load(path, &w, &h, &comp, 4);
+        if (!rgba) {
+            fprintf(stderr, "%s: %s, left out\n", path, stbi_failure_reason());
+            continue;
+        }
+        if (w > 0xFFFF || h > 0xFFFF) {
+            fprintf(stderr, "%s: %dx%d too large, left out\n", path, w, h);
+            stbi_image_free(rgba);
+            continue;
+        }
+        struct stat st;
+        if (stat(path, &st) == 0) *png_bytes += (long)st.st_size;
+
+        const size_t n = (size_t)w * (size_t)h;
+        if (g_unpremultiply == 2 || (g_unpremultiply == 1 && should_unpremultiply_rgba(rgba, n))) {
+            unpremultiply_rgba(rgba, n);
+        }
+        for (int p = 0; p < n_pals; ++p) {
+            if (g_item_count == MAX_ENTRIES) {
+                fprintf(stderr, "too many images\n");
+                exit(1);
+            }
+            item_t *it = &g_items[g_item_count++];
+            memset(&it->e, 0, sizeof(it->e));
+            memcpy(it->e.dir, key, SPRITE_PACK_DIR_LEN);
+            it->e.id = (uint16_t)id;
+            it->e.width = (uint16_t)w;
+            it->e.height = (uint16_t)h;
+            it->e.flags = pals[p]->font ? SPRITE_PACK_FONT : 0;
+            it->e.pal_hash = pals[p]->hash;
+            it->pixels = convert(rgba, (int)n, pals[p]);
+            encode(it);
+        }
+        stbi_image_free(rgba);
+    }
+    closedir(d);
+}
+
+static int compare_items(const void *a, const void *b) {
+    const sprite_pack_entry_t *ea = &((const item_t *)a)->e;
+    const sprite_pack_entry_t *eb = &((const item_t *)b)->e;
+    const int c = sprite_pack_compare(ea->dir, ea->id, eb->dir, eb->id);
+    if (c != 0) return c;
+    return (ea->pal_hash > eb->pal_hash) - (ea->pal_hash < eb->pal_hash);
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+int main(int argc, char *argv[]) {
+    int a = 1;
+    if (a + 1 < argc && strcmp(argv[a], "-u") == 0) {
+        g_unpremultiply = atoi(argv[a + 1]);
+        a += 2;
+    }
+    if (argc - a != 2 || g_unpremultiply < 0 || g_unpremultiply > 2) {
+        fprintf(stderr, "usage: sprite_pack [-u unpremultiply_mode] data_dir output.pak\n");
+        return 2;
+    }
+    const char *root = argv[a];
+    const char *out_path = argv[a + 1];
+
+    // Sorted, so the archive is the same on every host.
+    char *dirs[MAX_DIRS];
+    int n_dirs = 0;
+    DIR *d = opendir(root);
+    if (!d) {
+        perror(root);
+        return 1;
+    }
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL && n_dirs < MAX_DIRS) {
+        char path[MAX_PATH];
+        snprintf(path, sizeof(path), "%s/%s", root, de->d_name);
+        if (de->d_name[0] != '.' && is_dir(path)) dirs[n_dirs++] = strdup(de->d_name);
+    }
+    closedir(d);
+    qsort(dirs, (size_t)n_dirs, sizeof(dirs[0]), compare_names);
+
+    for (int i = 0; i < n_dirs; ++i) load_palettes(root, dirs[i]);
+    long png_bytes = 0;
+    for (int i = 0; i < n_dirs; ++i) pack_dir(root, dirs[i], &png_bytes);
+    qsort(g_items, (size_t)g_item_count, sizeof(g_items[0]), compare_items);
+
+    sprite_pack_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SPRITE_PACK_MAGIC, 4);
+    header.version = SPRITE_PACK_VERSION;
+    header.entry_size = sizeof(sprite_pack_entry_t);
+    header.count = (uint32_t)g_item_count;
+    header.unpremultiply = (uint8_t)g_unpremultiply;
+    const uint32_t index_end = (uint32_t)(sizeof(header) + (size_t)g_item_count * sizeof(sprite_pack_entry_t));
+    header.data_offset = (index_end + SPRITE_PACK_ALIGN - 1) & ~(uint32_t)(SPRITE_PACK_ALIGN - 1);
+
+    // Entries sharing a palette are contiguous in id order, so a sprite table is one
+    // sequential run through the file.
+    uint32_t offset = header.data_offset;
+    static sprite_pack_entry_t index[MAX_ENTRIES];
+    for (int i = 0; i < g_item_count; ++i) {
+        g_items[i].e.offset = offset;
+        offset += g_items[i].e.size;
+        index[i] = g_items[i].e;
+    }
+
+    // Every entry must be found and unpacked again the way load_image() does it.
+    long raw_bytes = 0;
+    for (int i = 0; i < g_item_count; ++i) {
+        const int first = sprite_pack_find(index, header.count, index[i].dir, index[i].id);
+        if (first < 0 || sprite_pack_match(index, header.count, first, index[i].pal_hash) != &index[i]) {
+            fprintf(stderr, "index lookup failed for %.12s/res%u\n", index[i].dir, index[i].id);
+            return 1;
+        }
+        const uint32_t n = (uint32_t)index[i].width * index[i].height;
+        uint8_t *check = malloc(n + 1);
+        if (!check || !sprite_pack_unpack(check, n, g_items[i].data, index[i].size, index[i].flags) ||
+            memcmp(check, g_items[i].pixels, n) != 0) {
+            fprintf(stderr, "round trip failed for %.12s/res%u\n", index[i].dir, index[i].id);
+            return 1;
+        }
+        free(check);
+        raw_bytes += (long)n;
+    }
+
+    FILE *out = fopen(out_path, "wb");
+    if (!out) {
+        perror(out_path);
+        return 1;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    if (g_item_count > 0) ok &= fwrite(index, sizeof(index[0]), (size_t)g_item_count, out) == (size_t)g_item_count;
+    for (uint32_t pos = index_end; pos < header.data_offset; ++pos) ok &= fputc(0, out) != EOF;
+    for (int i = 0; i < g_item_count; ++i) {
+        const size_t n = g_items[i].e.size;
+        if (n > 0) ok &= fwrite(g_items[i].data, 1, n, out) == n;
+        free(g_items[i].pixels);
+        free(g_items[i].data);
+    }
+    ok &= fclose(out) == 0;
+    if (!ok) {
+        fprintf(stderr, "%s: write failed\n", out_path);
+        return 1;
+    }
+
+    int images = 0;
+    for (int i = 0; i < g_item_count; ++i) {
+        images += (i == 0 || sprite_pack_compare(index[i].dir, index[i].id, index[i - 1].dir, index[i - 1].id) != 0);
+    }
+    printf("%d image(s), %d entr%s from %d palette(s): %ld bytes of PNG -> %ld bytes 8bpp -> %lu bytes packed\n",
+        images, g_item_count, g_item_count == 1 ? "y" : "ies", g_pal_count, png_bytes, raw_bytes,
+        (unsigned long)offset);
+    for (int i = 0; i < n_dirs; ++i) free(dirs[i]);
+    return 0;
+}